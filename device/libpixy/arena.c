@@ -0,0 +1,11 @@
+#include "arena.h"
+
+void ar_init(struct Arena *arena, uint8_t *memory, uint32_t size)
+{
+	// align the start, the sizes are rounded up
+	arena->base = (uint8_t *)(((uintptr_t)memory + AR_ALIGN-1)&~(uintptr_t)(AR_ALIGN-1));
+	arena->end = memory + size;
+	arena->next = arena->base;
+	arena->high = arena->base;
+	arena->failures = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory for things that only live for a frame, from a fixed region instead of the heap.
+// Allocating moves a pointer up, nothing is freed on its own, and ar_reset frees
+// everything at once at the start of the next frame.  So allocating costs a compare and
+// an add, the heap isn't fragmented, and a frame can never use more than the region.
+// An allocation that doesn't fit returns NULL and is counted.
+//
+// high is the most that's been in use at once since ar_init (or the caller last set it
+// to base), so the region can be sized from what frames actually use.
+
+#define AR_ALIGN            8 // for long long
+
+struct Arena
+{
+	uint8_t *base;
+	uint8_t *end;
+	uint8_t *next;
+	uint8_t *high;
+	uint32_t failures;
+};
+
+void ar_init(struct Arena *arena, uint8_t *memory, uint32_t size);
+
+static __inline void ar_reset(struct Arena *arena)
+{
+	arena->next = arena->base;
+}
+
+static __inline void *ar_alloc(struct Arena *arena, uint32_t size)
+{
+	uint8_t *p = arena->next;
+
+	size = (size + AR_ALIGN-1)&~(AR_ALIGN-1);
+	if (size>(uint32_t)(arena->end - p))
+	{
+		arena->failures++;
+		return NULL;
+	}
+	arena->next = p + size;
+	if (arena->next>arena->high)
+		arena->high = arena->next;
+	return p;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -424,10 +424,24 @@ uint32_t cam_getLightMode(Chirp *chirp)
 	return g_lightMode;
 }
 
-int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth)
+static ClaimCallback g_claimCallback = NULL;
+
+void cam_setClaimCallback(ClaimCallback callback)
+{
+	g_claimCallback = callback;
+}
+
+void cam_claim(void)
+{
+	if (g_claimCallback)
+		(*g_claimCallback)();
+}
+
+int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth, uint32_t *time)
 {
 	int32_t res;
 	int32_t responseInt = -1;
+	uint32_t frameTime = 0;
 
 	if (xWidth*yWidth>memSize)
 		return -2;
@@ -452,30 +466,36 @@ int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t x
 	else
 		return -3;
 
+	cam_claim();
 	// check mode, set if necessary
 	if ((res=cam_setMode(type&0x0f))<0)
 		return res;
 
 	// forward call to M0, get frame
 	g_chirpM0->callSync(g_getFrameM0, 
-		UINT8(type), UINT32((uint32_t)memory), UINT16(xOffset), UINT16(yOffset), UINT16(xWidth), UINT16(yWidth), END_OUT_ARGS,
-		&responseInt, END_IN_ARGS);
+		UINT8(type), UINT32((uint32_t)(uintptr_t)memory), UINT16(xOffset), UINT16(yOffset), UINT16(xWidth), UINT16(yWidth), END_OUT_ARGS,
+		&responseInt, &frameTime, END_IN_ARGS);
 
+	if (time)
+		*time = frameTime;
 	return responseInt;
 }
 
 int32_t cam_getFrameChirp(const uint8_t &type, const uint16_t &xOffset, const uint16_t &yOffset, const uint16_t &xWidth, const uint16_t &yWidth, Chirp *chirp)
 {
 	int32_t result, prebuf;
+	uint32_t time;
 	uint8_t *frame = (uint8_t *)SRAM0_LOC;
 
+	cam_claim();
 	// force an error to get prebuf length
-	CRP_RETURN(chirp, USE_BUFFER(SRAM0_SIZE, frame), HTYPE(0), UINT16(0), UINT16(0), UINTS8(0, 0), END);
+	CRP_RETURN(chirp, USE_BUFFER(SRAM0_SIZE, frame), HTYPE(0), UINT16(0), UINT16(0), UINTS8(0, 0), UINT32(0), END);
 	prebuf = chirp->getPreBufLen();
 
-	if ((result=cam_getFrame(frame+prebuf, SRAM0_SIZE-prebuf, type, xOffset, yOffset, xWidth, yWidth))>=0)
-		// send frame, use in-place buffer	
-		CRP_RETURN(chirp, USE_BUFFER(SRAM0_SIZE, frame), HTYPE(FOURCC('B','A','8','1')), UINT16(xWidth), UINT16(yWidth), UINTS8(xWidth*yWidth, frame+prebuf), END);
+	if ((result=cam_getFrame(frame+prebuf, SRAM0_SIZE-prebuf, type, xOffset, yOffset, xWidth, yWidth, &time))>=0)
+		// send frame, use in-place buffer, the capture time goes after it
+		CRP_RETURN(chirp, USE_BUFFER(SRAM0_SIZE, frame), HTYPE(FOURCC('B','A','8','1')), UINT16(xWidth), UINT16(yWidth), UINTS8(xWidth*yWidth, frame+prebuf), 
+			UINT32(time), END);
 
 	return result;
 }
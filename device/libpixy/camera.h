@@ -29,7 +29,16 @@ int32_t cam_setLightMode(const uint8_t &mode, Chirp *chirp=NULL);
 uint32_t cam_getLightMode(Chirp *chirp=NULL);
 
 int32_t cam_getFrameChirp(const uint8_t &type, const uint16_t &xOffset, const uint16_t &yOffset, const uint16_t &xWidth, const uint16_t &yWidth, Chirp *chirp);
-int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth);
+// time, if not NULL, gets the frame's capture time (hal_us at vsync)
+int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth, uint32_t *time=NULL);
+
+// Whatever grabs a frame synchronously through the M0 into SRAM0 (cam_getFrame, 
+// cc_getRLSFrame, the procs that return frames) calls cam_claim first.  The callback
+// lets the main loop's frame, if there's one on the M0, come back, so the M0's answer
+// isn't taken for it.
+typedef void (*ClaimCallback)(void);
+void cam_setClaimCallback(ClaimCallback callback);
+void cam_claim(void);
 
 /* default register values for OV9715
 0x0=0x0
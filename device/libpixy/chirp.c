@@ -125,7 +125,7 @@ int assembleHelper(va_list *args)
 
     for (i=CRP_HEADER_LEN+g_len; TRUE;)
     {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
         type = va_arg(*args, int);
 #else
         type = va_arg(*args, uint8_t);
@@ -145,7 +145,7 @@ int assembleHelper(va_list *args)
 
         if (type==CRP_INT8)
         {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
             int8_t val = va_arg(*args, int);
 #else
             int8_t val = va_arg(*args, int8_t);
@@ -155,7 +155,7 @@ int assembleHelper(va_list *args)
         }
         else if (type==CRP_INT16)
         {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
             int16_t val = va_arg(*args, int);
 #else
             int16_t val = va_arg(*args, int16_t);
@@ -176,7 +176,7 @@ int assembleHelper(va_list *args)
         }
         else if (type==CRP_FLT32)
         {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
             float val = va_arg(*args, double);
 #else
             float val = va_arg(*args, float);
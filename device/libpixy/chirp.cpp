@@ -68,7 +68,7 @@ void Chirp::setLink(Link *link)
 
     if (m_sharedMem)
     {
-        m_buf = (uint8_t *)m_link->getFlags(LINK_FLAG_INDEX_SHARED_MEMORY_LOCATION);
+        m_buf = (uint8_t *)(uintptr_t)m_link->getFlags(LINK_FLAG_INDEX_SHARED_MEMORY_LOCATION);
         m_bufSize = m_link->getFlags(LINK_FLAG_INDEX_SHARED_MEMORY_SIZE);
     }
     else
@@ -110,7 +110,7 @@ int Chirp::assembleHelper(va_list *args)
 
     for (i=m_headerLen+m_len; true;)
     {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
         type = va_arg(*args, int);
 #else
         type = va_arg(*args, uint8_t);
@@ -140,7 +140,7 @@ int Chirp::assembleHelper(va_list *args)
 
         if (type==CRP_INT8)
         {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
             int8_t val = va_arg(*args, int);
 #else
             int8_t val = va_arg(*args, int8_t);
@@ -150,7 +150,7 @@ int Chirp::assembleHelper(va_list *args)
         }
         else if (type==CRP_INT16)
         {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
             int16_t val = va_arg(*args, int);
 #else
             int16_t val = va_arg(*args, int16_t);
@@ -171,7 +171,7 @@ int Chirp::assembleHelper(va_list *args)
         }
         else if (type==CRP_FLT32)
         {
-#if defined(__WIN32__) || defined(__arm)
+#if defined(__WIN32__) || defined(__arm) || defined(PIXY_SIM)
             float val = va_arg(*args, double);
 #else
             float val = va_arg(*args, float);
@@ -358,7 +358,7 @@ int Chirp::call(uint8_t service, ChirpProc proc, ...)
 
 int Chirp::sendChirpRetry(uint8_t type, ChirpProc proc)
 {
-    int i, res;
+    int i, res = CRP_RES_ERROR;
 
     for (i=0; i<m_retries; i++)
     {
@@ -1055,7 +1055,7 @@ int Chirp::recvData()
             chunk = m_blkSize;
         else
             chunk = m_len-m_offset;
-        if (m_link->receive(m_buf+m_offset, chunk+3, m_dataTimeout)<0) // +3 to read sequence, crc
+        if ((res=m_link->receive(m_buf+m_offset, chunk+3, m_dataTimeout))<0) // +3 to read sequence, crc
             return CRP_RES_ERROR_RECV_TIMEOUT;
         if (res<(int)chunk+3)
             return CRP_RES_ERROR;
@@ -11,7 +11,6 @@
 #define TRUE 1
 
 #define CRP_ERROR_CORRECTED
-#define CRP_SHARED_MEM
 
 #define CRP_BLK_SIZE                    0x200
 #ifdef CRP_ERROR_CORRECTED
@@ -141,7 +141,7 @@
 #define SYNC                            0
 #define ASYNC                           1
 
-#define CRP_RETURN(chirp, ...)          chirp->assemble(NULL, __VA_ARGS__, END)
+#define CRP_RETURN(chirp, ...)          chirp->assemble(0, __VA_ARGS__, END)
 #define callSync(...)                   call(SYNC, __VA_ARGS__, END)
 #define callAsync(...)                  call(ASYNC, __VA_ARGS__, END)
 
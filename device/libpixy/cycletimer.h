@@ -1,17 +1,20 @@
 #ifndef CYCLETIMER_H
 #define CYCLETIMER_H
-#include "lpc_types.h"
-#include "lpc43xx.h"
+#include "hal.h"
+
+// CPU clocks (CLKFREQ) from hal_ticks, timer 1 on the LPC43xx, steady_clock in the sim
+#define CTIMER_NOW() \
+  hal_ticks()
 
 #define CTIMER_DECLARE() \
   uint32_t ct_start; \
   uint32_t ct_diff
 
 #define CTIMER_START() \
-  ct_start = LPC_TIMER1->TC
+  ct_start = CTIMER_NOW()
 
 #define CTIMER_STOP() \
-  ct_diff = LPC_TIMER1->TC-ct_start
+  ct_diff = CTIMER_NOW()-ct_start
 
 #define CTIMER_GET() \
    ct_diff
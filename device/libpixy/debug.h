@@ -1,13 +1,15 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 
-#ifdef CORE_M0
+#if defined(CORE_M0) || defined(PIXY_SIM)
 #include <stdio.h>
 #endif
+#ifndef PIXY_SIM
 #include "debug_frmwrk.h"
+#endif
 
 #ifdef DEBUG
-#ifdef CORE_M0
+#if defined(CORE_M0) || defined(PIXY_SIM)
 #define printf(...)  printf(__VA_ARGS__)
 #else
 #define printf(...)  lpc_printf(__VA_ARGS__)
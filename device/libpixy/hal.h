@@ -0,0 +1,35 @@
+#ifndef _HAL_H
+#define _HAL_H
+
+#include <inttypes.h>
+#include "pixyvals.h"
+
+// The hardware the libpixy and video code touch directly: the cycle timer, the events
+// between the two cores, the camera port, the servo PWM and the SSP.  On the LPC43xx
+// (hal_lpc43xx.h) these are inline register accesses, so they cost nothing over using the
+// registers.  With PIXY_SIM defined they're functions in device/sim/hal_sim.cpp, which
+// runs the same code on a workstation (see device/sim/Makefile).
+//
+// The SRAM banks stay at their pixyvals.h addresses either way, the simulation maps
+// memory there (hal_init), so addresses still fit in 32 bits and can go through Chirp.
+
+// camera port bits
+#define HAL_CAM_DATA        0x00ff
+#define HAL_CAM_HSYNC       0x0800
+#define HAL_CAM_VSYNC       0x1000
+#define HAL_CAM_PCLK        0x2000
+
+// servo PWM period (SCTInit), us, the servo timer interrupt comes once a period
+#define HAL_SERVO_PERIOD    20000
+
+// SPI_SS and SPI_SCK, the SSP's select (we drive it to resync) and clock
+#define HAL_SPI_SS          0x20
+#define HAL_SPI_SCK         0x04
+
+#ifdef PIXY_SIM
+#include "hal_sim.h"
+#else
+#include "hal_lpc43xx.h"
+#endif
+
+#endif
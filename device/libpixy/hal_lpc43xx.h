@@ -0,0 +1,170 @@
+#ifndef _HAL_LPC43XX_H
+#define _HAL_LPC43XX_H
+
+#include "lpc43xx.h"
+#include "lpc43xx_ssp.h"
+#include "ipc_mbx.h"
+
+// see hal.h
+
+#define HAL_CAM_PORT        (LPC_GPIO_PORT->PIN[1]) // the M0's line routines are given its address
+#define HAL_SCCB_PORT       (LPC_GPIO_PORT->PIN[0])
+#define HAL_SCCB_DIR        (LPC_GPIO_PORT->DIR[0])
+
+// timer 1 counts CPU clocks (CLKFREQ), timer 2 microseconds, both set up in pixyInit
+static __inline uint32_t hal_ticks(void)
+{
+	return LPC_TIMER1->TC;
+}
+
+static __inline uint32_t hal_us(void)
+{
+	return LPC_TIMER2->TC;
+}
+
+// __SEV raises the other core's IPC interrupt, which wakes it out of __WFE
+static __inline void hal_initNotify(void)
+{
+	IPC_initNotify();
+}
+
+static __inline void hal_notify(void)
+{
+	__DSB();
+	__SEV();
+}
+
+static __inline void hal_wait(void)
+{
+	__WFE();
+}
+
+// Timer 1's match 3 is set at deadline, and with SEVONPEND its interrupt going pending (it
+// isn't enabled) is an event, so __WFE returns by then.  Timer 1's interrupt doesn't go
+// to the M0, so the M0 doesn't sleep, it polls.
+static __inline void hal_waitUntil(uint32_t deadline)
+{
+#ifdef CORE_M4
+	LPC_TIMER1->MR3 = deadline;
+	LPC_TIMER1->MCR |= 1<<9; // interrupt on MR3
+	SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+	if ((int32_t)(deadline - hal_ticks())>0)
+		__WFE();
+	LPC_TIMER1->MCR &= ~(1<<9);
+	LPC_TIMER1->IR = 1<<3;
+	NVIC_ClearPendingIRQ(TIMER1_IRQn);
+#endif
+}
+
+static __inline uint32_t hal_camPort(void)
+{
+	return HAL_CAM_PORT;
+}
+
+// servo channels 0 and 1 are SCT outputs 6 and 7, pwm is the pulse width in SCT counts
+static __inline void hal_servoSet(uint8_t channel, uint16_t pwm)
+{
+	LPC_SCT->MATCH[channel+1].L = pwm;
+	LPC_SCT->MATCHREL[channel+1].L = pwm;
+}
+
+static __inline void hal_servoEnable(uint8_t channel, uint8_t enable)
+{
+	if (enable)
+	{
+		LPC_SCT->OUT[channel+6].SET = 1<<0;
+		LPC_SCT->OUT[channel+6].CLR = 1<<(channel+1);
+	}
+	else
+	{
+		LPC_SCT->OUT[channel+6].SET = 1<<15; // disable
+		LPC_SCT->OUT[channel+6].CLR = 1<<0;
+	}
+}
+
+// the servo timer interrupt, SCT event 0 ends each PWM period (SCTInit), below the SSP's priority
+static __inline void hal_servoEnableInt(void)
+{
+	LPC_SCT->EVEN |= 1<<0;
+	NVIC_SetPriority(SCT_IRQn, 1);
+	NVIC_EnableIRQ(SCT_IRQn);
+}
+
+static __inline void hal_servoClearInt(void)
+{
+	LPC_SCT->EVFLAG = 1<<0;
+}
+
+// SSP1, 16-bit slave
+static __inline void hal_sspInit(void)
+{
+	uint32_t i;
+	volatile uint32_t d;
+	SSP_CFG_Type configStruct;
+
+	configStruct.CPHA = SSP_CPHA_FIRST;
+	configStruct.CPOL = SSP_CPOL_HI;
+	configStruct.ClockRate = 204000000;
+	configStruct.Databit = SSP_DATABIT_16;
+	configStruct.Mode = SSP_SLAVE_MODE;
+	configStruct.FrameFormat = SSP_FRAME_SPI;
+
+	// Initialize SSP peripheral with parameter given in structure above
+	SSP_Init(LPC_SSP1, &configStruct);
+
+	// clear receive fifo
+	for (i=0; i<8; i++)
+		d = LPC_SSP1->DR;
+
+	// Enable SSP peripheral
+	SSP_Cmd(LPC_SSP1, ENABLE);
+		
+	SSP_ClearIntPending(LPC_SSP1, SSP_INTCFG_RT);
+	SSP_IntConfig(LPC_SSP1, SSP_INTCFG_RT, ENABLE);
+}
+
+static __inline void hal_sspEnableInt(void)
+{
+	NVIC_SetPriority(SSP1_IRQn, 0);	// high priority interrupt
+	NVIC_EnableIRQ(SSP1_IRQn);
+}
+
+static __inline void hal_sspDisableInt(void)
+{
+	NVIC_DisableIRQ(SSP1_IRQn);
+}
+
+static __inline void hal_sspClearInt(void)
+{
+	LPC_SSP1->DR = SSP_INTCFG_RT;
+}
+
+static __inline uint32_t hal_sspWritable(void)
+{
+	return LPC_SSP1->SR&SSP_SR_TNF;
+}
+
+static __inline void hal_sspWrite(uint16_t data)
+{
+	LPC_SSP1->DR = data;
+}
+
+static __inline uint16_t hal_sspRead(void)
+{
+	return LPC_SSP1->DR;
+}
+
+static __inline void hal_spiSelect(uint8_t select)
+{
+	if (select)
+		LPC_GPIO_PORT->PIN[5] &= ~HAL_SPI_SS; // assert SPI_SS
+	else
+		LPC_GPIO_PORT->PIN[5] |= HAL_SPI_SS; // negate SPI_SS
+}
+
+static __inline uint32_t hal_spiClock(void)
+{
+	return LPC_GPIO_PORT->PIN[5]&HAL_SPI_SCK;
+}
+
+#endif
@@ -213,6 +213,9 @@ void M0_M4CORE_IRQHandler() {
 	// quit the interrupt
 	MASTER_TXEV_QUIT();
 
+	// just a wakeup (see IPC_initNotify), no mailboxes
+	if(mbxLocalTablePtr == 0) return;
+
 	for(i=(mbxId_t)0; i<NUM_SLAVE_MBX;i++) {
 	
 		if(PROCESS == IPC_queryLocalMbx(i)) {
@@ -223,6 +226,27 @@ void M0_M4CORE_IRQHandler() {
 }
 
 
+/* enable the interrupt from the other cpu without any mailboxes, */
+/* so that its __SEV() wakes this cpu out of __WFE() */
+void IPC_initNotify(void) {
+
+#ifdef IPC_MASTER
+	SLAVE_TXEV_QUIT();
+	NVIC_DisableIRQ((IRQn_Type)SLAVE_IRQn);
+	NVIC_ClearPendingIRQ((IRQn_Type)SLAVE_IRQn);
+	NVIC_SetPriority((IRQn_Type)SLAVE_IRQn, MASTER_MAILBOX_PRIORITY);
+	NVIC_EnableIRQ((IRQn_Type)SLAVE_IRQn);
+#endif
+#ifdef IPC_SLAVE
+	MASTER_TXEV_QUIT();
+	NVIC_DisableIRQ((IRQn_Type)MASTER_IRQn);
+	NVIC_ClearPendingIRQ((IRQn_Type)MASTER_IRQn);
+	NVIC_SetPriority((IRQn_Type)MASTER_IRQn, SLAVE_MAILBOX_PRIORITY);
+	NVIC_EnableIRQ((IRQn_Type)MASTER_IRQn);
+#endif
+}
+
+
 /* download a processor image to the SLAVE CPU */
 void IPC_downloadSlaveImage(uint32_t slaveRomStart, const unsigned char slaveImage[], uint32_t imageSize)
 {
@@ -340,6 +364,9 @@ void M0CORE_IRQHandler() {
 	// acknowledge the interrupt
 	SLAVE_TXEV_QUIT();
 
+	// just a wakeup (see IPC_initNotify), no mailboxes
+	if(mbxLocalTablePtr == 0) return;
+
 	for(i=(mbxId_t)0;i<NUM_MASTER_MBX;i++) {
 
 		if(PROCESS == IPC_queryLocalMbx(i)) {
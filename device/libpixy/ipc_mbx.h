@@ -1,11 +1,11 @@
 #ifndef __IPC_H__
 #define __IPC_H__
 
-#include "platform_config.h"
+#include "platform_config.h"
 
-#ifdef __cplusplus
- extern "C" {
-#endif 
+#ifdef __cplusplus
+ extern "C" {
+#endif 
 
 /************************************************/
 /* types of ipc messages 						*/
@@ -166,12 +166,15 @@ void IPC_startSlave(void);
 /* put the processor back in reset */
 void IPC_haltSlave(void);
 
+/* enable the interrupt from the other cpu, only as a wakeup (no mailboxes) */
+void IPC_initNotify(void);
+
 /* initialize the MBX ipc framework */
 void IPC_initSlaveMbx(CbackItem cbackTable[], Mbx* masterMbxPtr, Mbx* slaveMbxPtr);
 void IPC_initMasterMbx(CbackItem cbackTable[], Mbx* masterMbxPtr, Mbx* slaveMbxPtr);
 
-#ifdef __cplusplus
-}
-#endif 
+#ifdef __cplusplus
+}
+#endif 
 
 #endif /* __IPC_H__ */
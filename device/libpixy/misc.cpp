@@ -1,10 +1,11 @@
 #include "misc.h"
 #include "lpc43xx_adc.h"
+#include "hal.h"
 
 // can be called before timer is set up
 void delayus(uint32_t us)
 {
-	volatile uint32_t i, j;	
+	volatile uint32_t i, j;	
 	
 	for (i=0; i<us; i++)
 		for (j=0; j<38; j++);
@@ -33,9 +34,9 @@ uint32_t adc_get(uint32_t channel)
 	uint32_t res;
 
 	ADC_ChannelCmd(LPC_ADC0, channel, ENABLE);
-	delayus(500);
-	ADC_StartCmd(LPC_ADC0, ADC_START_NOW);
-	while (!(ADC_ChannelGetStatus(LPC_ADC0, channel, ADC_DATA_DONE)));
+	delayus(500);
+	ADC_StartCmd(LPC_ADC0, ADC_START_NOW);
+	while (!(ADC_ChannelGetStatus(LPC_ADC0, channel, ADC_DATA_DONE)));
 	res = ADC_ChannelGetData(LPC_ADC0, channel);
 	ADC_ChannelCmd(LPC_ADC0, channel, DISABLE);
 
@@ -44,13 +45,13 @@ uint32_t adc_get(uint32_t channel)
 
 void setTimer(uint32_t *timer)
 {
-	*timer = LPC_TIMER2->TC;
+	*timer = hal_us();
 }
 
 uint32_t getTimer(uint32_t timer)
 {
 	uint32_t result; 
-	result = LPC_TIMER2->TC-timer;	
+	result = hal_us()-timer;	
 
 	return result;
 }
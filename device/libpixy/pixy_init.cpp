@@ -117,8 +117,9 @@ void pixyInit(uint32_t slaveRomStart, const unsigned char slaveImage[], uint32_t
    	SCTInit();
 	CameraInit();
 
-	// start slave
+	// start slave, with the M0 link's rings ready before it looks at them
 	IPC_downloadSlaveImage(slaveRomStart, slaveImage, imageSize);
+	sm_init();
 	IPC_startSlave();
 
 	// initialize chirp objects
@@ -1,6 +1,7 @@
 #ifndef PIXY_INIT_H
 #define PIXY_INIT_H
 
+#ifndef PIXY_SIM
 #include "lpc_types.h"
 #include "debug_frmwrk.h"
 #include "lpc43xx_adc.h"
@@ -9,6 +10,9 @@
 #include "usbcore.h"
 #include "usbuser.h"
 #include "ipc_mbx.h"
+#else
+#include "hal.h"
+#endif
 #include "chirpm0.h"
 #include "chirpusb.h"
 #include "pixyvals.h"
@@ -0,0 +1,118 @@
+#include <string.h>
+#include "chirp.hpp"
+#include "pixyvals.h"
+#include "prof.h"
+#include "hal.h"
+
+#ifdef __GNUC__
+#define PROF_CLZ(x)         __builtin_clz(x)
+#else
+#define PROF_CLZ(x)         __clz(x)
+#endif
+
+static ProfZone g_prof[PROF_NUM_ZONES];
+
+static const char *g_profNames[PROF_NUM_ZONES] =
+{
+#define PROF_ZONE(id, name) name,
+	PROF_ZONES
+#undef PROF_ZONE
+};
+
+static const ProcModule g_module[] =
+{
+	{
+	"prof_get",
+	(ProcPtr)prof_get,
+	{END},
+	"Get the profiling zones (see prof.h), times are in CPU clocks"
+	"@r number of zones, followed by the clock frequency, the zone names (comma separated), "
+	"count, min, max and mean of each zone, and the histogram of each zone (PROF_BINS each)"
+	},
+	{
+	"prof_reset",
+	(ProcPtr)prof_reset,
+	{END},
+	"Clear the profiling zones"
+	"@r always returns 0"
+	},
+	{
+	"prof_getTime",
+	(ProcPtr)prof_getTime,
+	{END},
+	"Get the time frames are stamped with, so the host can find the offset between its clock and ours"
+	"@r always returns 0, followed by the time in us (hal_us)"
+	},
+	END
+};
+
+void prof_init(Chirp *chirp)
+{
+	chirp->registerModule(g_module);
+}
+
+void prof_add(uint8_t zone, uint32_t ticks)
+{
+	ProfZone *z = &g_prof[zone];
+	uint32_t bin;
+
+	if (z->count==0 || ticks<z->min)
+		z->min = ticks;
+	if (ticks>z->max)
+		z->max = ticks;
+	z->count++;
+	z->sum += ticks;
+	bin = ticks ? 32-PROF_CLZ(ticks) : 0;
+	if (bin>=PROF_BINS)
+		bin = PROF_BINS-1;
+	z->hist[bin]++;
+}
+
+const ProfZone *prof_zone(uint8_t zone)
+{
+	return &g_prof[zone];
+}
+
+const char *prof_name(uint8_t zone)
+{
+	return g_profNames[zone];
+}
+
+int32_t prof_get(Chirp *chirp)
+{
+	char names[0x80];
+	uint32_t stats[PROF_NUM_ZONES*4];
+	uint32_t hist[PROF_NUM_ZONES*PROF_BINS];
+	uint32_t i;
+
+	// Chirp limits the number of arguments, so the stats go in one array
+
+	for (i=0, names[0]='\0'; i<PROF_NUM_ZONES; i++)
+	{
+		if (i)
+			strcat(names, ",");
+		strcat(names, g_profNames[i]);
+		stats[i*4] = g_prof[i].count;
+		stats[i*4+1] = g_prof[i].min;
+		stats[i*4+2] = g_prof[i].max;
+		stats[i*4+3] = g_prof[i].count ? g_prof[i].sum/g_prof[i].count : 0;
+		memcpy(hist + i*PROF_BINS, g_prof[i].hist, sizeof(g_prof[i].hist));
+	}
+
+	CRP_RETURN(chirp, UINT32(CLKFREQ), STRING(names), UINTS32(PROF_NUM_ZONES*4, stats), 
+		UINTS32(PROF_NUM_ZONES*PROF_BINS, hist), END);
+
+	return PROF_NUM_ZONES;
+}
+
+int32_t prof_reset()
+{
+	memset(g_prof, 0, sizeof(g_prof));
+	return 0;
+}
+
+int32_t prof_getTime(Chirp *chirp)
+{
+	CRP_RETURN(chirp, UINT32(hal_us()), END);
+	return 0;
+}
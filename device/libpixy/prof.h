@@ -0,0 +1,74 @@
+#ifndef _PROF_H
+#define _PROF_H
+
+#include <inttypes.h>
+#include "cycletimer.h"
+
+// Profiling zones: each zone keeps the count, min, max and sum of its times, and a
+// histogram of them by power of 2 (bin b holds times from 2^(b-1) to 2^b-1 clocks).
+// The table is static and adding a time is a few instructions, so it's left on.  
+// Times are in CPU clocks (CTIMER_NOW), prof_get sends the table to PixyMon ("prof").
+//
+// Zones are fixed at compile time, to add one add it to PROF_ZONES.
+//
+//   PROF_START(BLOB_SORT);
+//   blobber.SortFinished();
+//   PROF_STOP(BLOB_SORT);
+//
+// Building with PROF_ENABLE 0 takes the zones out.
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE         1
+#endif
+
+#define PROF_BINS           32
+
+#define PROF_ZONES \
+	PROF_ZONE(RLS_FRAME,     "getRLSFrame")    /* M0 run-length frame, from call to result */ \
+	PROF_ZONE(BLOB_ADD,      "blobAdd")        /* CBlobAssembler::Add of every q val in a frame */ \
+	PROF_ZONE(BLOB_SORT,     "blobSort")       /* EndFrame and SortFinished */ \
+	PROF_ZONE(CHIRP_SERVICE, "chirpService")   /* servicing the USB Chirp, rounds that had calls */ \
+	PROF_ZONE(LATENCY,       "latency")        /* frame capture (vsync) to its blobs */
+
+enum
+{
+#define PROF_ZONE(id, name) PROF_##id,
+	PROF_ZONES
+#undef PROF_ZONE
+	PROF_NUM_ZONES
+};
+
+struct ProfZone
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t hist[PROF_BINS];
+};
+
+#if PROF_ENABLE
+#define PROF_START(zone)        uint32_t prof_##zone = CTIMER_NOW()
+#define PROF_STOP(zone)         prof_add(PROF_##zone, CTIMER_NOW()-prof_##zone)
+// for times measured elsewhere, eg across a callback
+#define PROF_ADD(zone, ticks)   prof_add(PROF_##zone, ticks)
+#else
+#define PROF_START(zone)
+#define PROF_STOP(zone)
+#define PROF_ADD(zone, ticks)
+#endif
+
+class Chirp;
+
+void prof_init(Chirp *chirp);
+void prof_add(uint8_t zone, uint32_t ticks);
+const ProfZone *prof_zone(uint8_t zone);
+const char *prof_name(uint8_t zone);
+
+int32_t prof_get(Chirp *chirp);
+int32_t prof_reset();
+// hal_us, the clock the M0 stamps frames with at vsync (getFrame, getRLSFrame).  PixyMon
+// calls it when it connects, to find the offset between its clock and ours.
+int32_t prof_getTime(Chirp *chirp);
+
+#endif
@@ -1,7 +1,9 @@
 #include "pixy_init.h"
 #include "rcservo.h"
+#include "hal.h"
 
 static uint16_t g_rcsPos[2];
+static RcsTickCallback g_rcsTickCallback = NULL;
 
 static const ProcModule g_module[] =
 {
@@ -40,7 +42,24 @@ void rcs_init()
 	rcs_setPos(0, RCS_MAX_POS/2);
 	rcs_setPos(1, RCS_MAX_POS/2);
 		
-	g_chirpUsb->registerModule(g_module);
+	g_chirpUsb->registerModule(g_module);
+
+	hal_servoEnableInt();
+}
+
+void rcs_setTickCallback(RcsTickCallback callback)
+{
+	g_rcsTickCallback = callback;
+}
+
+extern "C" void SCT_IRQHandler(void);
+
+void SCT_IRQHandler(void)
+{
+	hal_servoClearInt();
+
+	if (g_rcsTickCallback)
+		(*g_rcsTickCallback)();
 }
 
 int32_t rcs_setPos(const uint8_t &channel, const uint16_t &pos, Chirp *chirp)
@@ -48,10 +67,8 @@ int32_t rcs_setPos(const uint8_t &channel, const uint16_t &pos, Chirp *chirp)
 	if (channel>1 || pos>RCS_MAX_POS)
 		return -1;
 
-	LPC_SCT->MATCH[channel+1].L = RCS_MIN_PWM + pos;
-	LPC_SCT->MATCHREL[channel+1].L = RCS_MIN_PWM + pos;
-	LPC_SCT->OUT[channel+6].SET = 1<<0; 
-	LPC_SCT->OUT[channel+6].CLR = 1<<(channel+1);
+	hal_servoSet(channel, RCS_MIN_PWM + pos);
+	hal_servoEnable(channel, 1);
 
 	g_rcsPos[channel] = pos;
 
@@ -71,16 +88,7 @@ int32_t rcs_enable(const uint8_t &channel, const uint8_t &enable, Chirp *chirp)
 	if (channel>1)
 		return -1;
 
-	if (enable)
-	{
-		LPC_SCT->OUT[channel+6].SET = 1<<0; 
-		LPC_SCT->OUT[channel+6].CLR = 1<<(channel+1);
-	}
-	else
-	{
-		LPC_SCT->OUT[channel+6].SET = 1<<15; // disable
-		LPC_SCT->OUT[channel+6].CLR = 1<<0;
-	}
+	hal_servoEnable(channel, enable);
 
 	return 0;
 }
@@ -4,8 +4,11 @@
 #define RCS_MAX_POS     1000
 #define RCS_MIN_PWM     1000
 #define RCS_MAX_PWM     2000
+// called from the servo timer interrupt at the start of each PWM period (HAL_SERVO_PERIOD)
+typedef void (*RcsTickCallback)(void);
 
 void rcs_init();
+void rcs_setTickCallback(RcsTickCallback callback);
 
 int32_t rcs_setPos(const uint8_t &channel, const uint16_t &pos, Chirp *chirp=NULL);
 int32_t rcs_getPos(const uint8_t &channel, Chirp *chirp=NULL);
@@ -13,4 +16,4 @@ int32_t rcs_enable(const uint8_t &channel, const uint8_t &enable, Chirp *chirp=N
 
 #endif
 
-												   
\ No newline at end of file
+												   
\ No newline at end of file
@@ -1,14 +1,14 @@
 #ifndef _SCCB_H
 #define _SCCB_H
 
-#include "lpc43xx.h"
+#include "hal.h"
 
 #define SCCB_DELAY		  100
 
 #define CLK_MASK          (1<<1)
 #define DATA_MASK         (1<<0)
-#define DIR_REG 		  LPC_GPIO_PORT->DIR[0]
-#define DATA_REG  		  LPC_GPIO_PORT->PIN[0]
+#define DIR_REG 		  HAL_SCCB_DIR
+#define DATA_REG  		  HAL_SCCB_PORT
 
 class CSccb
 	{
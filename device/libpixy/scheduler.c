@@ -0,0 +1,135 @@
+#include <string.h>
+#include "cycletimer.h"
+#include "scheduler.h"
+
+#ifdef __GNUC__
+#define SCHED_BARRIER()     __sync_synchronize()
+#else
+#define SCHED_BARRIER()     __dmb(0xf)
+#endif
+
+void sched_init(struct Sched *s)
+{
+	memset(s, 0, sizeof(struct Sched));
+}
+
+int sched_add(struct Sched *s, struct SchedTask *task)
+{
+	uint32_t i;
+
+	if (s->num==SCHED_MAX_TASKS)
+		return -1;
+
+	for (i=s->num; i>0 && s->tasks[i-1]->priority>task->priority; i--)
+		s->tasks[i] = s->tasks[i-1];
+	s->tasks[i] = task;
+	s->num++;
+	return 0;
+}
+
+// The interrupt preempts the main loop, and not the other way around.  If it comes between
+// sched_round seeing signaled and clearing it, the signal is lost, but the task hasn't run
+// yet, so it still sees whatever the signal was for.
+void sched_signal(struct SchedTask *task)
+{
+	if (!task->signaled)
+	{
+		task->signalTime = CTIMER_NOW();
+		SCHED_BARRIER();
+		task->signaled = 1;
+	}
+}
+
+static void account(struct SchedTask *task, uint32_t ticks)
+{
+	task->runs++;
+	task->total += ticks;
+	if (ticks>task->max)
+		task->max = ticks;
+	if (ticks>task->budget*CLKFREQ_US)
+		task->overruns++;
+}
+
+uint32_t sched_round(struct Sched *s)
+{
+	uint32_t i, ran, worked, start;
+	struct SchedTask *task;
+
+	for (ran=0, worked=0; 1; )
+	{
+		// highest priority ready task that hasn't run this round
+		for (i=0; i<s->num; i++)
+		{
+			task = s->tasks[i];
+			if (!(ran&(1<<i)) && ((task->flags&SCHED_POLL) || task->signaled))
+				break;
+		}
+		if (i==s->num)
+			break;
+		ran |= 1<<i;
+
+		start = CTIMER_NOW();
+		if (task->signaled)
+		{
+			if (start-task->signalTime>task->maxWait)
+				task->maxWait = start-task->signalTime;
+			task->signaled = 0;
+			SCHED_BARRIER();
+		}
+		if ((*task->func)(task->budget))
+		{
+			task->worked++;
+			worked++;
+		}
+		account(task, CTIMER_NOW()-start);
+	}
+	s->rounds++;
+
+	return worked;
+}
+
+void sched_idle(struct Sched *s)
+{
+	uint32_t i, start;
+
+	// signaled after it ran this round
+	for (i=0; i<s->num; i++)
+	{
+		if (s->tasks[i]->signaled)
+			return;
+	}
+
+	start = CTIMER_NOW();
+	hal_wait();
+	s->idleTotal += CTIMER_NOW()-start;
+	s->idles++;
+}
+
+void sched_run(struct Sched *s)
+{
+	while(1)
+	{
+		if (sched_round(s)==0)
+			sched_idle(s);
+	}
+}
+
+void sched_resetStats(struct Sched *s)
+{
+	uint32_t i;
+	struct SchedTask *task;
+
+	for (i=0; i<s->num; i++)
+	{
+		task = s->tasks[i];
+		task->runs = 0;
+		task->worked = 0;
+		task->overruns = 0;
+		task->max = 0;
+		task->total = 0;
+		task->maxWait = 0;
+	}
+	s->rounds = 0;
+	s->idles = 0;
+	s->idleTotal = 0;
+}
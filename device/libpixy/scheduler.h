@@ -0,0 +1,85 @@
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Run-to-completion scheduler for the M4's main loop.  Each task is a function that does
+// a bounded piece of work and returns, nothing is preempted except by interrupts.
+//
+// Tasks run in rounds.  A task is ready if it's polled (SCHED_POLL, eg servicing a link)
+// or it's been signaled (sched_signal, eg from an interrupt).  In each round every ready
+// task runs once, and the next one to run is always the highest priority ready task that
+// hasn't run yet this round, so a task signaled from an interrupt runs as soon as the
+// task that's running returns.  Since a task runs at most once a round, a busy task
+// can't starve the others--- it has to return by its budget and it runs again next round.
+//
+// A task gets its budget (us) and returns nonzero if it did anything.  The scheduler
+// doesn't stop a task that goes past its budget, it counts the overrun.  When a round
+// does nothing the core sleeps until the next interrupt or event from the M0 (hal_wait,
+// __WFE).  An interrupt between a task looking for work and the sleep sets the event
+// register, so the sleep returns right away and no wakeup is lost, which isn't so with
+// __WFI.
+//
+// Times are kept per task in CPU clocks (CTIMER_NOW), along with the time spent idle.
+//
+//   static SchedTask g_usbTask = {"usb", usbTask, 2000, 3, SCHED_POLL};
+//   sched_add(&g_sched, &g_usbTask);
+//   sched_run(&g_sched);
+
+#define SCHED_MAX_TASKS     8
+
+#define SCHED_POLL          0x01 // ready every round
+
+typedef int32_t (*SchedFunc)(uint32_t budget);
+
+struct SchedTask
+{
+	const char *name;
+	SchedFunc func;
+	uint32_t budget;            // us
+	uint8_t priority;           // 0 is highest
+	uint8_t flags;
+
+	volatile uint8_t signaled;  // set by sched_signal, cleared when the task runs
+	uint32_t signalTime;        // CTIMER_NOW at the first signal since the task last ran
+
+	// accounting, CPU clocks
+	uint32_t runs;
+	uint32_t worked;            // runs that returned nonzero
+	uint32_t overruns;          // runs longer than budget
+	uint32_t max;
+	uint64_t total;
+	uint32_t maxWait;           // longest from signal to run
+};
+
+struct Sched
+{
+	struct SchedTask *tasks[SCHED_MAX_TASKS]; // by priority
+	uint8_t num;
+	uint32_t rounds;
+	uint32_t idles;
+	uint64_t idleTotal;         // CPU clocks
+};
+
+void sched_init(struct Sched *s);
+// tasks are kept in priority order, tasks of the same priority in the order they're added
+int sched_add(struct Sched *s, struct SchedTask *task);
+// makes the task ready, can be called from an interrupt
+void sched_signal(struct SchedTask *task);
+// runs each ready task once, returns the number that did something
+uint32_t sched_round(struct Sched *s);
+// sleeps until an interrupt or event
+void sched_idle(struct Sched *s);
+// rounds forever, sleeping when a round does nothing
+void sched_run(struct Sched *s);
+void sched_resetStats(struct Sched *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
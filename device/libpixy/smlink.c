@@ -1,49 +1,57 @@
-#include "lpc43xx.h"
 #include "chirp.h"
 #include "smlink.h"
 
 
-uint32_t linkGetFlags(uint8_t index)
+void linkInit(void)
 {
-	if (index==LINK_FLAG_INDEX_SHARED_MEMORY_LOCATION)
-		return (uint32_t)SM_OBJECT->buf;
-	else if (index==LINK_FLAG_INDEX_SHARED_MEMORY_SIZE)
-		return SM_BUFSIZE;
-	else
-		return 0;
+	// the M4 sets up the rings before it starts us, we just need to be woken
+	// when the M4 sends or receives
+	hal_initNotify();
 }
 
 int linkSend(const uint8_t *data, uint32_t len, uint16_t timeoutMs)
 {
-	uint32_t time, start, timeout = timeoutMs * CLKFREQ_MS;
+	uint32_t n, sent, start, timeout = timeoutMs * CLKFREQ_MS;
 
-	start = LPC_TIMER1->TC;
-	// wait for data to go out
-	while(SM_OBJECT->sendStatus==SM_STATUS_DATA_AVAIL)
+	start = hal_ticks();
+	for (sent=0; sent<len; )
 	{
-		time = LPC_TIMER1->TC; 
-		if ((uint32_t)(time-start) > timeout)
+		if ((n=smr_put(&SM_OBJECT->m0ToM4, data+sent, len-sent)))
+		{
+			sent += n;
+			hal_notify();
+			continue;
+		}
+		// wait for the M4 to make room
+		if ((uint32_t)(hal_ticks()-start) > timeout)
 			return -1;
+		hal_waitUntil(start+timeout);
 	}
-	// set status to indicate data is avail
-	SM_OBJECT->sendStatus = SM_STATUS_DATA_AVAIL;	
 	return len;
 }
 
 int linkReceive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
 {
-	uint32_t time, start, timeout = timeoutMs * CLKFREQ_MS;
+	uint32_t n, received, start, timeout = timeoutMs * CLKFREQ_MS;
 
-	start = LPC_TIMER1->TC;
-	// wait for data to come in
-	while(!(SM_OBJECT->recvStatus==SM_STATUS_DATA_AVAIL))
+	// polling, only take the data if all of it is there
+	if (timeoutMs==0 && smr_avail(&SM_OBJECT->m4ToM0)<len)
+		return -1;
+
+	start = hal_ticks();
+	for (received=0; received<len; )
 	{
-		time = LPC_TIMER1->TC; 
-		if ((uint32_t)(time-start) > timeout)
+		if ((n=smr_get(&SM_OBJECT->m4ToM0, data+received, len-received)))
+		{
+			received += n;
+			hal_notify();
+			continue;
+		}
+		// wait for the M4 to send
+		if ((uint32_t)(hal_ticks()-start) > timeout)
 			return -1;
+		hal_waitUntil(start+timeout);
 	}
-	// set status to indicate data has been read	
-	SM_OBJECT->recvStatus = 0;	
 
 	return len;
 }
@@ -1,15 +1,15 @@
-#include "lpc43xx.h"
 #include "smlink.hpp"
 
-#define CLKRATE   204000000
-#define CLKRATEMS (CLKRATE/1000)
+void sm_init()
+{
+	smr_init(&SM_OBJECT->m4ToM0);
+	smr_init(&SM_OBJECT->m0ToM4);
+	hal_initNotify();
+}
 
 SMLink::SMLink()
 {
-	m_flags = LINK_FLAG_ERROR_CORRECTED | LINK_FLAG_SHARED_MEM;
-
-	SM_OBJECT->sendStatus = 0;
-	SM_OBJECT->recvStatus = 0;
+	m_flags = LINK_FLAG_ERROR_CORRECTED;
 }
 
 SMLink::~SMLink()
@@ -18,46 +18,47 @@ SMLink::~SMLink()
 
 int SMLink::send(const uint8_t *data, uint32_t len, uint16_t timeoutMs)
 {
-	uint32_t time, start, timeout = timeoutMs * CLKRATEMS;
+	uint32_t n, sent, start, timeout = timeoutMs * CLKFREQ_MS;
 
-	start = LPC_TIMER1->TC;
-	// wait for data to go out
-	while(SM_OBJECT->sendStatus==SM_STATUS_DATA_AVAIL)
+	start = hal_ticks();
+	for (sent=0; sent<len; )
 	{
-		time = LPC_TIMER1->TC; 
-		if ((uint32_t)(time-start) > timeout)
+		if ((n=smr_put(&SM_OBJECT->m4ToM0, data+sent, len-sent)))
+		{
+			sent += n;
+			hal_notify();
+			continue;
+		}
+		// wait for the M0 to make room
+		if ((uint32_t)(hal_ticks()-start) > timeout)
 			return -1;
+		hal_waitUntil(start+timeout);
 	}
-	// set status to indicate data is avail
-	SM_OBJECT->sendStatus = SM_STATUS_DATA_AVAIL;	
 	return len;
 }
 
 int SMLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
 {
-	uint32_t time, start, timeout = timeoutMs * CLKRATEMS;
+	uint32_t n, received, start, timeout = timeoutMs * CLKFREQ_MS;
+
+	// polling, only take the data if all of it is there
+	if (timeoutMs==0 && smr_avail(&SM_OBJECT->m0ToM4)<len)
+		return -1;
 
-	start = LPC_TIMER1->TC;
-	// wait for data to come in
-	while(!(SM_OBJECT->recvStatus==SM_STATUS_DATA_AVAIL))
+	start = hal_ticks();
+	for (received=0; received<len; )
 	{
-		time = LPC_TIMER1->TC; 
-		if ((uint32_t)(time-start) > timeout)
+		if ((n=smr_get(&SM_OBJECT->m0ToM4, data+received, len-received)))
+		{
+			received += n;
+			hal_notify();
+			continue;
+		}
+		// wait for the M0 to respond
+		if ((uint32_t)(hal_ticks()-start) > timeout)
 			return -1;
+		hal_waitUntil(start+timeout);
 	}
-	// set status to indicate data has been read	
-	SM_OBJECT->recvStatus = 0;	
 
 	return len;
 }
-
-uint32_t SMLink::getFlags(uint8_t index)
-{
-	if (index==LINK_FLAG_INDEX_SHARED_MEMORY_LOCATION)
-		return (uint32_t)SM_OBJECT->buf;
-	else if (index==LINK_FLAG_INDEX_SHARED_MEMORY_SIZE)
-		return SM_BUFSIZE;
-	else 
-		return Link::getFlags(index);
-}
-
@@ -2,23 +2,24 @@
 #define LINKSM_H
 
 #include "pixyvals.h"
+#include "smring.h"
+#include "hal.h"
 
 #define SM_LOC                 (SRAM4_LOC+0x3000)
 #define SM_SIZE                (SRAM4_SIZE-0x3000)
-#define SM_BUFSIZE             (SM_SIZE-4)
 
-// status
-#define SM_STATUS_DATA_AVAIL   0x01
+// Chirp messages go through a ring each way, the core that changes a ring raises
+// an event on the other one (hal_notify), which wakes it if it's waiting (hal_waitUntil,
+// which also wakes it when the timeout's up, in case the other core has stopped).
 
+void linkInit(void);
 int linkSend(const uint8_t *data, uint32_t len, uint16_t timeoutMs);
 int linkReceive(uint8_t *data, uint32_t len, uint16_t timeoutMs);
 
 typedef struct
 {
-	uint16_t sendStatus;
-	uint16_t recvStatus;
-
-	uint8_t buf[SM_BUFSIZE];
+	struct SmRing m4ToM0;
+	struct SmRing m0ToM4;
 }
 SmMap;
 
@@ -3,24 +3,26 @@
 
 #include "pixyvals.h"
 #include "link.h"
+#include "smring.h"
+#include "hal.h"
 
 #define SM_LOC                 (SRAM4_LOC+0x3000)
 #define SM_SIZE                (SRAM4_SIZE-0x3000)
-#define SM_BUFSIZE             (SM_SIZE-4)
 
-// status
-#define SM_STATUS_DATA_AVAIL   0x01
+// Chirp messages go through a ring each way, the core that changes a ring raises
+// an event on the other one (hal_notify), which wakes it if it's waiting (hal_waitUntil,
+// which also wakes it when the timeout's up, in case the other core has stopped).
 
 struct SmMap
 {
-	uint16_t recvStatus;
-	uint16_t sendStatus;
-
-	uint8_t buf[SM_BUFSIZE];
+	SmRing m4ToM0;
+	SmRing m0ToM4;
 };
 
 #define SM_OBJECT       ((SmMap *)SM_LOC)
 
+// sets up the rings, before the M0 is started
+void sm_init();
 
 class SMLink : public Link
 {
@@ -29,7 +31,6 @@ public:
 	~SMLink();
     virtual int send(const uint8_t *data, uint32_t len, uint16_t timeoutMs);
     virtual int receive(uint8_t *data, uint32_t len, uint16_t timeoutMs);
-    virtual uint32_t getFlags(uint8_t index=LINK_FLAG_INDEX_FLAGS);
 };
 
 #endif
@@ -0,0 +1,74 @@
+#include <string.h>
+#include "smring.h"
+
+void smr_init(struct SmRing *ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->offset = 0;
+	ring->reserved = 0;
+}
+
+uint32_t smr_put(struct SmRing *ring, const uint8_t *data, uint32_t len)
+{
+	uint32_t head = ring->head;
+	struct SmSlot *slot;
+
+	if (head - ring->tail>=SMR_SLOTS)
+		return 0;
+	// the consumer is done with the slot before it moves tail
+	SMR_BARRIER();
+
+	if (len>SMR_SLOT_DATA)
+		len = SMR_SLOT_DATA;
+	slot = &ring->slot[head&(SMR_SLOTS-1)];
+	memcpy(slot->data, data, len);
+	slot->len = len;
+	// the consumer has to see the slot before head
+	SMR_BARRIER();
+	ring->head = head+1;
+
+	return len;
+}
+
+uint32_t smr_avail(struct SmRing *ring)
+{
+	uint32_t tail, head = ring->head, n;
+
+	SMR_BARRIER();
+	for (tail=ring->tail, n=0; tail!=head; tail++)
+		n += ring->slot[tail&(SMR_SLOTS-1)].len;
+
+	return n - ring->offset;
+}
+
+uint32_t smr_get(struct SmRing *ring, uint8_t *data, uint32_t len)
+{
+	uint32_t tail = ring->tail, head = ring->head, offset = ring->offset, n, copied;
+	struct SmSlot *slot;
+
+	// the producer filled the slots before it moved head
+	SMR_BARRIER();
+
+	for (copied=0; copied<len && tail!=head; )
+	{
+		slot = &ring->slot[tail&(SMR_SLOTS-1)];
+		n = slot->len - offset;
+		if (n>len-copied)
+			n = len-copied;
+		memcpy(data+copied, slot->data+offset, n);
+		copied += n;
+		offset += n;
+		if (offset==slot->len)
+		{
+			offset = 0;
+			tail++;
+			// done reading the slot before the producer can have it back
+			SMR_BARRIER();
+			ring->tail = tail;
+		}
+	}
+	ring->offset = offset;
+
+	return copied;
+}
@@ -0,0 +1,59 @@
+#ifndef _SMRING_H
+#define _SMRING_H
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ring of message slots in shared memory, written by one core and read by the other.
+// head is only written by the producer and tail (and offset) only by the consumer, so
+// there's no locking, only a barrier between filling or emptying a slot and moving
+// the index past it.  head and tail run freely and wrap, head-tail is the number of
+// full slots.
+//
+// The producer puts up to SMR_SLOT_DATA bytes in each slot.  The consumer reads the
+// slots back as a stream of bytes, so a read can take part of a slot (offset is how much
+// of the tail slot has been read) or span several.
+
+#define SMR_SLOTS           8 // power of 2
+#define SMR_SLOT_DATA       0xf0
+
+#ifdef __GNUC__
+#define SMR_BARRIER()       __sync_synchronize()
+#else
+#define SMR_BARRIER()       __dmb(0xf)
+#endif
+
+struct SmSlot
+{
+	uint32_t len;
+	uint8_t data[SMR_SLOT_DATA];
+};
+
+struct SmRing
+{
+	volatile uint32_t head;   // producer's
+	volatile uint32_t tail;   // consumer's
+	uint32_t offset;          // consumer's
+	uint32_t reserved;
+	struct SmSlot slot[SMR_SLOTS];
+};
+
+void smr_init(struct SmRing *ring);
+
+// producer: copies up to SMR_SLOT_DATA bytes into the next slot, returns the number
+// copied, 0 if the ring is full
+uint32_t smr_put(struct SmRing *ring, const uint8_t *data, uint32_t len);
+
+// consumer: bytes that can be read
+uint32_t smr_avail(struct SmRing *ring);
+// consumer: copies up to len bytes, returns the number copied
+uint32_t smr_get(struct SmRing *ring, uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
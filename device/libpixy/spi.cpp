@@ -1,4 +1,4 @@
-#include "lpc43xx_ssp.h"
+#include "hal.h"
 #include "misc.h"
 #include "spi.h"
 
@@ -28,24 +28,24 @@ int spi_checkIdle()
 	uint32_t i;
 	// 2000, 120us
 	// 1000, 60us
-	LPC_GPIO_PORT->PIN[5] |= 0x20; // negate SPI_SS
+	hal_spiSelect(0);
 	for (i=0; i<150; i++) // 9us
 	{
-		if (LPC_GPIO_PORT->PIN[5]&0x04)
+		if (hal_spiClock())
 			break;
 	}
 	if (i==150)
 	{
-		LPC_GPIO_PORT->PIN[5] &= ~0x20; // assert SPI_SS
+		hal_spiSelect(1);
 		for (i=0; i<16; i++) // 1us
 		{
-			if (LPC_GPIO_PORT->PIN[5]&0x04)
+			if (hal_spiClock())
 				break;
 		}
 		if (i==16)
 			return 1;
  	}
-	LPC_GPIO_PORT->PIN[5] |= 0x20; // negate SPI_SS
+	hal_spiSelect(0);
 	return 0;
 }
 
@@ -65,21 +65,16 @@ int spi_sync()
 
 extern "C" void SSP1_IRQHandler(void);
 
-
-void SSP1_IRQHandler(void)
+// fill the transmit FIFO, returns the number of words written
+static uint32_t transmit()
 {
-	uint32_t d, len; 
-
-	// toggle SPI_SS so we can receive the next word
-	LPC_GPIO_PORT->PIN[5] |= 0x20; // negate SPI_SS
-	d = LPC_SSP1->DR; // grab data
-	LPC_GPIO_PORT->PIN[5] &= ~0x20; // assert SPI_SS
-
+	uint32_t len, n = 0;
 
-	while((LPC_SSP1->SR&SSP_SR_TNF) && g_transmit.m_len)
+	while(hal_sspWritable() && g_transmit.m_len)
 	{
-		LPC_SSP1->DR = g_transmit.m_buf[g_transmit.m_read++];
+		hal_sspWrite(g_transmit.m_buf[g_transmit.m_read++]);
 		g_transmit.m_len--;
+		n++;
 	}
 	
 	if (g_transmit.m_callback && g_transmit.m_len==0)
@@ -89,12 +84,26 @@ void SSP1_IRQHandler(void)
 		g_transmit.m_read = 0;
 	}
 #if 1
-	while((LPC_SSP1->SR&SSP_SR_TNF) && g_transmit.m_len)
+	while(hal_sspWritable() && g_transmit.m_len)
 	{
-		LPC_SSP1->DR = g_transmit.m_buf[g_transmit.m_read++];
+		hal_sspWrite(g_transmit.m_buf[g_transmit.m_read++]);
 		g_transmit.m_len--;
+		n++;
 	}
 #endif
+	return n;
+}
+
+void SSP1_IRQHandler(void)
+{
+	uint32_t d; 
+
+	// toggle SPI_SS so we can receive the next word
+	hal_spiSelect(0);
+	d = hal_sspRead(); // grab data
+	hal_spiSelect(1);
+
+	transmit();
 
 	// receive data
 	if (RECEIVE_LEN()<SPI_RECEIVEBUF_SIZE)
@@ -107,7 +116,7 @@ void SSP1_IRQHandler(void)
 	}
 	
 	// clear interrupt
-	LPC_SSP1->DR = SSP_INTCFG_RT;  
+	hal_sspClearInt();
 }
 
 int spi_receive(uint16_t *buf, uint32_t len)
@@ -136,12 +145,20 @@ void spi_setCallback(TransmitCallback callback)
 {
 	g_transmit.m_callback = callback;
 }
+
+uint32_t spi_refill()
+{
+	uint32_t n;
+
+	hal_sspDisableInt();
+	n = transmit();
+	hal_sspEnableInt();
+
+	return n;
+}
 	
 void spi_init()
 {
-	uint32_t i;
-	volatile uint32_t d;
-	SSP_CFG_Type configStruct;
 
 	g_receive.m_buf = new uint16_t[SPI_RECEIVEBUF_SIZE];
 	g_receive.m_read = 0;
@@ -155,31 +172,12 @@ void spi_init()
 
 	g_transmit.m_callback = (TransmitCallback)NULL;
 
-	configStruct.CPHA = SSP_CPHA_FIRST;
-	configStruct.CPOL = SSP_CPOL_HI;
-	configStruct.ClockRate = 204000000;
-	configStruct.Databit = SSP_DATABIT_16;
-	configStruct.Mode = SSP_SLAVE_MODE;
-	configStruct.FrameFormat = SSP_FRAME_SPI;
-
-	// Initialize SSP peripheral with parameter given in structure above
-	SSP_Init(LPC_SSP1, &configStruct);
-
-	// clear receive fifo
-	for (i=0; i<8; i++)
-		d = LPC_SSP1->DR;
-
-	// Enable SSP peripheral
-	SSP_Cmd(LPC_SSP1, ENABLE);
-		
-	SSP_ClearIntPending(LPC_SSP1, SSP_INTCFG_RT);
-	SSP_IntConfig(LPC_SSP1, SSP_INTCFG_RT, ENABLE);
+	hal_sspInit();
 
-	// sync
+	// sync
 	spi_sync();					
 
 	// enable interrupt
-	NVIC_SetPriority(SSP1_IRQn, 0);	// high priority interrupt
-	NVIC_EnableIRQ(SSP1_IRQn);
+	hal_sspEnableInt();
 
 }
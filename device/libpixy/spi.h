@@ -11,6 +11,11 @@ int spi_checkIdle();
 int spi_sync();
 int spi_receive(uint16_t *buf, uint32_t len);
 void spi_setCallback(TransmitCallback callback);
+// The SSP interrupt only comes when the master clocks a word, so what the callback has
+// ready after the FIFO has drained waits for the next word.  Calling this from the main
+// loop when there's something new (eg after bo_write) puts it in the FIFO right away,
+// returns the number of words it put there.
+uint32_t spi_refill();
 void spi_init();
 
 #endif
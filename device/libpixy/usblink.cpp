@@ -1,12 +1,12 @@
 #include <string.h>
-#include "lpc_types.h"
+#include "lpc_types.h"
 #include "pixyvals.h"
 #include "usb.h"
-#include "usbcfg.h"
+#include "usbcfg.h"
 #include "usblink.h"
 #include "usbuser.h"
 #include "usbhw.h"
-#include "lpc43xx.h"
+#include "hal.h"
 
 #define GBUF_SIZE 64
 
@@ -31,12 +31,12 @@ int USBLink::send(const uint8_t *data, uint32_t len, uint16_t timeoutMs)
 		g_complete = 0;
 		return -1;
 	}
-
+
 	USB_Send(data, len);
 	while(1)
 	{
 		start = g_timerStart; // avoid race condition with usb interrupt routine-- sample here 
-		time = LPC_TIMER1->TC; // time is guaranteed to be more recent than start
+		time = hal_ticks(); // time is guaranteed to be more recent than start
 		if ((uint32_t)(time-start) > timeout || g_complete)
 			break;
 	}
@@ -59,7 +59,7 @@ int USBLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
 		g_complete = 0;
 		return -1;
 	}
-
+
 	if (timeout==0) // this is special case... 
 	{
 		if (len>GBUF_SIZE || g_bufUsed!=0&&g_bufUsed!=len)
@@ -90,7 +90,7 @@ int USBLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
 	while(1)
 	{
 		start = g_timerStart; // avoid race condition with usb interrupt routine-- sample here 
-		time = LPC_TIMER1->TC; // time is guaranteed to be more recent than start
+		time = hal_ticks(); // time is guaranteed to be more recent than start
 		if ((uint32_t)(time-start) > timeout || g_complete)
 			break;
 	}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "colorlut.h"
+#include "clut.h"
+
+// clut-check compares the LUT rows cc_setModel makes with cl_model and cl_row (colorlut.h)
+// against the LUT PixyMon's CLUT (host/pixymon/clut.cpp) makes from the same box.
+//
+//   clut-check [-n tests]
+//
+// Each test is a frame of a random color with random noise, and a random box in it.  CLUT
+// gets the box's pixels the way PixyMon's getStats takes them from the frame.  The fixed
+// point lines round differently than CLUT's doubles, so cells along the model's edge can
+// differ (and a row's run end can move a lot where a line is nearly along the row).  The
+// check fails if a cell differs that CLUT's lines (CLUT::plotcluster) don't pass within
+// a cell of.
+
+#define WIDTH   320
+#define HEIGHT  200
+
+#define CELL(rg, bg)    ((uint8_t)(rg)<<8 | (uint8_t)(bg))
+
+static double g_slopes[4], g_offsets[4];
+
+// same test as CLUT's generatelut, cell (rg, bg) is at (rg/127, bg/127)
+static bool inModel(double rg, double bg)
+{
+	double y[4];
+	int i;
+
+	for (i=0; i<4; i++)
+		y[i] = g_slopes[i]*rg/127 + g_offsets[i];
+	bg /= 127;
+	return bg<y[0] && bg<y[2] && bg>y[1] && bg>y[3];
+}
+
+// is there a point within a cell of cell (rg, bg) that's in the model if set is, in tenths
+// of a cell
+static bool withinCell(int rg, int bg, bool set)
+{
+	int i, j;
+
+	for (i=-10; i<=10; i++)
+	{
+		for (j=-10; j<=10; j++)
+		{
+			if (inModel(rg + i/10.0, bg + j/10.0)==set)
+				return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, j, x, y, c, test, tests = 2000, spread, x0, y0, width, height;
+	int base[3];
+	int16_t begin, end;
+	uint32_t cells = 0, cellsOff = 0, cellsBad = 0, failed = 0;
+	bool set;
+	std::vector<uint8_t> frame(WIDTH*HEIGHT), scratch(CL_SCRATCH_SIZE), lut(0x10000);
+	std::vector<uint32_t> pixels;
+	ColorModel model;
+	CLUT clut;
+	double *lines[] = {g_slopes, g_offsets};
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n")==0 && i+1<argc)
+			tests = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: clut-check [-n tests]\n");
+			return 1;
+		}
+	}
+
+	srand(5);
+	for (test=0; test<tests; test++)
+	{
+		// red, green, blue, every so often with red and green the same, so the mean is near an axis
+		for (c=0; c<3; c++)
+			base[c] = rand()%256;
+		if (test%7==0)
+			base[1] = base[0];
+		spread = 1 + rand()%(test%5==0 ? 120 : 40);
+		// Bayer: blue, green on even lines, green, red on odd lines
+		for (y=0; y<HEIGHT; y++)
+		{
+			for (x=0; x<WIDTH; x++)
+			{
+				c = y&1 ? (x&1 ? 0 : 1) : (x&1 ? 1 : 2);
+				frame[y*WIDTH + x] = std::min(255, std::max(0, base[c] + rand()%spread - spread/2));
+			}
+		}
+		x0 = rand()%300;
+		y0 = 1 + rand()%180;
+		width = 2 + rand()%(WIDTH-x0);
+		height = 2 + rand()%(HEIGHT-y0);
+
+		pixels.clear();
+		for (i=y0|1; i<y0+height && i<HEIGHT; i+=2)
+		{
+			for (j=x0|1; j<x0+width && j<WIDTH; j+=2)
+			{
+				pixels.push_back(frame[i*WIDTH + j]);
+				pixels.push_back(frame[i*WIDTH - WIDTH + j]);
+				pixels.push_back(frame[i*WIDTH - WIDTH + j - 1]);
+			}
+		}
+		if (pixels.empty())
+			continue;
+		clut.generateFromImgSample(&pixels[0], pixels.size(), &lut[0]);
+		clut.plotcluster(&pixels[0], pixels.size(), lines);
+
+		if (cl_model(&frame[0], WIDTH, HEIGHT, x0, y0, width, height, &scratch[0], scratch.size(), &model)<0)
+		{
+			printf("test %d: cl_model failed on %d %d %d %d\n", test, x0, y0, width, height);
+			failed++;
+			continue;
+		}
+
+		for (i=-128; i<128; i++)
+		{
+			cl_row(&model, i, &begin, &end);
+			for (j=-128; j<128; j++)
+			{
+				set = j>=begin && j<end;
+				cells += set;
+				if ((lut[CELL(i, j)]!=0)==set)
+					continue;
+				if (withinCell(i, j, set))
+					cellsOff++;
+				else if (cellsBad++<10)
+					printf("test %d cell %d, %d: CLUT %d, cl_row [%d, %d)\n", test, i, j, lut[CELL(i, j)], begin, end);
+			}
+		}
+	}
+
+	printf("%d tests, %u cells in the models, %u differ within a cell of CLUT's lines, %u further, %u cl_model failures\n", 
+		tests, cells, cellsOff, cellsBad, failed);
+	return cellsBad || failed ? 1 : 0;
+}
@@ -0,0 +1,419 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include "hal.h"
+#include "cameravals.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE MAP_FIXED
+#endif
+
+#define SIM_WIDTH       CAM_RES1_WIDTH  // raw pixels per line
+#define SIM_HEIGHT      CAM_RES1_HEIGHT // lines per frame
+#define SIM_VBLANK      8   // port reads with vsync high
+#define SIM_HBLANK      4   // port reads with hsync low before each line
+
+// synthetic scene
+#define SIM_RADIUS      20  // disk radius, CAM_RES2 pixels
+#define SIM_ORBIT       50  // radius of the circle the disk moves on
+#define SIM_PERIOD      4000000 // us per orbit
+#define SIM_PIXELS_PER_STEP  0.3 // how far the image moves per servo position step
+#define SIM_SERVO_SLEW  3   // servo position steps per ms the servos can move
+
+// SSP
+#define SIM_SSP_FIFO    8   // transmit FIFO, words
+#define SIM_SSP_IDLE    0   // what goes out when it's empty
+
+volatile uint32_t g_halSccbPort = 0;
+volatile uint32_t g_halSccbDir = 0;
+
+static const struct
+{
+	uint32_t loc;
+	uint32_t size;
+}
+g_banks[] =
+{
+	{SRAM0_LOC, SRAM0_SIZE},
+	{SRAM1_LOC, SRAM1_SIZE},
+	{SRAM2_LOC, SRAM2_SIZE + SRAM3_SIZE + SRAM4_SIZE} // contiguous
+};
+
+static std::chrono::steady_clock::time_point g_start = std::chrono::steady_clock::now();
+
+static std::mutex g_eventMutex;
+static std::condition_variable g_eventCond;
+static uint32_t g_event = 0;
+static thread_local uint32_t g_eventSeen = 0;
+
+// camera
+static std::vector<uint8_t> g_frames; // recorded frames, empty for the synthetic scene
+static std::vector<uint8_t> g_frame(SIM_WIDTH*SIM_HEIGHT);
+static uint32_t g_camFrame = 0, g_camLine = 0, g_camStep = 0;
+static bool g_camVsync = true;
+static std::mutex g_targetMutex;
+static int32_t g_targetX = 0, g_targetY = 0;
+
+static std::atomic<uint16_t> g_servoPwm[2];
+static std::atomic<uint8_t> g_servoEnabled[2];
+static double g_servoActual[2] = {1500, 1500}; // where the servos are, the camera port's
+static uint32_t g_servoTime = 0;
+
+static std::mutex g_sspMutex;
+static std::deque<uint16_t> g_sspFifo;
+static std::vector<uint16_t> g_sspSent;
+
+int hal_init(void)
+{
+	uint32_t i;
+	void *p;
+	sigset_t set;
+
+	// the servo timer is SIGALRM, which only the thread that calls hal_servoEnableInt
+	// (the M4's) takes, the threads started from here on have it blocked
+	sigemptyset(&set);
+	sigaddset(&set, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	for (i=0; i<sizeof(g_banks)/sizeof(g_banks[0]); i++)
+	{
+		p = mmap((void *)(uintptr_t)g_banks[i].loc, g_banks[i].size, PROT_READ|PROT_WRITE, 
+			MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+		if (p!=(void *)(uintptr_t)g_banks[i].loc)
+		{
+			fprintf(stderr, "hal_init: can't map SRAM at 0x%x\n", g_banks[i].loc);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+uint32_t hal_ticks(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-g_start).count()*(CLKFREQ/1000000)/1000;
+}
+
+uint32_t hal_us(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-g_start).count();
+}
+
+void hal_initNotify(void)
+{
+}
+
+void hal_notify(void)
+{
+	std::lock_guard<std::mutex> lock(g_eventMutex);
+	g_event++;
+	g_eventCond.notify_all();
+}
+
+void hal_wait(void)
+{
+	std::unique_lock<std::mutex> lock(g_eventMutex);
+	g_eventCond.wait_for(lock, std::chrono::milliseconds(1), []{return g_event!=g_eventSeen;});
+	g_eventSeen = g_event;
+}
+
+void hal_waitUntil(uint32_t deadline)
+{
+	std::unique_lock<std::mutex> lock(g_eventMutex);
+	int32_t left = deadline - hal_ticks();
+
+	if (left>0)
+		g_eventCond.wait_for(lock, std::chrono::microseconds(left/CLKFREQ_US + 1), []{return g_event!=g_eventSeen;});
+	g_eventSeen = g_event;
+}
+
+static uint32_t simRandom(uint32_t *seed)
+{
+	*seed = *seed*1103515245 + 12345;
+	return (*seed>>16)&0x7fff;
+}
+
+// The servos' plant: each servo moves toward its pulse width at SIM_SERVO_SLEW, and
+// stays put while it's disabled.
+static void moveServos(uint32_t now)
+{
+	uint32_t i;
+	double step = (double)(now - g_servoTime)*SIM_SERVO_SLEW/1000, d;
+
+	for (i=0; i<2; i++)
+	{
+		if (!g_servoEnabled[i])
+			continue;
+		d = g_servoPwm[i] - g_servoActual[i];
+		g_servoActual[i] += d>step ? step : d<-step ? -step : d;
+	}
+	g_servoTime = now;
+}
+
+// Bayer, even lines are blue, green and odd lines green, red
+static void renderSynthetic(uint32_t n)
+{
+	uint32_t x, y, seed = n, now = hal_us();
+	int32_t tx, ty, dx, dy, r, g, b, v;
+	double a = 2*M_PI*(now%SIM_PERIOD)/SIM_PERIOD;
+
+	moveServos(now);
+
+	// panning right (up) moves the scene left (down)
+	tx = CAM_RES2_WIDTH/2 + SIM_ORBIT*cos(a) - (g_servoActual[0]-1500)*SIM_PIXELS_PER_STEP;
+	ty = CAM_RES2_HEIGHT/2 + SIM_ORBIT*sin(a) + (g_servoActual[1]-1500)*SIM_PIXELS_PER_STEP;
+	{
+		std::lock_guard<std::mutex> lock(g_targetMutex);
+		g_targetX = tx;
+		g_targetY = ty;
+	}
+
+	for (y=0; y<SIM_HEIGHT; y++)
+	{
+		for (x=0; x<SIM_WIDTH; x++)
+		{
+			dx = (int32_t)x/2 - tx;
+			dy = (int32_t)y/2 - ty;
+			if (dx*dx + dy*dy<SIM_RADIUS*SIM_RADIUS)
+			{
+				r = 200;
+				g = 60;
+				b = 50;
+			}
+			else
+				r = g = b = 100;
+			if (y&1)
+				v = x&1 ? r : g;
+			else
+				v = x&1 ? g : b;
+			v += (int32_t)simRandom(&seed)%9 - 4;
+			g_frame[y*SIM_WIDTH + x] = v<0 ? 0 : v>255 ? 255 : v;
+		}
+	}
+}
+
+static void nextFrame(void)
+{
+	uint32_t n = g_frames.size()/(SIM_WIDTH*SIM_HEIGHT);
+
+	if (n)
+		memcpy(&g_frame[0], &g_frames[(g_camFrame%n)*SIM_WIDTH*SIM_HEIGHT], SIM_WIDTH*SIM_HEIGHT);
+	else
+		renderSynthetic(g_camFrame);
+}
+
+uint32_t hal_camPort(void)
+{
+	uint32_t step;
+
+	if (g_camVsync)
+	{
+		if (g_camStep==0)
+			nextFrame();
+		if (++g_camStep<SIM_VBLANK)
+			return HAL_CAM_VSYNC;
+		g_camVsync = false;
+		g_camLine = g_camStep = 0;
+		return HAL_CAM_VSYNC;
+	}
+
+	step = g_camStep++;
+	if (step<SIM_HBLANK)
+		return 0;
+	step -= SIM_HBLANK;
+	if (step<SIM_WIDTH*2)
+		return HAL_CAM_HSYNC | (step&1 ? HAL_CAM_PCLK : 0) | g_frame[g_camLine*SIM_WIDTH + step/2];
+
+	// end of line
+	g_camStep = 0;
+	if (++g_camLine==SIM_HEIGHT)
+	{
+		g_camFrame++;
+		g_camVsync = true;
+	}
+	return 0;
+}
+
+int hal_simCamOpen(const char *filename)
+{
+	FILE *file;
+	char magic[3];
+	uint32_t width, height, max;
+	long size;
+
+	g_frames.clear();
+	if (filename==NULL)
+	{
+		renderSynthetic(g_camFrame); // so hal_simCamTarget is good before the first frame
+		return 0;
+	}
+	if ((file=fopen(filename, "rb"))==NULL)
+		return -1;
+	if (fscanf(file, "%2s", magic)==1 && strcmp(magic, "P5")==0)
+	{
+		if (fscanf(file, "%u %u %u", &width, &height, &max)!=3 || width!=SIM_WIDTH || height%SIM_HEIGHT || max>255)
+		{
+			fclose(file);
+			return -2;
+		}
+		fgetc(file); // single whitespace after the header
+		size = width*height;
+	}
+	else
+	{
+		fseek(file, 0, SEEK_END);
+		size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		size -= size%(SIM_WIDTH*SIM_HEIGHT);
+	}
+	g_frames.resize(size);
+	if (size==0 || fread(&g_frames[0], 1, size, file)!=(size_t)size)
+	{
+		g_frames.clear();
+		fclose(file);
+		return -3;
+	}
+	fclose(file);
+	return 0;
+}
+
+uint32_t hal_simCamFrames(void)
+{
+	return g_frames.size()/(SIM_WIDTH*SIM_HEIGHT);
+}
+
+uint32_t hal_simCamFrame(void)
+{
+	return g_camFrame;
+}
+
+void hal_simCamTarget(int32_t *x, int32_t *y)
+{
+	std::lock_guard<std::mutex> lock(g_targetMutex);
+	*x = g_targetX;
+	*y = g_targetY;
+}
+
+void hal_servoSet(uint8_t channel, uint16_t pwm)
+{
+	g_servoPwm[channel] = pwm;
+}
+
+void hal_servoEnable(uint8_t channel, uint8_t enable)
+{
+	g_servoEnabled[channel] = enable;
+}
+
+extern "C" void SCT_IRQHandler(void);
+
+// SIGALRM is taken by the M4's thread, so like the interrupt it preempts the main loop
+static void servoTimer(int sig)
+{
+	SCT_IRQHandler();
+}
+
+void hal_servoEnableInt(void)
+{
+	struct sigaction sa;
+	struct itimerval timer;
+	sigset_t set;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = servoTimer;
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &sa, NULL);
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = HAL_SERVO_PERIOD;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_REAL, &timer, NULL);
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGALRM);
+	pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+}
+
+void hal_servoClearInt(void)
+{
+}
+
+uint16_t hal_simServo(uint8_t channel)
+{
+	return g_servoEnabled[channel] ? g_servoPwm[channel].load() : 0;
+}
+
+void hal_sspInit(void)
+{
+}
+
+void hal_sspEnableInt(void)
+{
+}
+
+void hal_sspDisableInt(void)
+{
+}
+
+void hal_sspClearInt(void)
+{
+}
+
+uint32_t hal_sspWritable(void)
+{
+	std::lock_guard<std::mutex> lock(g_sspMutex);
+	return g_sspFifo.size()<SIM_SSP_FIFO;
+}
+
+void hal_sspWrite(uint16_t data)
+{
+	std::lock_guard<std::mutex> lock(g_sspMutex);
+	if (g_sspFifo.size()<SIM_SSP_FIFO)
+		g_sspFifo.push_back(data);
+}
+
+uint16_t hal_sspRead(void)
+{
+	return 0;
+}
+
+void hal_spiSelect(uint8_t select)
+{
+}
+
+uint32_t hal_spiClock(void)
+{
+	return 0;
+}
+
+void hal_simSspClock(void)
+{
+	std::lock_guard<std::mutex> lock(g_sspMutex);
+
+	if (g_sspFifo.empty())
+		g_sspSent.push_back(SIM_SSP_IDLE);
+	else
+	{
+		g_sspSent.push_back(g_sspFifo.front());
+		g_sspFifo.pop_front();
+	}
+}
+
+uint32_t hal_simSspSent(uint16_t *data, uint32_t len)
+{
+	std::lock_guard<std::mutex> lock(g_sspMutex);
+
+	if (len>g_sspSent.size())
+		len = g_sspSent.size();
+	memcpy(data, &g_sspSent[0], len*sizeof(uint16_t));
+	g_sspSent.erase(g_sspSent.begin(), g_sspSent.begin()+len);
+	return len;
+}
@@ -0,0 +1,90 @@
+#ifndef _HAL_SIM_H
+#define _HAL_SIM_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// see hal.h, these are the simulation's versions (hal_sim.cpp)
+
+extern volatile uint32_t g_halSccbPort;
+extern volatile uint32_t g_halSccbDir;
+
+#define HAL_SCCB_PORT       g_halSccbPort
+#define HAL_SCCB_DIR        g_halSccbDir
+
+// from lpc_types.h, which the sim doesn't include
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+// maps the SRAM banks at their pixyvals.h addresses, call before anything else
+int hal_init(void);
+
+uint32_t hal_ticks(void);
+uint32_t hal_us(void);
+
+// one event for both cores, hal_wait returns when there's been a hal_notify since the
+// calling thread's last hal_wait, or after 1 ms, as if an interrupt had come.
+// hal_waitUntil returns at the hal_notify or at deadline (hal_ticks), nothing else.
+void hal_initNotify(void);
+void hal_notify(void);
+void hal_wait(void);
+void hal_waitUntil(uint32_t deadline);
+
+// the camera port plays back Bayer frames of CAM_RES1_WIDTH by CAM_RES1_HEIGHT
+// (the camera's mode 1), each read is one step: vsync, then for each line a few reads of
+// blanking and 2 reads per pixel (pclk low, then high).  So the port keeps pace with
+// whoever reads it.
+uint32_t hal_camPort(void);
+
+void hal_servoSet(uint8_t channel, uint16_t pwm);
+void hal_servoEnable(uint8_t channel, uint8_t enable);
+// the servo timer is a SIGALRM every HAL_SERVO_PERIOD, which calls SCT_IRQHandler on the
+// thread that called hal_servoEnableInt (hal_init blocks it for the others)
+void hal_servoEnableInt(void);
+void hal_servoClearInt(void);
+
+void hal_sspInit(void);
+void hal_sspEnableInt(void);
+void hal_sspDisableInt(void);
+void hal_sspClearInt(void);
+uint32_t hal_sspWritable(void);
+void hal_sspWrite(uint16_t data);
+uint16_t hal_sspRead(void);
+void hal_spiSelect(uint8_t select);
+uint32_t hal_spiClock(void);
+
+// simulation only
+
+// frames to play back: raw 8-bit Bayer frames back to back, or a binary PGM (P5) of
+// one or more frames stacked vertically.  NULL (or no call) plays a synthetic scene,
+// a colored disk moving over a gray background.
+int hal_simCamOpen(const char *filename);
+uint32_t hal_simCamFrames(void);
+// frames the port has played so far
+uint32_t hal_simCamFrame(void);
+// synthetic scene: where the disk is in the frame the port is on, in CAM_RES2 coordinates.
+// The disk goes around a circle every 4 seconds, and the servos move the camera--- channel
+// 0 pans and channel 1 tilts, as with the real pan/tilt mechanism.  The servos take time
+// to get to their positions (SIM_SERVO_SLEW).
+void hal_simCamTarget(int32_t *x, int32_t *y);
+
+// servo pulse width last set, 0 if the channel is disabled
+uint16_t hal_simServo(uint8_t channel);
+
+// The SSP is a slave with an 8 word transmit FIFO, as on the LPC43xx.  hal_simSspClock is
+// the master clocking one word out of it (0 if the FIFO is empty), after which whoever
+// runs the simulation should call SSP1_IRQHandler, as the word the master sent in
+// exchange raises the interrupt.  hal_simSspSent takes the words clocked out so far,
+// returns how many were copied.
+void hal_simSspClock(void);
+uint32_t hal_simSspSent(uint16_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "qval.h"
+#include "lutcompact.h"
+#include "rlsemu.h"
+
+// lut-check compares the two-level LUT (lutcompact.h) against the flat LUT it stands for,
+// built all at once with lut_build and changed a run at a time with lut_set, as cc_setModel
+// and cc_setLut do, and the q vals rlsemu's model of getRLSFrame (rls_emuFrame) makes with
+// each.
+//
+//   lut-check [-n tests]
+//
+// Each test makes a flat LUT with runs of models set and cleared, rows cleared whole (so
+// their pages go back) and every so often the whole LUT cleared, doing the same to the
+// incremental LUT with lut_set.  Every cell of both two-level LUTs has to be the flat LUT's,
+// each has to use a page for each row that isn't empty, and the q vals of a frame of random
+// blocks have to be the same with all three.
+
+#define WIDTH       320 // q val resolution, the frame is twice this
+#define HEIGHT      200
+#define MEMORY      0x20000
+#define LUT_SIZE    0x8000 // LUT_MEMORY_SIZE, conncomp.h
+#define OPS         40
+
+// a byte that looks random, from a block and where the pixel is in its Bayer cell
+static uint8_t mix(uint32_t v)
+{
+	v *= 2654435761u;
+	v ^= v>>15;
+	v *= 2246822519u;
+	return v>>24;
+}
+
+// rows of the flat LUT with something in them
+static uint32_t rowsUsed(const std::vector<uint8_t> &flat)
+{
+	uint32_t row, i, n;
+
+	for (row=0, n=0; row<LUT_ROWS; row++)
+	{
+		for (i=0; i<LUT_PAGE_SIZE && flat[(row<<8)+i]==0; i++);
+		n += i<LUT_PAGE_SIZE;
+	}
+	return n;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, test, tests = 300, op, x, y, blockWidth, n, nb, ni;
+	uint32_t row, rows, begin, len, index, pages, cellsBad = 0, pagesBad = 0, qvalsBad = 0, failed = 0;
+	uint8_t value, shiftLut[WIDTH+1];
+	std::vector<uint8_t> flat(LUT_FLAT_SIZE), next(LUT_FLAT_SIZE), built(LUT_SIZE), inc(LUT_SIZE), frame(WIDTH*2*HEIGHT*2);
+	std::vector<uint32_t> qvals(MEMORY/sizeof(uint32_t)), qvalsBuilt(MEMORY/sizeof(uint32_t)), qvalsInc(MEMORY/sizeof(uint32_t));
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n")==0 && i+1<argc)
+			tests = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: lut-check [-n tests]\n");
+			return 1;
+		}
+	}
+
+	// same as getRLSFrame's in m0_sim.c
+	for (i=0; i<=WIDTH; i++)
+		shiftLut[i] = 3;
+	pages = (LUT_SIZE-LUT_TABLE_SIZE-LUT_PAGE_SIZE)/LUT_PAGE_SIZE;
+
+	srand(3);
+	for (test=0; test<tests; test++)
+	{
+		memset(&flat[0], 0, flat.size());
+		lut_init(&inc[0], inc.size());
+		for (op=0; op<OPS; op++)
+		{
+			next = flat;
+			if (rand()%20==0)
+			{
+				// cc_setLut with LUT_FLAG_CLEAR
+				if (lut_set(&inc[0], inc.size(), 0, LUT_FLAT_SIZE, 0)<0)
+					failed++;
+				memset(&flat[0], 0, flat.size());
+				continue;
+			}
+			// a model's rows, each a run, as cc_setModel sets them, or runs and whole rows cleared
+			value = rand()%3 ? 1 + rand()%7 : 0;
+			row = rand()%LUT_ROWS;
+			rows = 1 + rand()%(value ? 30 : 10);
+			for (; rows && row<LUT_ROWS; rows--, row++)
+			{
+				if (value==0 && rand()%4==0)
+				{
+					begin = 0;
+					len = LUT_PAGE_SIZE;
+				}
+				else
+				{
+					begin = rand()%LUT_PAGE_SIZE;
+					len = 1 + rand()%(LUT_PAGE_SIZE-begin);
+				}
+				memset(&next[(row<<8)+begin], value, len);
+			}
+			// lut_set leaves the rows before the one it runs out of pages on set, so don't
+			// go past the pages
+			if (rowsUsed(next)>pages)
+				continue;
+			for (index=0; index<LUT_FLAT_SIZE; index+=len)
+			{
+				for (len=0; index+len<LUT_FLAT_SIZE && next[index+len]==next[index] && next[index+len]!=flat[index+len]; len++);
+				if (len==0)
+				{
+					len = 1;
+					continue;
+				}
+				if (lut_set(&inc[0], inc.size(), index, len, next[index])<0)
+					failed++;
+			}
+			flat = next;
+		}
+		if (lut_build(&built[0], built.size(), &flat[0])<0)
+			failed++;
+
+		for (index=0; index<LUT_FLAT_SIZE; index++)
+		{
+			if (LUT_GET(&built[0], index)!=flat[index] || LUT_GET(&inc[0], index)!=flat[index])
+			{
+				if (cellsBad++<10)
+					printf("test %d cell 0x%04x: flat %d, lut_build %d, lut_set %d\n", test, index, flat[index],
+						LUT_GET(&built[0], index), LUT_GET(&inc[0], index));
+			}
+		}
+		if (lut_pagesUsed(&built[0])!=rowsUsed(flat) || lut_pagesUsed(&inc[0])!=rowsUsed(flat))
+		{
+			printf("test %d: %u rows used, lut_build uses %u pages, lut_set %u\n", test, rowsUsed(flat),
+				lut_pagesUsed(&built[0]), lut_pagesUsed(&inc[0]));
+			pagesBad++;
+		}
+
+		// blocks of a color each, so runs form where the color's cell is set
+		blockWidth = 8 + test%20;
+		for (y=0; y<HEIGHT*2; y++)
+		{
+			for (x=0; x<WIDTH*2; x++)
+				frame[y*WIDTH*2 + x] = mix(((test*1000 + y/6)*1000 + x/blockWidth)*4 + (y&1)*2 + (x&1));
+		}
+		n = rls_emuFrame(&frame[0], WIDTH, HEIGHT, &qvals[0], MEMORY, &flat[0], true, shiftLut);
+		nb = rls_emuFrame(&frame[0], WIDTH, HEIGHT, &qvalsBuilt[0], MEMORY, &built[0], false, shiftLut);
+		ni = rls_emuFrame(&frame[0], WIDTH, HEIGHT, &qvalsInc[0], MEMORY, &inc[0], false, shiftLut);
+		if (n<0 || n!=nb || n!=ni || memcmp(&qvals[0], &qvalsBuilt[0], n*sizeof(uint32_t)) ||
+			memcmp(&qvals[0], &qvalsInc[0], n*sizeof(uint32_t)))
+		{
+			printf("test %d: %d q vals with the flat LUT, %d with lut_build's, %d with lut_set's, or they differ\n", test, n, nb, ni);
+			qvalsBad++;
+		}
+	}
+
+	printf("%d tests, %u cells differ, %u page counts differ, %u q val frames differ, %u LUT calls failed\n", tests,
+		cellsBad, pagesBad, qvalsBad, failed);
+	return cellsBad || pagesBad || qvalsBad || failed ? 1 : 0;
+}
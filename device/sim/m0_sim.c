@@ -0,0 +1,163 @@
+#include <stdint.h>
+#include "chirp.h"
+#include "smlink.h"
+#include "hal.h"
+#include "cameravals.h"
+#include "qval.h"
+#include "rlsclip.h"
+
+// The M0's side of the simulation: the M0's Chirp (chirp.c) and link (smlink.c), with
+// getFrame and getRLSFrame reading the camera port in C where main_m0.c uses assembly
+// line routines.  The run-length part is rlsemu's model of those routines (rlsline_sim.cpp).
+
+#define LINE_WIDTH  CAM_RES1_WIDTH // raw pixels per line, the port is in mode 1
+
+uint32_t *sim_rlsLine(const uint8_t *bgLine, const uint8_t *grLine, uint32_t *memory, const uint8_t *lut, 
+	uint32_t width, const uint8_t *shiftLut);
+
+static uint8_t g_logLut[CAM_RES2_WIDTH+1];
+static volatile int g_m0Run = 1;
+static volatile int g_m0Ready = 0;
+static uint32_t g_frameTime = 0; // see main_m0.c
+
+static void skipLine(void)
+{
+	while(!(hal_camPort()&HAL_CAM_HSYNC));
+	while(hal_camPort()&HAL_CAM_HSYNC);
+}
+
+// wait for the remainder of the frame to pass
+static void skipFrame(void)
+{
+	while(!(hal_camPort()&HAL_CAM_VSYNC));
+	while(hal_camPort()&HAL_CAM_VSYNC);
+	g_frameTime = hal_us();
+}
+
+// pixels are latched on the rising edge of pclk
+static void grabLine(uint8_t *line)
+{
+	uint32_t i, p, prev;
+
+	while(!((prev=hal_camPort())&HAL_CAM_HSYNC));
+	for (i=0; i<LINE_WIDTH; prev=p)
+	{
+		p = hal_camPort();
+		if ((p&HAL_CAM_PCLK) && !(prev&HAL_CAM_PCLK))
+			line[i++] = p&HAL_CAM_DATA;
+	}
+	while(hal_camPort()&HAL_CAM_HSYNC);
+}
+
+// CAM_GRAB_M1R1 is the lines as they come, CAM_GRAB_M1R2 takes every other 2x2 Bayer cell
+int32_t getFrame(uint8_t *type, uint32_t *memory, uint16_t *xoffset, uint16_t *yoffset, uint16_t *xwidth, uint16_t *ywidth)
+{
+	uint8_t line[LINE_WIDTH];
+	uint8_t *frame = (uint8_t *)(uintptr_t)*memory;
+	uint32_t i, x, y, y1 = *yoffset + *ywidth;
+
+	if (*type!=CAM_GRAB_M1R1 && *type!=CAM_GRAB_M1R2)
+		return -1;
+
+	skipFrame();
+	for (i=0; i<CAM_RES1_HEIGHT; i++)
+	{
+		if (*type==CAM_GRAB_M1R1)
+			y = i;
+		else if ((i&2)==0)
+			y = (i>>2<<1) + (i&1);
+		else
+		{
+			skipLine();
+			continue;
+		}
+		if (y>=y1)
+			break;
+		if (y<*yoffset)
+		{
+			skipLine();
+			continue;
+		}
+		grabLine(line);
+		for (x=*xoffset; x<*xoffset+*xwidth; x++)
+			*frame++ = line[*type==CAM_GRAB_M1R1 ? x : (x>>1<<2) + (x&1)];
+	}
+
+	CRP_RETURN(UINT32(g_frameTime), END);
+	return 0;
+}
+
+// same as getRLSFrame in main_m0.c
+int32_t getRLSFrame(uint32_t *memory, uint32_t *size /*bytes*/, uint32_t *lut, uint16_t *xoffset, uint16_t *yoffset, uint16_t *xwidth, uint16_t *ywidth)
+{
+	uint8_t bgLine[LINE_WIDTH], grLine[LINE_WIDTH];
+	uint8_t *lut2 = (uint8_t *)(uintptr_t)*lut;
+	uint32_t *memory2 = (uint32_t *)(uintptr_t)*memory;
+	uint32_t *memory2Orig = memory2; 
+	uint32_t *end = (uint32_t *)((uint8_t *)memory2 + *size-CAM_RES2_WIDTH*2-4); // where main_m0.c keeps its line store
+	uint32_t i, line, x1, y1, len;
+
+	for (i=0; i<=CAM_RES2_WIDTH; i++)
+		g_logLut[i] = 3;
+
+	x1 = *xoffset + *xwidth;
+	if (x1>CAM_RES2_WIDTH || *xwidth==0)
+		x1 = CAM_RES2_WIDTH;
+	y1 = *yoffset + *ywidth;
+	if (y1>CAM_RES2_HEIGHT || *ywidth==0)
+		y1 = CAM_RES2_HEIGHT;
+
+	skipFrame();
+	for (line=0; line<*yoffset && line<y1; line++)
+	{
+		*memory2++ = 0x0000;
+		skipLine();
+		skipLine();
+	}
+	for (; line<y1; line++)
+	{
+		*memory2++ = 0x0000; 
+		grabLine(bgLine);
+		grabLine(grLine);
+		memory2 = sim_rlsLine(bgLine, grLine, memory2, lut2, x1, g_logLut);
+		if (end-memory2<CAM_RES2_WIDTH/5)
+		{
+			CRP_RETURN(UINT32(memory2 - memory2Orig), UINT32(g_frameTime), END); 
+			return -1; 
+		}
+	}
+	len = memory2 - memory2Orig;
+	if (*xoffset)
+		len = rls_clipFrame(memory2Orig, len, *xoffset, g_logLut, QVAL_CCQ1);
+	CRP_RETURN(UINT32(len), UINT32(g_frameTime), END); 
+	return 0;
+}
+
+void m0_stop(void)
+{
+	g_m0Run = 0;
+	hal_notify();
+}
+
+// the M4 can't make its ChirpM0 until this is set (see main_sim.cpp)
+int m0_ready(void)
+{
+	return g_m0Ready;
+}
+
+void m0_main(void)
+{
+	linkInit();
+	chirpOpen();
+	chirpSetProc("getFrame", (ProcPtr)getFrame);
+	chirpSetProc("getRLSFrame", (ProcPtr)getRLSFrame);
+	g_m0Ready = 1;
+
+	while(g_m0Run)
+	{
+		// sleep until the M4 sends something
+		if (chirpService()==0)
+			hal_wait();
+	}
+	chirpClose();
+}
@@ -0,0 +1,467 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+#include <vector>
+#include "hal.h"
+#include "pixy_init.h"
+#include "pixyvals.h"
+#include "camera.h"
+#include "rcservo.h"
+#include "conncomp.h"
+#include "servoloop.h"
+#include "prof.h"
+#include "spi.h"
+#include "blobout.h"
+#include "qbuffers.h"
+#include "scheduler.h"
+
+// pixy-sim runs the M4's color connected components and pan/tilt servo loop (main_m4.cpp's
+// servo() and servoTick()) on Linux, with the M0 on a thread of its own (m0_sim.c) and the
+// camera port playing back frames (hal_sim.cpp).  
+//
+//   pixy-sim [-n frames] [-m x,y,width,height] [-s words] [-d us] [-c frames] [-r frames] [-q] [frames.pgm]
+//
+// With no file the camera sees a synthetic scene (hal_simCamTarget) and the model is
+// trained on the disk.  With a file, -m gives the box to train on (CAM_RES2 coordinates).
+// Each frame prints the largest blob, the servo positions and how long since the last
+// frame (unless -q), and the profiling zones (prof.h) and the tasks' times (scheduler.h) are
+// printed at the end.  -d adds us of busy work to each frame, as if processing took longer, the
+// servos still move every HAL_SERVO_PERIOD.
+//
+// The main loop is main_m4.cpp's: tasks on the scheduler, the M0 filling one Q val buffer
+// while the blob task assembles the other.  The blobs also go out the SPI port (blobout.h),
+// and after each frame the SPI master clocks -s words (64 by default) out of the SSP.  The
+// words are decoded with bo_parse and checked against what was written.
+//
+// -c has the usb task call cc_getRLSCC every so many frames, as PixyMon would with the
+// loop running, to check that the frames it grabs (cam_claim) don't stall the loop's.
+// -r has the blob task encode every so many frames' blobs as CCB2 records too, as
+// cc_getRLSCC would (cc_getRecords), decode them with br_decode as PixyMon would, and
+// check that each box is inside the frame and holds its centroid.
+
+#define XCENTER 160
+#define YCENTER 100
+#define QBUFFERS 2
+#define LOST    1000000 // us without a blob before the servos are centered
+
+extern "C" void m0_main(void);
+extern "C" void m0_stop(void);
+extern "C" int m0_ready(void);
+
+ChirpUsb *g_chirpUsb = NULL;
+ChirpM0 *g_chirpM0 = NULL;
+
+extern "C" void SSP1_IRQHandler(void);
+
+static int32_t servoTask(uint32_t budget);
+static int32_t m0Task(uint32_t budget);
+static int32_t spiTask(uint32_t budget);
+static int32_t blobTask(uint32_t budget);
+static int32_t usbTask(uint32_t budget);
+
+static Sched g_sched;
+static SchedTask g_servoTask = {"servo", servoTask,   100, 0};
+static SchedTask g_m0Task =    {"m0",    m0Task,      200, 1, SCHED_POLL};
+static SchedTask g_spiTask =   {"spi",   spiTask,     100, 2};
+static SchedTask g_blobTask =  {"blobs", blobTask,  15000, 3, SCHED_POLL};
+static SchedTask g_usbTask =   {"usb",   usbTask,    2000, 4, SCHED_POLL};
+
+static BlobOut g_blobOut;
+static BoParser g_parser;
+static ServoLoop *g_xloop, *g_yloop;
+static QBuffers g_qbufs;
+static QBuffer *g_qfilling = NULL;
+static uint8_t g_qheld = 0;
+static int32_t g_result = 0;
+static std::vector<std::vector<BoBlob> > g_written;
+static BrEncoder g_encoder;
+static BrDecoder g_decoder;
+
+// options and results
+static const char *g_filename = NULL;
+static int g_frames = 300, g_spiWords = 64, g_delay = 0, g_ccEvery = 0, g_recEvery = 0, g_quiet = 0;
+static int g_frame = 0, g_ccFrame = 0, g_ccCalls = 0, g_ccErrors = 0, g_recFrames = 0, g_recErrors = 0;
+static uint32_t g_lastFrame, g_lastSeen, g_tracked = 0, g_spiFrames = 0, g_spiBad = 0;
+static uint8_t g_centered = 0;
+static double g_offCenter = 0;
+
+static uint32_t transmitCallback(uint16_t *data, uint32_t len)
+{
+	return bo_transmit(&g_blobOut, data, len);
+}
+
+static void servoTick(void)
+{
+	uint32_t time = hal_us();
+
+	g_xloop->tick(time);
+	g_yloop->tick(time);
+	sched_signal(&g_servoTask);
+}
+
+static void getNextFrame(void)
+{
+	if (g_qfilling)
+		return;
+	if ((g_qfilling=qb_produce(&g_qbufs)))
+		cc_getRLSFrame(g_qfilling->memory, g_qfilling->size, LUT_MEMORY, NULL, false);
+}
+
+static int getRLSFrameCallback(const int32_t &responsInt, const uint32_t &numRls, const uint32_t &time)
+{
+	if (g_qfilling==NULL)
+		return 0;
+	if (responsInt<0)
+	{
+		qb_cancel(g_qfilling);
+		g_result = responsInt;
+	}
+	else
+	{
+		g_qfilling->time = time;
+		qb_publish(&g_qbufs, g_qfilling, numRls);
+	}
+	g_qfilling = NULL;
+	return 0;
+}
+
+// same as main_m4.cpp's
+static void claimFrames(void)
+{
+	QBuffer *frame;
+
+	while(g_qfilling)
+		g_chirpM0->service();
+	while((frame=qb_consume(&g_qbufs)))
+		qb_release(frame);
+	g_qheld = 1;
+}
+
+// the servo loops hold when they've nothing new, center them once the target's been lost a while
+static int32_t servoTask(uint32_t budget)
+{
+	if (g_centered || hal_us()-g_lastSeen<LOST)
+		return 0;
+	g_xloop->reset();
+	g_yloop->reset();
+	g_centered = 1;
+	return 1;
+}
+
+static int32_t m0Task(uint32_t budget)
+{
+	int32_t n;
+
+	n = g_chirpM0->service();
+	if (!g_qheld)
+		getNextFrame();
+	return n;
+}
+
+// and the SPI master's side
+static int32_t spiTask(uint32_t budget)
+{
+	int32_t i, j, n;
+	uint16_t sent[0x100];
+
+	spi_refill();
+
+	// the SPI master reads, each word it clocks raises the SSP interrupt
+	for (i=0; i<g_spiWords; i++)
+	{
+		hal_simSspClock();
+		SSP1_IRQHandler();
+	}
+	while((n=hal_simSspSent(sent, sizeof(sent)/sizeof(uint16_t))))
+	{
+		for (j=0; j<n; j++)
+		{
+			if (bo_parse(&g_parser, sent[j]))
+			{
+				g_spiFrames++;
+				// frame numbers are 16 bits
+				i = g_frame-1 - (uint16_t)(g_frame-1 - g_parser.frame);
+				if (g_written[i].size()!=g_parser.numBlobs || 
+					memcmp(&g_written[i][0], g_parser.blobs, g_parser.numBlobs*sizeof(BoBlob)))
+					g_spiBad++;
+			}
+		}
+	}
+	return 1;
+}
+
+static void printFrame(const BoBlob *blobs, int32_t n, int32_t tx, int32_t ty)
+{
+	if (n>0)
+		printf("%5d   %6d %3d %3d %3d", g_frame, blobs[0].x, blobs[0].y, blobs[0].width, blobs[0].height);
+	else
+		printf("%5d        -   -   -   -", g_frame);
+	if (g_filename)
+		printf("          -   -");
+	else
+		printf("   %8d %3d", tx, ty);
+	printf("   %3d %4d   %d\n", rcs_getPos(0), rcs_getPos(1), hal_us()-g_lastFrame);
+}
+
+// decode the frame's CCB2 records as PixyMon would
+static void checkRecords(QBuffer *frame)
+{
+	int32_t i, n;
+	uint32_t len;
+	uint16_t *words;
+	const BrBlob *b;
+
+	len = cc_getRecords(frame->memory, frame->len, &g_encoder, &words);
+	g_recFrames++;
+	if ((n=br_decode(&g_decoder, words, len))<0 || g_decoder.width!=CAM_RES2_WIDTH || g_decoder.height!=CAM_RES2_HEIGHT)
+	{
+		fprintf(stderr, "frame %d: br_decode: %d, %dx%d\n", g_frame, n, g_decoder.width, g_decoder.height);
+		g_recErrors++;
+		return;
+	}
+	for (i=0; i<n; i++)
+	{
+		b = &g_decoder.blobs[i];
+		if (b->left>b->right || b->right>g_decoder.width || b->top>b->bottom || b->bottom>g_decoder.height ||
+			b->x<b->left || b->x>b->right || b->y<b->top || b->y>b->bottom)
+		{
+			fprintf(stderr, "frame %d: blob %d at %d,%d, box %d-%d x %d-%d isn't in the %dx%d frame\n", g_frame, i, 
+				b->x, b->y, b->left, b->right, b->top, b->bottom, g_decoder.width, g_decoder.height);
+			g_recErrors++;
+		}
+	}
+}
+
+static int32_t blobTask(uint32_t budget)
+{
+	int32_t n, tx, ty, x, y;
+	uint32_t start = hal_us(), time;
+	BoBlob blobs[BO_MAX_BLOBS];
+	QBuffer *frame;
+
+	if ((frame=qb_consume(&g_qbufs))==NULL)
+		return 0;
+	hal_simCamTarget(&tx, &ty);
+	n = cc_getBlobs(frame->memory, frame->len, blobs, BO_MAX_BLOBS);
+	time = frame->time;
+	if (g_recEvery && g_frame%g_recEvery==0)
+		checkRecords(frame);
+	qb_release(frame);
+	bo_write(&g_blobOut, blobs, n);
+	g_written.push_back(std::vector<BoBlob>(blobs, blobs+n));
+	sched_signal(&g_spiTask);
+	while(hal_us() - start<(uint32_t)g_delay);
+	PROF_ADD(LATENCY, (hal_us()-time)*CLKFREQ_US);
+	g_offCenter += sqrt((tx-XCENTER)*(tx-XCENTER) + (ty-YCENTER)*(ty-YCENTER));
+
+	if (n>0)
+	{
+		x = blobs[0].x;
+		y = blobs[0].y;
+		g_xloop->measure(x-XCENTER, time);
+		g_yloop->measure(-(y-YCENTER), time);
+		g_lastSeen = hal_us();
+		g_centered = 0;
+		if (!g_filename && (x-tx)*(x-tx) + (y-ty)*(y-ty)<25)
+			g_tracked++;
+	}
+	if (!g_quiet)
+		printFrame(blobs, n, tx, ty);
+	g_lastFrame = hal_us();
+	g_frame++;
+
+	return 1;
+}
+
+// no host in the simulation, but it's serviced as on the M4, and -c makes the calls a host would
+static int32_t usbTask(uint32_t budget)
+{
+	int32_t n;
+
+	n = g_chirpUsb->service();
+	if (g_ccEvery && g_frame-g_ccFrame>=g_ccEvery)
+	{
+		g_ccFrame = g_frame;
+		g_ccCalls++;
+		// with the loop's frame still out, the call would have taken the M0's answer for it
+		if (cc_getRLSCCChirp(g_chirpUsb)<0 || g_qfilling)
+			g_ccErrors++;
+		n++;
+	}
+	g_qheld = 0;
+	return n;
+}
+
+static void printProf()
+{
+	uint32_t i, b;
+	const ProfZone *z;
+
+	printf("zone             count   min us  mean us   max us   log2 clocks histogram\n");
+	for (i=0; i<PROF_NUM_ZONES; i++)
+	{
+		z = prof_zone(i);
+		if (z->count==0)
+			continue;
+		printf("%-14s %7u %8u %8u %8u  ", prof_name(i), z->count, z->min/CLKFREQ_US, 
+			(uint32_t)(z->sum/z->count/CLKFREQ_US), z->max/CLKFREQ_US);
+		for (b=0; b<PROF_BINS; b++)
+		{
+			if (z->hist[b])
+				printf(" <2^%u:%u", b, z->hist[b]);
+		}
+		printf("\n");
+	}
+}
+
+static void printSched(uint32_t elapsed)
+{
+	uint32_t i;
+	const SchedTask *t;
+
+	printf("task     runs   worked  overruns   total ms  mean us   max us  max wait us   %%\n");
+	for (i=0; i<g_sched.num; i++)
+	{
+		t = g_sched.tasks[i];
+		printf("%-6s %7u  %7u  %8u  %9u  %7u  %7u  %11u  %3u\n", t->name, t->runs, t->worked, t->overruns,
+			(uint32_t)(t->total/CLKFREQ_MS), t->runs ? (uint32_t)(t->total/t->runs/CLKFREQ_US) : 0, 
+			t->max/CLKFREQ_US, t->maxWait/CLKFREQ_US, (uint32_t)(t->total/CLKFREQ_US*100/elapsed));
+	}
+	printf("idle   %7u                      %9u                                 %3u\n", g_sched.idles,
+		(uint32_t)(g_sched.idleTotal/CLKFREQ_MS), (uint32_t)(g_sched.idleTotal/CLKFREQ_US*100/elapsed));
+	printf("%u rounds\n", g_sched.rounds);
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: pixy-sim [-n frames] [-m x,y,width,height] [-s words] [-d us] [-c frames] [-r frames] [-q] [frames.pgm]\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	int i, result;
+	int model[4] = {-1, -1, -1, -1};
+	uint32_t start;
+	int32_t tx, ty;
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n")==0 && i+1<argc)
+			g_frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s")==0 && i+1<argc)
+			g_spiWords = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-d")==0 && i+1<argc)
+			g_delay = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c")==0 && i+1<argc)
+			g_ccEvery = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-r")==0 && i+1<argc)
+			g_recEvery = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-q")==0)
+			g_quiet = 1;
+		else if (strcmp(argv[i], "-m")==0 && i+1<argc)
+		{
+			if (sscanf(argv[++i], "%d,%d,%d,%d", &model[0], &model[1], &model[2], &model[3])!=4)
+				usage();
+		}
+		else if (argv[i][0]=='-')
+			usage();
+		else
+			g_filename = argv[i];
+	}
+	if (g_filename && model[0]<0)
+		usage();
+
+	if (hal_init()<0)
+	{
+		fprintf(stderr, "can't map SRAM at its pixyvals.h addresses\n");
+		return 1;
+	}
+	if (hal_simCamOpen(g_filename)<0)
+	{
+		fprintf(stderr, "can't read %s\n", g_filename);
+		return 1;
+	}
+
+	// same order as pixyInit() and main() in main_m4.cpp, the M0 has to be servicing
+	// Chirp before ChirpM0 is created
+	sm_init();
+	std::thread m0(m0_main);
+	while(!m0_ready())
+		std::this_thread::yield();
+	g_chirpUsb = new ChirpUsb();
+	g_chirpM0 = new ChirpM0();
+	cam_init();
+	rcs_init();
+	cc_init(g_chirpUsb);
+	prof_init(g_chirpUsb);
+	spi_init();
+	bo_init(&g_blobOut);
+	bo_parserInit(&g_parser);
+	spi_setCallback(transmitCallback);
+	br_encoderInit(&g_encoder, CC_KEY_INTERVAL);
+	br_decoderInit(&g_decoder);
+	g_chirpM0->getProc("getRLSFrame", (ProcPtr)getRLSFrameCallback);
+
+	if (model[0]<0)
+	{
+		hal_simCamTarget(&tx, &ty);
+		model[0] = tx-10;
+		model[1] = ty-10;
+		model[2] = 20;
+		model[3] = 20;
+	}
+	if ((result=cc_setModel(1, model[0], model[1], model[2], model[3]))<0)
+	{
+		fprintf(stderr, "cc_setModel: %d\n", result);
+		g_frames = 0;
+	}
+
+	ServoLoop xloop(0, 400, 1000);
+	ServoLoop yloop(1, 400, 1000);
+	g_xloop = &xloop;
+	g_yloop = &yloop;
+	rcs_setTickCallback(servoTick);
+
+	qb_init(&g_qbufs, RLS_MEMORY, RLS_MEMORY_SIZE, QBUFFERS);
+	cam_setClaimCallback(claimFrames);
+	sched_init(&g_sched);
+	sched_add(&g_sched, &g_servoTask);
+	sched_add(&g_sched, &g_m0Task);
+	sched_add(&g_sched, &g_spiTask);
+	sched_add(&g_sched, &g_blobTask);
+	sched_add(&g_sched, &g_usbTask);
+
+	if (!g_quiet)
+		printf("frame   blob x   y   w   h   target x   y   pan tilt   us\n");
+	start = g_lastFrame = g_lastSeen = hal_us();
+	// sched_run, until we've had the frames
+	while(g_frame<g_frames && g_result>=0)
+	{
+		if (sched_round(&g_sched)==0)
+			sched_idle(&g_sched);
+	}
+	if (g_result<0)
+		fprintf(stderr, "cc_getRLSFrame: %d\n", g_result);
+	if (g_frame && !g_filename)
+	{
+		printf("blob within 5 pixels of the target in %d of %d frames\n", g_tracked, g_frame);
+		printf("target's mean distance from the center %.1f pixels\n", g_offCenter/g_frame);
+	}
+	if (g_ccEvery)
+		printf("cc_getRLSCC: %d calls, %d failed\n", g_ccCalls, g_ccErrors);
+	if (g_recEvery)
+		printf("CCB2: %d frames decoded, %d bad\n", g_recFrames, g_recErrors);
+	printf("SPI: %d frames written, %d received, %d didn't match, %d parse errors\n", g_frame, g_spiFrames, g_spiBad, g_parser.errors);
+	printProf();
+	printSched(hal_us()-start);
+
+	// let the frame that's being filled come back before the M0 stops
+	while(g_qfilling)
+		g_chirpM0->service();
+	m0_stop();
+	m0.join();
+	return g_result<0 || g_ccErrors || g_recErrors ? 1 : 0;
+}
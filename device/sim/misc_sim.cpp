@@ -0,0 +1,31 @@
+#include <chrono>
+#include <thread>
+#include "misc.h"
+#include "hal.h"
+
+// misc.cpp without the button and ADC, which aren't simulated
+
+void delayus(uint32_t us)
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+uint32_t button()
+{
+	return 0;
+}
+
+uint32_t adc_get(uint32_t channel)
+{
+	return 0;
+}
+
+void setTimer(uint32_t *timer)
+{
+	*timer = hal_us();
+}
+
+uint32_t getTimer(uint32_t timer)
+{
+	return hal_us() - timer;
+}
@@ -0,0 +1,12 @@
+#include "rlsemu.h"
+
+// rlsemu's models of lineProcessedRL0A and lineProcessedRL1A for m0_sim.c, which is C
+// (like the M0's Chirp) and can't call them directly
+extern "C" uint32_t *sim_rlsLine(const uint8_t *bgLine, const uint8_t *grLine, uint32_t *memory, const uint8_t *lut, 
+	uint32_t width, const uint8_t *shiftLut)
+{
+	uint8_t lineStore[0x800];
+
+	rls_emuLine0(bgLine, lineStore, width);
+	return rls_emuLine1(grLine, memory, lut, false, lineStore, width, shiftLut, QVAL_CCQ1);
+}
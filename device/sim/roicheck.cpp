@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "qval.h"
+#include "rlsemu.h"
+
+// roi-check compares the q vals of a window set with cc_setROI against the full frame's,
+// both made by rlsemu's model of getRLSFrame (rls_emuFrame), which clips the window's
+// left edge with rls_clipFrame as the M4 does.
+//
+//   roi-check [-n tests]
+//
+// Each test is a frame of random blocks, a LUT with random cells set, and a random window.
+// Inside the window the runs have to cover the pixels the full frame's runs do, and nothing
+// outside it.  The M0 stops each line at the window's right edge, so a run that gets there
+// ends where it ends, and the last few columns aren't compared.  There has to be a row for
+// each line down to the window's bottom, and no run can begin left of the window.
+
+#define WIDTH       320 // q val resolution, the frame is twice this
+#define HEIGHT      200
+#define RIGHT_EDGE  3   // columns left of the window's right edge that aren't compared
+#define MEMORY      0x20000
+
+// the model of each column of each row, 2 columns past WIDTH for runs that end at the edge
+typedef std::vector<std::vector<uint8_t> > Coverage;
+
+static uint32_t cover(const uint32_t *qvals, uint32_t n, Coverage *c)
+{
+	uint32_t i, col, begin, len;
+	int32_t row;
+
+	c->assign(HEIGHT, std::vector<uint8_t>(WIDTH+2, 0));
+	for (i=0, row=-1; i<n; i++)
+	{
+		if (qvals[i]==0)
+		{
+			row++;
+			continue;
+		}
+		begin = QVAL_BEGIN(QVAL_CCQ1, qvals[i]);
+		len = QVAL_LEN(QVAL_CCQ1, qvals[i]);
+		for (col=begin; col<begin+len && col<WIDTH+2; col++)
+			(*c)[row][col] = QVAL_MODEL(qvals[i]);
+	}
+	return row+1;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, test, tests = 300, bad = 0, x, y, x0, y0, width, height, n, nw, rows, expect, blockWidth;
+	uint8_t shiftLut[WIDTH+1];
+	std::vector<uint8_t> lut(0x10000), frame(WIDTH*2*HEIGHT*2);
+	std::vector<uint32_t> full(MEMORY/sizeof(uint32_t)), window(MEMORY/sizeof(uint32_t));
+	Coverage cf, cw;
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n")==0 && i+1<argc)
+			tests = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: roi-check [-n tests]\n");
+			return 1;
+		}
+	}
+
+	// same as getRLSFrame's in m0_sim.c
+	for (i=0; i<=WIDTH; i++)
+		shiftLut[i] = 3;
+
+	srand(1);
+	for (test=0; test<tests; test++)
+	{
+		memset(&lut[0], 0, lut.size());
+		for (i=0; i<3000; i++)
+			lut[rand()&0xffff] = 1 + rand()%3;
+		// blocks, so runs form
+		blockWidth = 8 + test%20;
+		for (y=0; y<HEIGHT*2; y++)
+		{
+			for (x=0; x<WIDTH*2; x++)
+				frame[y*WIDTH*2 + x] = (uint32_t)((x/blockWidth)*7919 + (y/6)*104729 + test)*2654435761u>>24;
+		}
+		x0 = test%10==0 ? 0 : rand()%WIDTH;
+		y0 = rand()%HEIGHT;
+		width = 1 + rand()%(WIDTH-x0);
+		height = 1 + rand()%(HEIGHT-y0);
+
+		n = rls_emuFrame(&frame[0], WIDTH, HEIGHT, &full[0], MEMORY, &lut[0], true, shiftLut);
+		nw = rls_emuFrame(&frame[0], WIDTH, HEIGHT, &window[0], MEMORY, &lut[0], true, shiftLut, x0, y0, width, height);
+		if (n<0 || nw<0)
+		{
+			printf("test %d: out of memory\n", test);
+			bad++;
+			continue;
+		}
+		cover(&full[0], n, &cf);
+		rows = cover(&window[0], nw, &cw);
+
+		if (rows!=y0+height)
+		{
+			printf("test %d: %d rows, window ends at %d\n", test, rows, y0+height);
+			bad++;
+		}
+		for (i=0; i<nw; i++)
+		{
+			if (window[i] && (int)QVAL_BEGIN(QVAL_CCQ1, window[i])<x0)
+			{
+				printf("test %d: run begins at %d, window at %d\n", test, QVAL_BEGIN(QVAL_CCQ1, window[i]), x0);
+				bad++;
+				break;
+			}
+		}
+		for (y=0; y<rows && y<HEIGHT; y++)
+		{
+			for (x=0; x<WIDTH+2; x++)
+			{
+				if (y<y0 || x<x0 || x>x0+width+1)
+					expect = 0;
+				else if (x<x0+width-RIGHT_EDGE)
+					expect = cf[y][x];
+				else
+					continue;
+				if (cw[y][x]!=expect && bad++<10)
+					printf("test %d (%d %d %d %d): row %d column %d is %d, should be %d\n", test, x0, y0, width, height, y, x, cw[y][x], expect);
+			}
+		}
+	}
+
+	printf("%d tests, %d differences\n", tests, bad);
+	return bad ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "smlink.hpp"
+
+// smring-check sends messages through the shared memory link (smring.h), the M4's side
+// (SMLink) on one thread and the M0's (linkSend, linkReceive in smlink.c) on another.
+//
+//   smring-check [-n messages]
+//
+// Each message is a length and that many bytes, from a byte to more than the ring holds,
+// sent and received in pieces of random sizes, so reads take part of a slot or span
+// several and sends wait for room.  The M0 echoes each message back, and the M4 checks it.
+// Then each side waits on the other, which has stopped, and has to time out (hal_waitUntil)
+// in about the time it was given.
+
+#define MAX_MESSAGE     (SMR_SLOTS*SMR_SLOT_DATA*3)
+#define TIMEOUT         100 // ms
+#define TIMEOUT_SLACK   50  // ms over the timeout we allow
+
+extern "C" int linkSend(const uint8_t *data, uint32_t len, uint16_t timeoutMs);
+extern "C" int linkReceive(uint8_t *data, uint32_t len, uint16_t timeoutMs);
+
+// hal_sim.cpp's servo timer calls it, nothing here enables it
+extern "C" void SCT_IRQHandler(void)
+{
+}
+
+static int g_messages = 2000;
+static uint32_t g_m0Errors = 0;
+
+// len bytes in pieces of random sizes, returns 0 or the failing call's result
+static int sendPieces(SMLink *link, const uint8_t *data, uint32_t len, uint32_t *seed)
+{
+	uint32_t i, n;
+	int res;
+
+	for (i=0; i<len; i+=n)
+	{
+		n = 1 + rand_r(seed)%(len-i < 600 ? len-i : 600);
+		if ((res=link ? link->send(data+i, n, TIMEOUT) : linkSend(data+i, n, TIMEOUT))<0)
+			return res;
+	}
+	return 0;
+}
+
+static int receivePieces(SMLink *link, uint8_t *data, uint32_t len, uint32_t *seed)
+{
+	uint32_t i, n;
+	int res;
+
+	for (i=0; i<len; i+=n)
+	{
+		n = 1 + rand_r(seed)%(len-i < 600 ? len-i : 600);
+		if ((res=link ? link->receive(data+i, n, TIMEOUT) : linkReceive(data+i, n, TIMEOUT))<0)
+			return res;
+	}
+	return 0;
+}
+
+static void m0Echo(void)
+{
+	int i;
+	uint32_t len, seed = 2;
+	std::vector<uint8_t> data(MAX_MESSAGE);
+
+	for (i=0; i<g_messages; i++)
+	{
+		if (receivePieces(NULL, (uint8_t *)&len, sizeof(len), &seed)<0 || len>MAX_MESSAGE ||
+			receivePieces(NULL, &data[0], len, &seed)<0 ||
+			sendPieces(NULL, (uint8_t *)&len, sizeof(len), &seed)<0 || sendPieces(NULL, &data[0], len, &seed)<0)
+		{
+			printf("M0: message %d failed\n", i);
+			g_m0Errors++;
+			return;
+		}
+	}
+}
+
+// how long the call takes to fail with the other side stopped, -1 if it doesn't fail
+static int timeout(int (*call)(SMLink *link, uint8_t *data, uint32_t len), SMLink *link, uint32_t len)
+{
+	std::vector<uint8_t> data(len);
+	uint32_t start = hal_us();
+
+	if ((*call)(link, &data[0], len)>=0)
+		return -1;
+	return (hal_us()-start)/1000;
+}
+
+static int m4Send(SMLink *link, uint8_t *data, uint32_t len)
+{
+	return link->send(data, len, TIMEOUT);
+}
+
+static int m4Receive(SMLink *link, uint8_t *data, uint32_t len)
+{
+	return link->receive(data, len, TIMEOUT);
+}
+
+static int m0Send(SMLink *link, uint8_t *data, uint32_t len)
+{
+	return linkSend(data, len, TIMEOUT);
+}
+
+static int m0Receive(SMLink *link, uint8_t *data, uint32_t len)
+{
+	return linkReceive(data, len, TIMEOUT);
+}
+
+int main(int argc, char *argv[])
+{
+	int i, ms, bad = 0, timeoutsBad = 0;
+	uint32_t j, len, echoLen, seed = 1;
+	std::vector<uint8_t> data(MAX_MESSAGE), echo(MAX_MESSAGE);
+	SMLink link;
+	static const struct
+	{
+		const char *name;
+		int (*call)(SMLink *link, uint8_t *data, uint32_t len);
+		uint32_t len;
+	}
+	waits[] =
+	{
+		{"M4 receive", m4Receive, 1},
+		{"M0 receive", m0Receive, 1},
+		{"M4 send", m4Send, SMR_SLOTS*SMR_SLOT_DATA + 1},
+		{"M0 send", m0Send, SMR_SLOTS*SMR_SLOT_DATA + 1}
+	};
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n")==0 && i+1<argc)
+			g_messages = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: smring-check [-n messages]\n");
+			return 1;
+		}
+	}
+
+	if (hal_init()<0)
+	{
+		fprintf(stderr, "can't map SRAM at its pixyvals.h addresses\n");
+		return 1;
+	}
+	sm_init();
+
+	std::thread m0(m0Echo);
+	for (i=0; i<g_messages; i++)
+	{
+		// mostly small, like Chirp's, every so often more than the ring holds
+		len = i%10==0 ? rand_r(&seed)%MAX_MESSAGE + 1 : rand_r(&seed)%300 + 1;
+		for (j=0; j<len; j++)
+			data[j] = rand_r(&seed);
+		// the pieces are a stream, the M0 cuts it up its own way
+		if (sendPieces(&link, (uint8_t *)&len, sizeof(len), &seed)<0 || sendPieces(&link, &data[0], len, &seed)<0 ||
+			receivePieces(&link, (uint8_t *)&echoLen, sizeof(echoLen), &seed)<0 || echoLen!=len ||
+			receivePieces(&link, &echo[0], len, &seed)<0)
+		{
+			printf("M4: message %d failed\n", i);
+			bad++;
+			break;
+		}
+		if (memcmp(&data[0], &echo[0], len))
+		{
+			if (bad++<10)
+				printf("message %d, %u bytes, came back different\n", i, len);
+		}
+	}
+	m0.join();
+
+	// the rings are empty, and nothing's on the other side
+	for (i=0; i<(int)(sizeof(waits)/sizeof(waits[0])); i++)
+	{
+		ms = timeout(waits[i].call, &link, waits[i].len);
+		if (ms<TIMEOUT-1 || ms>TIMEOUT+TIMEOUT_SLACK)
+		{
+			printf("%s: %d ms to time out, timeout's %d ms\n", waits[i].name, ms, TIMEOUT);
+			timeoutsBad++;
+		}
+		sm_init();
+	}
+
+	printf("%d messages, %d bad, %u M0 failures, %d of %d timeouts bad\n", g_messages, bad, g_m0Errors, timeoutsBad,
+		(int)(sizeof(waits)/sizeof(waits[0])));
+	return bad || g_m0Errors || timeoutsBad ? 1 : 0;
+}
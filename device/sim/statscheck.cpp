@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "colorstats.h"
+#include "clut.h"
+
+// stats-check compares what cc_getStats sends, cs_compute's statistics and bins (colorstats.h),
+// against the box's samples, and the LUT PixyMon's CLUT (host/pixymon/clut.cpp) makes from the
+// bins the way Interpreter::getDeviceStats expands them against the LUT it makes from the frame.
+//
+//   stats-check [-n tests] [log]
+//
+// With a log (PixyMon's DataLog, datalog.h) the tests go through its BA81 frames, otherwise
+// each test is a frame of a random color with random noise, as in clut-check.  Each test
+// takes a random box.  The bins are written over the frame, as cc_getStats does.  The check
+// fails if the count, sums or quantiles differ from the samples', a bin is out of order or
+// the counts don't add up, or the LUTs differ in a cell.
+
+#define WIDTH   320
+#define HEIGHT  200
+
+// DataLog layout, see host/pixymon/datalog.h
+#define DL_MAGIC        0x474c5850
+#define DL_ALIGN        8
+#define DL_TYPE_BA81    0x31384142
+
+static const uint8_t g_quantiles[CS_QUANTILES] = {5, 25, 50, 75, 95};
+
+static uint32_t get32(const uint8_t *p)
+{
+	return p[0] | p[1]<<8 | p[2]<<16 | (uint32_t)p[3]<<24;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+	return p[0] | p[1]<<8;
+}
+
+// the log's WIDTH x HEIGHT BA81 frames, one after another, returns how many
+static int readLog(const char *filename, std::vector<uint8_t> &frames)
+{
+	FILE *file;
+	long size;
+	uint32_t pos, type, len, chunkHeaderLen;
+	std::vector<uint8_t> log;
+
+	if ((file=fopen(filename, "rb"))==NULL)
+		return -1;
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	log.resize(size);
+	if (size<24 || fread(&log[0], 1, size, file)!=(size_t)size || get32(&log[0])!=DL_MAGIC)
+	{
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+
+	chunkHeaderLen = get32(&log[8]);
+	for (pos=get16(&log[6]); pos+chunkHeaderLen<=(uint32_t)size; pos+=chunkHeaderLen + (len+DL_ALIGN-1)/DL_ALIGN*DL_ALIGN)
+	{
+		type = get32(&log[pos]);
+		len = get32(&log[pos+4]);
+		if (type==0 || pos+chunkHeaderLen+len>(uint32_t)size)
+			break;
+		if (type==DL_TYPE_BA81 && get16(&log[pos+20])==WIDTH && get16(&log[pos+22])==HEIGHT && len==WIDTH*HEIGHT)
+			frames.insert(frames.end(), &log[pos+chunkHeaderLen], &log[pos+chunkHeaderLen+len]);
+	}
+	return frames.size()/(WIDTH*HEIGHT);
+}
+
+int main(int argc, char *argv[])
+{
+	int i, j, x, y, c, test, tests = 2000, spread, x0, y0, width, height, numFrames = 0;
+	int base[3];
+	uint32_t n, k, count, samples = 0, statsBad = 0, binsBad = 0, lutsBad = 0;
+	const char *filename = NULL;
+	std::vector<uint8_t> frames, frame(WIDTH*HEIGHT), bins(WIDTH*HEIGHT), scratch, lut(0x10000), lutBins(0x10000);
+	std::vector<uint32_t> pixels, pixelsBins;
+	std::vector<int32_t> rgs, bgs;
+	ColorStats stats;
+	int32_t sumRG, sumBG, rank;
+	uint32_t *bin;
+	CLUT clut;
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n")==0 && i+1<argc)
+			tests = atoi(argv[++i]);
+		else if (argv[i][0]!='-' && filename==NULL)
+			filename = argv[i];
+		else
+		{
+			fprintf(stderr, "usage: stats-check [-n tests] [log]\n");
+			return 1;
+		}
+	}
+	if (filename && (numFrames=readLog(filename, frames))<=0)
+	{
+		fprintf(stderr, "no %dx%d BA81 frames in %s\n", WIDTH, HEIGHT, filename);
+		return 1;
+	}
+
+	srand(5);
+	for (test=0; test<tests; test++)
+	{
+		if (numFrames)
+			memcpy(&frame[0], &frames[(test%numFrames)*WIDTH*HEIGHT], WIDTH*HEIGHT);
+		else
+		{
+			// red, green, blue, every so often with a lot of spread, so there are a lot of bins
+			for (c=0; c<3; c++)
+				base[c] = rand()%256;
+			spread = 1 + rand()%(test%5==0 ? 250 : 40);
+			// Bayer: blue, green on even lines, green, red on odd lines
+			for (y=0; y<HEIGHT; y++)
+			{
+				for (x=0; x<WIDTH; x++)
+				{
+					c = y&1 ? (x&1 ? 0 : 1) : (x&1 ? 1 : 2);
+					frame[y*WIDTH + x] = std::min(255, std::max(0, base[c] + rand()%spread - spread/2));
+				}
+			}
+		}
+		x0 = rand()%300;
+		y0 = 1 + rand()%180;
+		width = 2 + rand()%(WIDTH-x0);
+		height = 2 + rand()%(HEIGHT-y0);
+
+		// the samples, the way PixyMon's getStats takes them from the frame
+		pixels.clear();
+		rgs.clear();
+		bgs.clear();
+		for (i=y0|1; i<y0+height && i<HEIGHT; i+=2)
+		{
+			for (j=x0|1; j<x0+width && j<WIDTH; j+=2)
+			{
+				pixels.push_back(frame[i*WIDTH + j]);
+				pixels.push_back(frame[i*WIDTH - WIDTH + j]);
+				pixels.push_back(frame[i*WIDTH - WIDTH + j - 1]);
+				rgs.push_back((int32_t)frame[i*WIDTH + j] - frame[i*WIDTH - WIDTH + j]);
+				bgs.push_back((int32_t)frame[i*WIDTH - WIDTH + j - 1] - frame[i*WIDTH - WIDTH + j]);
+			}
+		}
+		if (pixels.empty())
+			continue;
+		n = rgs.size();
+		samples += n;
+
+		// bins over the frame, and no more scratch than it needs
+		bins = frame;
+		scratch.resize(CS_SCRATCH_SIZE(n));
+		if (cs_compute(&bins[0], WIDTH, HEIGHT, x0, y0, width, height, &scratch[0], scratch.size(), &stats,
+			(uint32_t *)&bins[0], bins.size()/sizeof(uint32_t))<0)
+		{
+			printf("test %d: cs_compute failed on %d %d %d %d\n", test, x0, y0, width, height);
+			statsBad++;
+			continue;
+		}
+
+		for (k=0, sumRG=0, sumBG=0; k<n; k++)
+		{
+			sumRG += rgs[k];
+			sumBG += bgs[k];
+		}
+		std::sort(rgs.begin(), rgs.end());
+		std::sort(bgs.begin(), bgs.end());
+		for (k=0, c=0; k<CS_QUANTILES; k++)
+		{
+			rank = std::min(n*g_quantiles[k]/100, n-1);
+			c += stats.qRG[k]!=rgs[rank] || stats.qBG[k]!=bgs[rank];
+		}
+		if (c || stats.count!=n || stats.sumRG!=sumRG || stats.sumBG!=sumBG)
+		{
+			if (statsBad++<10)
+				printf("test %d: %u samples, sums %d %d, cs_compute %u samples, sums %d %d, %d quantiles differ\n", test,
+					n, sumRG, sumBG, stats.count, stats.sumRG, stats.sumBG, c);
+		}
+
+		// in order, and every sample's in one, expanded as getDeviceStats does
+		bin = (uint32_t *)&bins[0];
+		pixelsBins.clear();
+		for (k=0, count=0; k<stats.numBins; k++)
+		{
+			if (k && (bin[k]&0x3ffff)<=(bin[k-1]&0x3ffff))
+				break;
+			count += CS_BIN_COUNT(bin[k]);
+			for (i=0; i<(int)CS_BIN_COUNT(bin[k]); i++)
+			{
+				pixelsBins.push_back(0x100 + CS_BIN_RG(bin[k]));
+				pixelsBins.push_back(0x100);
+				pixelsBins.push_back(0x100 + CS_BIN_BG(bin[k]));
+			}
+		}
+		if (k<stats.numBins || count!=n)
+		{
+			if (binsBad++<10)
+				printf("test %d: %u bins, bin %u out of order, %u of %u samples\n", test, stats.numBins, k, count, n);
+			continue;
+		}
+
+		clut.generateFromImgSample(&pixels[0], pixels.size(), &lut[0]);
+		clut.generateFromImgSample(&pixelsBins[0], pixelsBins.size(), &lutBins[0]);
+		if (lut!=lutBins)
+		{
+			for (k=0, c=0; k<0x10000; k++)
+				c += lut[k]!=lutBins[k];
+			if (lutsBad++<10)
+				printf("test %d: %d LUT cells differ\n", test, c);
+		}
+	}
+
+	printf("%d tests, %u samples, %u stats differ, %u bins bad, %u LUTs differ\n", tests, samples, statsBad, binsBad, lutsBad);
+	return statsBad || binsBad || lutsBad ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+#include "usblink.h"
+
+// no host is attached in the simulation, so USB Chirp calls just fail to go out, and
+// nothing ever comes in
+
+USBLink::USBLink()
+{
+	m_flags = LINK_FLAG_ERROR_CORRECTED;
+}
+
+USBLink::~USBLink()
+{
+}
+
+int USBLink::send(const uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+	return LINK_RESULT_ERROR_SEND_TIMEOUT;
+}
+
+int USBLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+	return LINK_RESULT_ERROR_RECV_TIMEOUT;
+}
@@ -0,0 +1,136 @@
+#include <string.h>
+#include "blobout.h"
+
+void bo_init(struct BlobOut *bo)
+{
+	memset(bo, 0, sizeof(struct BlobOut));
+}
+
+static uint16_t checksum(const uint16_t *words, uint32_t n)
+{
+	uint32_t i;
+	uint16_t sum;
+
+	for (i=0, sum=0; i<n; i++)
+		sum += words[i];
+	return sum;
+}
+
+uint32_t bo_write(struct BlobOut *bo, const struct BoBlob *blobs, uint32_t n)
+{
+	uint32_t i, w;
+	uint16_t *words;
+	struct BoBuffer *buf;
+
+	// the buffer not being sent, the interrupt may take it between the first 2 lines,
+	// after which it's sending it and the other one is free
+	w = bo->sending^1;
+	bo->buf[w].ready = 0;
+	BO_BARRIER();
+	if (bo->sending==w)
+		w ^= 1;
+	buf = &bo->buf[w];
+
+	if (n>BO_MAX_BLOBS)
+		n = BO_MAX_BLOBS;
+
+	words = buf->words;
+	words[0] = BO_SYNC_FRAME;
+	words[2] = bo->frame++;
+	words[3] = n;
+	words[1] = checksum(words+2, BO_FRAME_WORDS-2);
+	for (i=0, words+=BO_FRAME_WORDS; i<n; i++, words+=BO_BLOB_WORDS)
+	{
+		words[0] = BO_SYNC_BLOB;
+		words[2] = blobs[i].model;
+		words[3] = blobs[i].x;
+		words[4] = blobs[i].y;
+		words[5] = blobs[i].width;
+		words[6] = blobs[i].height;
+		words[1] = checksum(words+2, BO_BLOB_WORDS-2);
+	}
+	buf->len = BO_FRAME_WORDS + n*BO_BLOB_WORDS;
+
+	// the interrupt has to see the words before ready
+	BO_BARRIER();
+	buf->ready = 1;
+
+	return n;
+}
+
+uint32_t bo_transmit(struct BlobOut *bo, uint16_t *data, uint32_t len)
+{
+	uint32_t i;
+	struct BoBuffer *buf = &bo->buf[bo->sending];
+
+	for (i=0; i<len; i++)
+	{
+		if (bo->read==buf->len)
+		{
+			// between frames, take the next one if it's been written
+			if (!bo->buf[bo->sending^1].ready)
+				break;
+			bo->sending ^= 1;
+			buf = &bo->buf[bo->sending];
+			buf->ready = 0;
+			bo->read = 0;
+		}
+		data[i] = buf->words[bo->read++];
+	}
+	return i;
+}
+
+void bo_parserInit(struct BoParser *p)
+{
+	memset(p, 0, sizeof(struct BoParser));
+}
+
+int bo_parse(struct BoParser *p, uint16_t word)
+{
+	uint32_t n;
+	struct BoBlob *blob;
+
+	// anything between packets that isn't a sync is idle (the SSP sends something
+	// whenever it's clocked)
+	if (p->len==0 && word!=BO_SYNC_FRAME && word!=BO_SYNC_BLOB)
+		return 0;
+
+	p->words[p->len++] = word;
+	n = p->words[0]==BO_SYNC_FRAME ? BO_FRAME_WORDS : BO_BLOB_WORDS;
+	if (p->len<n)
+		return 0;
+	p->len = 0;
+
+	if (checksum(p->words+2, n-2)!=p->words[1])
+	{
+		p->errors++;
+		p->expected = 0;
+		return 0;
+	}
+
+	if (p->words[0]==BO_SYNC_FRAME)
+	{
+		if (p->expected || p->words[3]>BO_MAX_BLOBS)
+			p->errors++;
+		if (p->words[3]>BO_MAX_BLOBS)
+		{
+			p->expected = 0;
+			return 0;
+		}
+		p->frame = p->words[2];
+		p->numBlobs = p->words[3];
+		p->expected = p->numBlobs;
+		return p->numBlobs==0;
+	}
+
+	// blob packet, ignored if we haven't seen its frame packet
+	if (p->expected==0)
+		return 0;
+	blob = &p->blobs[p->numBlobs - p->expected--];
+	blob->model = p->words[2];
+	blob->x = p->words[3];
+	blob->y = p->words[4];
+	blob->width = p->words[5];
+	blob->height = p->words[6];
+	return p->expected==0;
+}
@@ -0,0 +1,98 @@
+#ifndef _BLOBOUT_H
+#define _BLOBOUT_H
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Blob output for a microcontroller on the SPI port.  The blob stage writes each frame's
+// blobs (bo_write) and the SSP interrupt drains them a FIFO's worth at a time (bo_transmit,
+// the spi.h TransmitCallback), so the two never wait on each other.
+//
+// Each frame is a frame packet followed by a blob packet per blob, all 16-bit words:
+//   frame: BO_SYNC_FRAME, checksum, frame number, number of blobs
+//   blob:  BO_SYNC_BLOB, checksum, model, x, y, width, height
+// The checksum is the 16-bit sum of the words after it in the packet.  x and y are the
+// center of the blob, in CAM_RES2 pixels.  Nothing is sent between frames.
+//
+// There are 2 buffers, each holding a frame's packets.  The interrupt sends one
+// while the blob stage writes the other, and only switches buffers between frames, so
+// a frame is never torn.  If the interrupt is still sending when the next frame is written,
+// the frame waiting to be sent is replaced--- the receiver gets the newest frame, at most a
+// frame late, and frame numbers skip.
+//
+// States, each changed by one side only:
+//   ready 1 -> 0, sending = buffer   interrupt, bo_transmit takes a written frame
+//   ready 0 -> 1                     blob stage, bo_write
+//   ready 1 -> 0                     blob stage, bo_write (replacing a frame not yet taken)
+// The interrupt preempts the blob stage and not the other way around, so bo_write clears
+// ready before it looks at which buffer is being sent.
+
+#define BO_MAX_BLOBS        16
+#define BO_SYNC_FRAME       0xaa56
+#define BO_SYNC_BLOB        0xaa55
+#define BO_FRAME_WORDS      4
+#define BO_BLOB_WORDS       7
+#define BO_BUF_WORDS        (BO_FRAME_WORDS + BO_MAX_BLOBS*BO_BLOB_WORDS)
+
+#ifdef __GNUC__
+#define BO_BARRIER()        __sync_synchronize()
+#else
+#define BO_BARRIER()        __dmb(0xf)
+#endif
+
+struct BoBlob
+{
+	uint16_t model;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+};
+
+struct BoBuffer
+{
+	uint16_t words[BO_BUF_WORDS];
+	uint16_t len;
+	volatile uint8_t ready;
+};
+
+struct BlobOut
+{
+	struct BoBuffer buf[2];
+	volatile uint8_t sending;   // interrupt's, buffer being sent
+	uint16_t read;              // interrupt's, words of it sent so far
+	uint16_t frame;             // blob stage's
+};
+
+void bo_init(struct BlobOut *bo);
+// writes up to BO_MAX_BLOBS blobs as the next frame, returns the number written
+uint32_t bo_write(struct BlobOut *bo, const struct BoBlob *blobs, uint32_t n);
+// copies up to len words to data, returns how many
+uint32_t bo_transmit(struct BlobOut *bo, uint16_t *data, uint32_t len);
+
+// Receiver's side, eg for the microcontroller.  Feed it the words as they come in,
+// bo_parse returns 1 when a whole frame has come in with good checksums, which is then in
+// frame, numBlobs and blobs.  Anything else (a bad checksum, a missing blob packet)
+// drops the frame, and it looks for the next BO_SYNC_FRAME.
+struct BoParser
+{
+	uint16_t words[BO_BLOB_WORDS];
+	uint8_t len;         // words of the current packet
+	uint8_t expected;    // blob packets still to come
+	uint16_t frame;
+	uint16_t numBlobs;
+	struct BoBlob blobs[BO_MAX_BLOBS];
+	uint32_t errors;
+};
+
+void bo_parserInit(struct BoParser *p);
+int bo_parse(struct BoParser *p, uint16_t word);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include <string.h>
+#include "blobrec.h"
+
+void br_encoderInit(struct BrEncoder *e, uint16_t keyInterval)
+{
+	memset(e, 0, sizeof(struct BrEncoder));
+	e->keyInterval = keyInterval ? keyInterval : 1;
+	e->sinceKey = e->keyInterval;
+}
+
+void br_key(struct BrEncoder *e)
+{
+	e->sinceKey = e->keyInterval;
+}
+
+static int same(const struct BrBlob *a, const struct BrBlob *b)
+{
+	return a->model==b->model && a->x==b->x && a->y==b->y && a->left==b->left && a->right==b->right &&
+		a->top==b->top && a->bottom==b->bottom && a->angle==b->angle && a->area==b->area;
+}
+
+static void put(uint16_t *words, const struct BrBlob *blob)
+{
+	words[0] = blob->model;
+	words[1] = blob->x;
+	words[2] = blob->y;
+	words[3] = blob->left;
+	words[4] = blob->right;
+	words[5] = blob->top;
+	words[6] = blob->bottom;
+	words[7] = blob->angle;
+	words[8] = blob->area&0xffff;
+	words[9] = blob->area>>16;
+}
+
+static void get(struct BrBlob *blob, const uint16_t *words)
+{
+	blob->model = words[0];
+	blob->x = words[1];
+	blob->y = words[2];
+	blob->left = words[3];
+	blob->right = words[4];
+	blob->top = words[5];
+	blob->bottom = words[6];
+	blob->angle = words[7];
+	blob->area = words[8] | (uint32_t)words[9]<<16;
+}
+
+uint32_t br_encode(struct BrEncoder *e, const struct BrBlob *blobs, uint32_t n, uint16_t width, uint16_t height, uint16_t flags, uint16_t *words)
+{
+	uint32_t i, len;
+	uint16_t *mask;
+
+	if (n>BR_MAX_BLOBS)
+		n = BR_MAX_BLOBS;
+
+	flags &= ~BR_FLAG_KEY;
+	if (++e->sinceKey>=e->keyInterval)
+	{
+		flags |= BR_FLAG_KEY;
+		e->sinceKey = 0;
+	}
+
+	words[0] = BR_VERSION;
+	words[1] = flags;
+	words[2] = e->frame++;
+	words[3] = n;
+	words[4] = width;
+	words[5] = height;
+	mask = words + BR_HEADER_WORDS;
+	memset(mask, 0, BR_MASK_WORDS(n)*sizeof(uint16_t));
+	len = BR_HEADER_WORDS + BR_MASK_WORDS(n);
+
+	for (i=0; i<n; i++)
+	{
+		if (!(flags&BR_FLAG_KEY) && i<e->numPrev && same(&blobs[i], &e->prev[i]))
+			mask[i>>4] |= 1<<(i&0x0f);
+		else
+		{
+			put(words+len, &blobs[i]);
+			len += BR_RECORD_WORDS;
+		}
+	}
+
+	memcpy(e->prev, blobs, n*sizeof(struct BrBlob));
+	e->numPrev = n;
+
+	return len;
+}
+
+void br_decoderInit(struct BrDecoder *d)
+{
+	memset(d, 0, sizeof(struct BrDecoder));
+}
+
+int32_t br_decode(struct BrDecoder *d, const uint16_t *words, uint32_t len)
+{
+	uint32_t i, n, read;
+	const uint16_t *mask;
+
+	if (len<BR_HEADER_WORDS || words[0]!=BR_VERSION || words[3]>BR_MAX_BLOBS)
+		goto bad;
+	n = words[3];
+	if (len<BR_HEADER_WORDS+BR_MASK_WORDS(n))
+		goto bad;
+
+	// a delta has to follow the frame we have
+	if (!(words[1]&BR_FLAG_KEY) && (!d->valid || words[2]!=(uint16_t)(d->frame+1)))
+	{
+		d->valid = 0;
+		d->errors++;
+		return -2;
+	}
+
+	mask = words + BR_HEADER_WORDS;
+	read = BR_HEADER_WORDS + BR_MASK_WORDS(n);
+	// blob i is decoded in place, over blob i of the frame before
+	for (i=0; i<n; i++)
+	{
+		if (mask[i>>4]&(1<<(i&0x0f)))
+		{
+			if (i>=d->numBlobs)
+				goto bad;
+		}
+		else
+		{
+			if (read+BR_RECORD_WORDS>len)
+				goto bad;
+			get(&d->blobs[i], words+read);
+			read += BR_RECORD_WORDS;
+		}
+	}
+
+	d->numBlobs = n;
+	d->flags = words[1];
+	d->frame = words[2];
+	d->width = words[4];
+	d->height = words[5];
+	d->valid = 1;
+	return n;
+
+bad:
+	d->valid = 0;
+	d->errors++;
+	return -1;
+}
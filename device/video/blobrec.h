@@ -0,0 +1,90 @@
+#ifndef _BLOBREC_H
+#define _BLOBREC_H
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// CCB2 blob records, the blob list cc_getRLSCC returns and PixyMon logs and streams.
+// PixyMon builds this file and blobrec.c too, with its own BR_MAX_BLOBS (see
+// pixymon.pro).  All 16-bit words, little endian:
+//   header: version, flags, frame number, number of blobs, width, height
+//   mask:   (number of blobs+15)/16 words, bit i of word i/16 set if blob i is the
+//           same as blob i of the frame before, never set in a key frame
+//   a record per blob that isn't the same, in order, BR_RECORD_WORDS each:
+//           model, x, y, left, right, top, bottom, angle, area (low word, high word)
+// model is reserved for the model number and is 0 for now, the firmware assembles the
+// segments of all models together (see handleRL in conncomp.cpp).  x and y are the
+// centroid, and coordinates and area are in pixels of a width x height frame.  angle is
+// in degrees, and 0 unless BR_FLAG_ANGLE is set.
+//
+// Blobs come largest first, so blobs that don't move keep their index and cost a bit.
+// A frame that isn't a key frame can only be decoded after the frame before it, so the
+// encoder sends a key frame every keyInterval frames, and after br_key, and the decoder
+// drops frames until it gets one.
+
+#define BR_VERSION          1
+#define BR_FLAG_KEY         0x0001
+#define BR_FLAG_ANGLE       0x0002
+
+#ifndef BR_MAX_BLOBS
+#define BR_MAX_BLOBS        16
+#endif
+#define BR_HEADER_WORDS     6
+#define BR_RECORD_WORDS     10
+#define BR_MASK_WORDS(n)    (((n)+15)/16)
+#define BR_MAX_WORDS        (BR_HEADER_WORDS + BR_MASK_WORDS(BR_MAX_BLOBS) + BR_MAX_BLOBS*BR_RECORD_WORDS)
+
+struct BrBlob
+{
+	uint16_t model;
+	uint16_t x;
+	uint16_t y;
+	uint16_t left;
+	uint16_t right;
+	uint16_t top;
+	uint16_t bottom;
+	int16_t angle;
+	uint32_t area;
+};
+
+struct BrEncoder
+{
+	struct BrBlob prev[BR_MAX_BLOBS];
+	uint16_t numPrev;
+	uint16_t frame;
+	uint16_t keyInterval;   // 1 for every frame
+	uint16_t sinceKey;
+};
+
+void br_encoderInit(struct BrEncoder *e, uint16_t keyInterval);
+// make the next frame a key frame
+void br_key(struct BrEncoder *e);
+// writes up to BR_MAX_BLOBS blobs as the next frame to words, which holds BR_MAX_WORDS,
+// returns the number of words
+uint32_t br_encode(struct BrEncoder *e, const struct BrBlob *blobs, uint32_t n, uint16_t width, uint16_t height, uint16_t flags, uint16_t *words);
+
+struct BrDecoder
+{
+	struct BrBlob blobs[BR_MAX_BLOBS];
+	uint16_t numBlobs;
+	uint16_t frame;
+	uint16_t flags;
+	uint16_t width;
+	uint16_t height;
+	uint8_t valid;          // blobs is a frame, so the next frame can be a delta
+	uint32_t errors;
+};
+
+void br_decoderInit(struct BrDecoder *d);
+// returns the number of blobs, which are then in blobs, -1 if words isn't a CCB2 frame,
+// -2 if it needs a frame that the decoder didn't get
+int32_t br_decode(struct BrDecoder *d, const uint16_t *words, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
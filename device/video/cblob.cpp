@@ -8,6 +8,21 @@ bool CBlob::testMoments= false;
 // Skip major/minor axis computation when this is false
 bool SMoments::computeAxes= false;
 int CBlob::leakcheck=0;
+Arena *CBlob::arena= NULL;
+
+void *cb_alloc(size_t size)
+{
+  if (CBlob::arena)
+    return ar_alloc(CBlob::arena, size);
+  return malloc(size);
+}
+
+void cb_free(void *p)
+{
+  if (CBlob::arena && (uint8_t *)p>=CBlob::arena->base && (uint8_t *)p<CBlob::arena->end)
+    return;
+  free(p);
+}
 
 void SMoments::GetStats(SMomentStats &stats) const {
   stats.area= area;
@@ -211,7 +226,7 @@ CBlob::UpdateBoundingBox(int newLeft, int newTop, int newRight)
 
 CBlobAssembler::CBlobAssembler() 
 {
-  activeBlobs= currentBlob= finishedBlobs= NULL;
+  activeBlobs= currentBlob= finishedBlobs= freeBlobs= NULL;
   previousBlobPtr= &activeBlobs;
   currentRow=-1;
   maxRowDelta=1;
@@ -280,8 +295,10 @@ int CBlobAssembler::Add(const SSegment &segment) {
           //     << " to " << currentBlob->lastBottom.endCol
           //     << ", area " << currentBlob->moments.area << endl;
 
-          // Delete it
-          delete futileResister;
+          // Keep it for the next new blob
+          futileResister->Clean();
+          futileResister->next= freeBlobs;
+          freeBlobs= futileResister;
 					//g_mem -= sizeof(CBlob);
 
           BlobNewRow(&currentBlob->next);
@@ -294,8 +311,12 @@ int CBlobAssembler::Add(const SSegment &segment) {
   // Could not attach to previous blob, insert new one before currentBlob
   //CBlob *newBlob= new CBlob();
 	//CBlob* mem = (CBlob*) ::operator new (sizeof(CBlob));
-	CBlob* newBlob = (CBlob*) malloc(sizeof(CBlob));
-	if (newBlob == NULL)
+	CBlob* newBlob;
+	if (freeBlobs) {
+		newBlob = freeBlobs;
+		freeBlobs = freeBlobs->next;
+	}
+	else if ((newBlob = (CBlob*) cb_alloc(sizeof(CBlob))) == NULL)
 		return 0;
 	new (newBlob) CBlob;
 	//g_mem += sizeof(CBlob);
@@ -460,6 +481,11 @@ void CBlobAssembler::Reset() {
 		//g_mem -= sizeof(CBlob);
     finishedBlobs= tmp;
   }
+  while (freeBlobs) {
+    CBlob *tmp= freeBlobs->next;
+    delete freeBlobs;
+    freeBlobs= tmp;
+  }
 }
 
 // Added by Scott
@@ -42,6 +42,7 @@
 #include <assert.h>
 //#include <memory.h>
 #include <math.h>
+#include "arena.h"
 
 // Uncomment this for verbose output for testing
 //#include <iostream.h>
@@ -59,17 +60,17 @@ struct SMomentStats {
   float minorDiameter;
 };
 
-// Image size is 352x278
-// Full-screen blob area is 97856
-// Full-screen centroid is 176,139
-// sumX, sumY is then 17222656, 13601984; well within 32 bits
+// Image size is up to 2047x2047 (CCQ2 q vals, see qval.h)
+// Full-screen blob area is 4190209
+// Full-screen centroid is 1023,1023
+// sumX, sumY is then about 4.3e9, over 32 bits
 struct SMoments {
 // Skip major/minor axis computation when this is false
   static bool computeAxes;
   
   int area; // number of pixels
-  int sumX; // sum of pixel x coords
-  int sumY; // sum of pixel y coords
+  long long sumX; // sum of pixel x coords
+  long long sumY; // sum of pixel y coords
   // XX, XY, YY used for major/minor axis calculation
   long long sumXX; // sum of x^2 for each pixel
   long long sumYY; // sum of y^2 for each pixel
@@ -102,12 +103,13 @@ struct SMoments {
 };
 
 struct SSegment {
-  unsigned char  model    : 3 ; // which color channel
-  unsigned short row      : 9 ;
-  unsigned short startCol : 10; // inclusive
-  unsigned short endCol   : 10; // inclusive
+  // 11-bit q val coordinates (CCQ2), endCol is begin + length so it needs 12
+  unsigned int   model    : 3 ; // which color channel
+  unsigned int   row      : 12;
+  unsigned int   startCol : 12; // inclusive
+  unsigned int   endCol   : 12; // inclusive
 
-  const static short invalid_row= 0x1ff;
+  const static short invalid_row= 0xfff;
 
   // Sum 0^2 + 1^2 + 2^2 + ... + n^2 is (2n^3 + 3n^2 + n) / 6
   // Sum (a+1)^2 + (a+2)^2 ... b^2 is (2(b^3-a^3) + 3(b^2-a^2) + (b-a)) / 6
@@ -127,17 +129,24 @@ struct SSegment {
     moments.sumY = (e-s) * y;
 
     if (SMoments::computeAxes) {
-      int e3= e2*e;
-      int s3= s2*s;
+      long long e3= (long long)e2*e;
+      long long s3= (long long)s2*s;
       moments.sumXY= moments.sumX*y;
       moments.sumXX= (2*(e3-s3) + 3*(e2-s2) + (e-s)) / 6;
       moments.sumYY= moments.sumY*y;
+    } else {
+      moments.sumXX= moments.sumYY= moments.sumXY= 0;
     }
   }
   
   void GetMomentsTest(SMoments &moments) const;
 };
 
+// CBlobs and SLinkedSegments come from CBlob::arena if it's set, otherwise the heap.
+// Arena memory is only given back all at once (ar_reset), so freeing it does nothing.
+void *cb_alloc(size_t size);
+void cb_free(void *p);
+
 //extern int g_allocated = 0;
 struct SLinkedSegment {
   SSegment segment;
@@ -147,12 +156,12 @@ struct SLinkedSegment {
 			
 	void* operator new (size_t size) {
 		//g_allocated += size;
-		return malloc(size);
+		return cb_alloc(size);
 	}
 
 	void operator delete (void *p) {
 		//g_allocated -= sizeof(SLinkedSegment);
-		free(p);
+		cb_free(p);
 	}
 };
 
@@ -199,6 +208,8 @@ public:
   static bool recordSegments;
   // Set to true for testing code only.  Very slow!
   static bool testMoments;
+  // Where blobs are allocated, NULL for the heap
+  static Arena *arena;
 
   CBlob();
   ~CBlob();
@@ -234,19 +245,21 @@ public:
   // by UpdateAttachmentSurface below
   void UpdateBoundingBox(int newLeft, int newTop, int newRight);
 	
-	//void* operator new (size_t size)
-	//{
-		//return malloc(size);
-		/*if (mem == NULL) {
-			int i = 0;
-		}
-		return mem;*/
-	//}
+	void* operator new (size_t size)
+	{
+		return cb_alloc(size);
+	}
+
+	// to set up a blob in memory that's already allocated (CBlobAssembler::Add)
+	void* operator new (size_t size, void *p)
+	{
+		return p;
+	}
 	
-	//void operator delete (void *p)
-	//{	
-	//	free(p);
-	//}
+	void operator delete (void *p)
+	{	
+		cb_free(p);
+	}
 };
 
 // Strategy for using CBlobAssembler:
@@ -284,6 +297,9 @@ class CBlobAssembler {
   // deleting blobs.
   CBlob **previousBlobPtr;
 
+  // Blobs assimilated into others, to be used again for new blobs
+  CBlob *freeBlobs;
+
 public:
   // Blobs we're no longer adding to
   CBlob *finishedBlobs;
@@ -0,0 +1,206 @@
+#include <string.h>
+#include "colorstats.h"
+#include "colorlut.h"
+
+// CLUT's parameters
+#define CL_FRACTION         95  // percent of the pixels inside each line (e)
+#define CL_STRETCH_UD       5   // the up and down lines are moved out to 2.5 times their distance (d)
+#define CL_STRETCH_IO       3   // the in and out lines to 3 times (d2, d3)
+#define CL_MINSAT           180 // steps, the in line is at least this far out (minsat)
+
+static uint32_t isqrt(uint64_t x)
+{
+	uint64_t r, b;
+
+	for (b=(uint64_t)1<<62; b>x; b>>=2);
+	for (r=0; b; b>>=2)
+	{
+		if (x>=r+b)
+		{
+			x -= r+b;
+			r = (r>>1) + b;
+		}
+		else
+			r >>= 1;
+	}
+	return r;
+}
+
+static int32_t floorDiv(int32_t x, int32_t d)
+{
+	return x>=0 ? x/d : -((d-1-x)/d);
+}
+
+static int64_t floorDiv64(int64_t x, int64_t d)
+{
+	return x>=0 ? x/d : -((d-1-x)/d);
+}
+
+static int64_t roundDiv(int64_t x, int64_t d)
+{
+	return x>=0 ? (x + d/2)/d : -((d/2 - x)/d);
+}
+
+// histogram of floor(x/CL_STEP), anything below 0 goes in the first entry and anything
+// past the end in the last
+static void add(uint16_t *hist, uint32_t size, int32_t x)
+{
+	int32_t q = floorDiv(x, CL_STEP) + 1;
+
+	if (q<0)
+		q = 0;
+	else if (q>=(int32_t)size)
+		q = size-1;
+	hist[q]++;
+}
+
+// CLUT's iterateline: the number of steps a line has to move out before k pixels are
+// inside it, which is the smallest m with k values of floor(x/CL_STEP) less than m
+static uint32_t steps(const uint16_t *hist, uint32_t size, uint32_t k)
+{
+	uint32_t m, sum;
+
+	for (m=0, sum=0; m<size-1; m++)
+	{
+		sum += hist[m];
+		if (sum>=k)
+			break;
+	}
+	return m;
+}
+
+int cl_model(const uint8_t *frame, uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height,
+	uint8_t *scratch, uint32_t scratchSize, ColorModel *model)
+{
+	CsRegion reg;
+	uint32_t i, j, n, k, sh;
+	int32_t rg, bg, t, w, sumRG, sumBG, s;
+	int64_t x, y, norm, lim;
+	const uint8_t *line, *prev;
+	uint16_t *up, *down, *out, *in;
+
+	if ((n=cs_region(frameWidth, frameHeight, x0, y0, width, height, &reg))==0 || n>0xffff)
+		return -1;
+	if (scratchSize<CL_SCRATCH_SIZE)
+		return -2;
+
+	up = (uint16_t *)scratch;
+	down = up + CL_T_RANGE+2;
+	out = down + CL_T_RANGE+2;
+	in = out + CL_T_RANGE+2;
+	memset(scratch, 0, CL_SCRATCH_SIZE);
+
+	for (i=reg.y0, sumRG=0, sumBG=0; i<reg.y1; i+=2)
+	{
+		line = frame + i*frameWidth;
+		prev = line - frameWidth;
+		for (j=reg.x0; j<reg.x1; j+=2)
+		{
+			sumRG += (int32_t)line[j] - prev[j];
+			sumBG += (int32_t)prev[j-1] - prev[j];
+		}
+	}
+
+	// mean scaled by 255*n*10000, each component at least 0.0001 from 0 (tweakmean)
+	lim = 255*(int64_t)n;
+	x = (int64_t)sumRG*10000;
+	y = (int64_t)sumBG*10000;
+	if (x<lim && x>-lim)
+		x = x>0 ? lim : -lim;
+	if (y<lim && y>-lim)
+		y = y>0 ? lim : -lim;
+	for (sh=0; x>=1<<30 || x<=-(1<<30) || y>=1<<30 || y<=-(1<<30); sh++)
+	{
+		x >>= 1;
+		y >>= 1;
+	}
+	norm = isqrt(x*x + y*y);
+
+	model->ux = roundDiv(x*CL_Q, norm);
+	model->uy = roundDiv(y*CL_Q, norm);
+	s = model->ux>=0 ? 1 : -1;
+	model->vx = -s*model->uy;
+	model->vy = s*model->ux;
+	model->mean = roundDiv((norm<<sh)*CL_Q, 10000*(int64_t)n);
+
+	// distance of each pixel from the mean line (t) and from the mean along it (w)
+	for (i=reg.y0; i<reg.y1; i+=2)
+	{
+		line = frame + i*frameWidth;
+		prev = line - frameWidth;
+		for (j=reg.x0; j<reg.x1; j+=2)
+		{
+			rg = (int32_t)line[j] - prev[j];
+			bg = (int32_t)prev[j-1] - prev[j];
+			t = model->vx*rg + model->vy*bg;
+			w = model->ux*rg + model->uy*bg - model->mean;
+			add(up, CL_T_RANGE+2, t);
+			add(down, CL_T_RANGE+2, -t);
+			add(out, CL_T_RANGE+2, w);
+			add(in, CL_T_RANGE*2+2, -w);
+		}
+	}
+
+	k = (CL_FRACTION*n + 99)/100;
+	model->up = steps(up, CL_T_RANGE+2, k);
+	model->down = steps(down, CL_T_RANGE+2, k);
+	model->out = steps(out, CL_T_RANGE+2, k);
+	model->in = steps(in, CL_T_RANGE*2+2, k);
+
+	return 0;
+}
+
+// narrow [begin, end) to the b with lo < a + b*c < hi
+static void clip(int64_t a, int64_t c, int64_t lo, int64_t hi, int16_t *begin, int16_t *end)
+{
+	int64_t b0, b1, tmp;
+
+	if (c<0)
+	{
+		a = -a;
+		c = -c;
+		tmp = lo;
+		lo = -hi;
+		hi = -tmp;
+	}
+	if (c==0)
+	{
+		if (a<=lo || a>=hi)
+			*end = *begin;
+		return;
+	}
+	// first b with a + b*c > lo, first b with a + b*c >= hi
+	b0 = floorDiv64(lo-a, c) + 1;
+	b1 = -floorDiv64(a-hi, c);
+	if (b0>*begin)
+		*begin = b0<*end ? b0 : *end;
+	if (b1<*end)
+		*end = b1>*begin ? b1 : *begin;
+}
+
+// The LUT cell (rg, bg) is at (rg/127, bg/127) (see generatelut in clut.cpp).  Scaled by
+// 127*CL_Q, v.(rg, bg) has to be within 2.5 steps of up and down, and scaled by 127*255*CL_Q
+// u.(rg, bg) has to be between the in and out lines, 3 steps out.
+void cl_row(const ColorModel *model, int8_t rg, int16_t *begin, int16_t *end)
+{
+	int64_t stepT = 127*CL_STEP*CL_STRETCH_UD/(2*255);
+	int64_t stepW = 127*CL_STEP*CL_STRETCH_IO;
+	int64_t lo, hi, tmp;
+
+	*begin = -128;
+	*end = 128;
+
+	clip((int64_t)model->vx*rg, model->vy, -stepT*model->down, stepT*model->up, begin, end);
+
+	lo = (int64_t)model->mean*127 - stepW*model->in;
+	if (lo<(int64_t)127*CL_STEP*CL_MINSAT)
+		lo = (int64_t)127*CL_STEP*CL_MINSAT;
+	hi = (int64_t)model->mean*127 + stepW*model->out;
+	if (lo>hi)
+	{
+		tmp = lo;
+		lo = hi;
+		hi = tmp;
+	}
+	clip((int64_t)model->ux*rg*255, (int64_t)model->uy*255, lo, hi, begin, end);
+}
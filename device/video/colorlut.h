@@ -0,0 +1,37 @@
+#ifndef _COLORLUT_H
+#define _COLORLUT_H
+
+#include <inttypes.h>
+
+// Fixed-point version of PixyMon's CLUT (clut.cpp), which makes a color model from
+// the pixels of a box.  The model is the area between 4 lines in the (r-g, b-g) plane:
+// 2 parallel to the mean color, which bound the hue, and 2 perpendicular to it,
+// which bound the saturation.
+//
+// CLUT keeps the lines as slope and offset, which goes to infinity near vertical.
+// Here they are kept as distances along the mean direction u and its normal v, so
+// everything fits in integers.  Distances are in units of 1/(255*CL_Q), the same
+// units as u.(r-g, b-g) with u scaled by CL_Q.  CL_Q makes CLUT's 0.001 step an
+// integer (CL_STEP).
+
+#define CL_Q                64000
+#define CL_STEP             (255*CL_Q/1000)
+#define CL_T_RANGE          1416 // steps, |(r-g, b-g)|/255 is at most 1.4142
+#define CL_SCRATCH_SIZE     ((CL_T_RANGE*3 + CL_T_RANGE*2 + 8)*sizeof(uint16_t))
+
+struct ColorModel
+{
+	int32_t ux, uy; // mean direction, scaled by CL_Q
+	int32_t vx, vy; // normal, vy >= 0
+	int32_t mean;   // length of the mean
+
+	// CLUT's steps, for the lines above and below the mean (v), and inside and outside (u)
+	uint32_t up, down, in, out;
+};
+
+int cl_model(const uint8_t *frame, uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height,
+	uint8_t *scratch, uint32_t scratchSize, ColorModel *model);
+// range of b-g LUT columns in LUT row rg, both signed, end is exclusive
+void cl_row(const ColorModel *model, int8_t rg, int16_t *begin, int16_t *end);
+
+#endif
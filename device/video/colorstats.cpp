@@ -0,0 +1,134 @@
+#include <string.h>
+#include "colorstats.h"
+
+static const uint8_t g_quantiles[CS_QUANTILES] = {5, 25, 50, 75, 95};
+
+uint32_t cs_region(uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height, CsRegion *r)
+{
+	r->x0 = x0 | 0x01;
+	r->y0 = y0 | 0x01;
+	r->x1 = x0 + width < frameWidth ? x0 + width : frameWidth;
+	r->y1 = y0 + height < frameHeight ? y0 + height : frameHeight;
+	if (r->x0>=r->x1 || r->y0>=r->y1)
+		return 0;
+	return ((r->x1 - r->x0 + 1)>>1)*((r->y1 - r->y0 + 1)>>1);
+}
+
+uint32_t cs_samples(uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height)
+{
+	CsRegion r;
+	return cs_region(frameWidth, frameHeight, x0, y0, width, height, &r);
+}
+
+static void quantiles(const uint32_t *hist, uint32_t count, int16_t *q)
+{
+	uint32_t i, j, sum, rank;
+
+	for (i=0, j=0, sum=0; i<CS_QUANTILES; i++)
+	{
+		rank = count*g_quantiles[i]/100;
+		if (rank>=count)
+			rank = count-1;
+		// quantiles are increasing, so j and sum carry over from the last one
+		for (; sum+hist[j]<=rank; j++)
+			sum += hist[j];
+		q[i] = (int16_t)j - 255;
+	}
+}
+
+// Count the columns (b-g) of each row (r-g) and write a bin for each column that's there
+static uint32_t emitBins(const uint16_t *cols, const uint32_t *rowEnd, uint32_t *colCount, uint32_t *bins)
+{
+	uint32_t row, col, i, begin, n;
+
+	for (row=0, begin=0, n=0; row<CS_DIFFS; begin=rowEnd[row++])
+	{
+		if (begin==rowEnd[row])
+			continue;
+		for (i=begin; i<rowEnd[row]; i++)
+			colCount[cols[i]]++;
+		for (col=0; col<CS_DIFFS; col++)
+		{
+			if (colCount[col]==0)
+				continue;
+			bins[n++] = colCount[col]<<18 | row<<9 | col;
+			colCount[col] = 0;
+		}
+	}
+	return n;
+}
+
+int cs_compute(const uint8_t *frame, uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height,
+	uint8_t *scratch, uint32_t scratchSize, ColorStats *stats, uint32_t *bins, uint32_t maxBins)
+{
+	CsRegion reg;
+	uint32_t i, j, n, sum;
+	int32_t rg, bg;
+	const uint8_t *line, *prev;
+	uint32_t *histRG, *histBG, *rowEnd, *colCount;
+	uint16_t *cols;
+
+	memset(stats, 0, sizeof(ColorStats));
+
+	if ((n=cs_region(frameWidth, frameHeight, x0, y0, width, height, &reg))==0)
+		return -1;
+	if (scratchSize<CS_SCRATCH_SIZE(n))
+		return -2;
+	if (n>CS_MAX_SAMPLES || n>maxBins)
+		return -3;
+
+	histRG = (uint32_t *)scratch;
+	histBG = histRG + CS_DIFFS;
+	cols = (uint16_t *)(histBG + CS_DIFFS);
+	memset(scratch, 0, CS_DIFFS*2*sizeof(uint32_t));
+
+	// first pass: sums and 1D histograms
+	for (i=reg.y0; i<reg.y1; i+=2)
+	{
+		line = frame + i*frameWidth;
+		prev = line - frameWidth;
+		for (j=reg.x0; j<reg.x1; j+=2)
+		{
+			rg = (int32_t)line[j] - prev[j];
+			bg = (int32_t)prev[j-1] - prev[j];
+			stats->sumRG += rg;
+			stats->sumBG += bg;
+			histRG[rg+255]++;
+			histBG[bg+255]++;
+		}
+	}
+	stats->count = n;
+
+	quantiles(histRG, n, stats->qRG);
+	quantiles(histBG, n, stats->qBG);
+
+	// the r-g histogram's counts -> row begin offsets, the b-g histogram's done with, it 
+	// counts columns from here
+	rowEnd = histRG;
+	colCount = histBG;
+	for (i=0, sum=0; i<CS_DIFFS; i++)
+	{
+		j = rowEnd[i];
+		rowEnd[i] = sum;
+		sum += j;
+	}
+	memset(colCount, 0, CS_DIFFS*sizeof(uint32_t));
+
+	// second pass: bucket the columns by row, after which rowEnd[row] is where the row ends
+	for (i=reg.y0; i<reg.y1; i+=2)
+	{
+		line = frame + i*frameWidth;
+		prev = line - frameWidth;
+		for (j=reg.x0; j<reg.x1; j+=2)
+		{
+			rg = (int32_t)line[j] - prev[j];
+			bg = (int32_t)prev[j-1] - prev[j];
+			cols[rowEnd[rg+255]++] = bg+255;
+		}
+	}
+
+	// the frame's not read from here, so bins can be the frame
+	stats->numBins = emitBins(cols, rowEnd, colCount, bins);
+
+	return 0;
+}
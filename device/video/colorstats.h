@@ -0,0 +1,51 @@
+#ifndef _COLORSTATS_H
+#define _COLORSTATS_H
+
+#include <inttypes.h>
+
+// Color statistics of a rectangle in a Bayer (BA81) frame, so that a color model
+// can be trained without sending the frame to the host.  Each 2x2 Bayer cell is one
+// sample, taken the same way PixyMon takes them (Interpreter::getStats):
+//   x0 |= 1, y0 |= 1, r = frame[y][x], g = frame[y-1][x], b = frame[y-1][x-1]
+//
+// Bins are a sparse 2D histogram at full resolution, sorted by r-g, then b-g:
+// | 14 count | 9 r-g+255 | 9 b-g+255 |
+// Every (r-g, b-g) in the box gets a bin, none are dropped, so there are at most as many
+// bins as samples, and the samples come back exactly from the bins, which is all CLUT
+// (host/pixymon/clut.cpp) looks at.
+
+#define CS_QUANTILES        5 // 5, 25, 50, 75, 95 percent
+#define CS_DIFFS            511 // r-g and b-g range from -255 to 255
+#define CS_MAX_SAMPLES      0x3fff // bin counts are 14 bits
+
+#define CS_BIN_RG(bin)      ((int32_t)((bin)>>9 & 0x1ff) - 255)
+#define CS_BIN_BG(bin)      ((int32_t)((bin)&0x1ff) - 255)
+#define CS_BIN_COUNT(bin)   ((bin)>>18)
+
+// scratch memory cs_compute needs for a given number of samples
+#define CS_SCRATCH_SIZE(samples)    (CS_DIFFS*2*sizeof(uint32_t) + (samples)*sizeof(uint16_t))
+
+// the samples of a box are at x0, x0+2, ... < x1 and y0, y0+2, ... < y1
+struct CsRegion
+{
+	uint16_t x0, y0, x1, y1;
+};
+
+struct ColorStats
+{
+	uint32_t count;
+	int32_t sumRG; // sums of r-g and b-g, divide by count for the mean
+	int32_t sumBG;
+	int16_t qRG[CS_QUANTILES];
+	int16_t qBG[CS_QUANTILES];
+	uint32_t numBins;
+};
+
+uint32_t cs_region(uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height, CsRegion *r);
+uint32_t cs_samples(uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height);
+// bins holds maxBins, which has to be at least the number of samples (cs_samples).  bins
+// can be the frame, the frame's read before the first bin is written.
+int cs_compute(const uint8_t *frame, uint16_t frameWidth, uint16_t frameHeight, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height,
+	uint8_t *scratch, uint32_t scratchSize, ColorStats *stats, uint32_t *bins, uint32_t maxBins);
+
+#endif
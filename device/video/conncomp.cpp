@@ -4,11 +4,17 @@
 #include "camera.h"
 #include "cameravals.h"
 #include "conncomp.h"
+#include "prof.h"
 
 //#include "global.h"
 
 int g_loop = 0;
 
+// everything that lives for one frame's blob assembly, reset at the start of each
+static Arena g_frameArena;
+// cc_getRLSCC's blob records, delta coded against the last frame it returned
+static BrEncoder g_records;
+
 int32_t cc_servo(const uint32_t &start)
 {
 	g_loop = start;
@@ -23,15 +29,32 @@ static const ProcModule g_module[] =
 	{END}, 
 	"Get a frame of color run-length segments (RLS)"
 	"@r 0 if success, negative if error"
-	"@r CCQ1 formated data, including 8-palette"
+	"@r CCQ1 or CCQ2 formated data (see qval.h), including 8-palette"
 	},
 	{
 	"cc_setModel",
 	(ProcPtr)cc_setModel, 
 	{CRP_UINT8, CRP_HTYPE(FOURCC('R','E','G','1')), END}, 
-	"Set model by selecting box in image"
-	"@p model numerical index of model, can be 0-5"
+	"Set model by selecting box in image, the LUT is generated on the device"
+	"@p model numerical index of model, can be 1-7"
+	"@p pixels user-selected pixels"
+	"@r 0 if success, negative if error"
+	},
+	{
+	"cc_getStats",
+	(ProcPtr)cc_getStats, 
+	{CRP_HTYPE(FOURCC('R','E','G','1')), END}, 
+	"Get color statistics of a box in the image, for training a model without sending the frame"
 	"@p pixels user-selected pixels"
+	"@r number of samples if success, negative if error"
+	"@r sums of r-g and b-g, 5/25/50/75/95 percent quantiles of r-g and b-g, (r-g, b-g) histogram bins (see colorstats.h)"
+	},
+	{
+	"cc_setROI",
+	(ProcPtr)cc_setROI, 
+	{CRP_HTYPE(FOURCC('R','E','G','1')), END}, 
+	"Set the region of interest of cc_getRLSFrame and blob detection, rows and columns outside of it are not processed"
+	"@p region x, y, width, height in run-length columns and rows, 0 width or height for the whole frame"
 	"@r 0 if success, negative if error"
 	},
 	{
@@ -41,10 +64,29 @@ static const ProcModule g_module[] =
 	"" 
 	},
 	{
+	"cc_setLut",
+	(ProcPtr)cc_setLut,
+	{CRP_UINT32, CRP_UINTS8, END},
+	"Update the LUT with run-length encoded entries"
+	"@p flags 1 to clear the LUT before applying the runs"
+	"@p runs 5 bytes per run: uint16 start, uint16 length-1, uint8 value"
+	"@r checksum of the resulting LUT, negative if error, -3 if there isn't room for the LUT"
+	},
+	{
 	"cc_getRLSCC",
 	(ProcPtr)cc_getRLSCCChirp,
 	{END},
-	"Gets the bounding boxes of connected components using run-lengths"
+	"Get the blobs of a frame as CCB2 records (see blobrec.h), only those that changed since the last call"
+	"@r 0 if success, negative if error"
+	"@r CCB2 records, and the frame's capture time"
+	},
+	{
+	"cc_getArena",
+	(ProcPtr)cc_getArena,
+	{END},
+	"Get how much of the frame arena blob assembly uses (see arena.h)"
+	"@r 0"
+	"@r arena size and the most a frame has used, in bytes, and the number of allocations that didn't fit"
 	},
 	{
 	"cc_servo",
@@ -56,19 +98,25 @@ static const ProcModule g_module[] =
 };
 
 static ChirpProc g_getRLSFrameM0 = -1;
+// region of interest, 0 widths is the whole frame
+static uint16_t g_roiXOffset = 0;
+static uint16_t g_roiYOffset = 0;
+static uint16_t g_roiWidth = 0;
+static uint16_t g_roiHeight = 0;
 
 
 int cc_init(Chirp *chirp)
 {
-	uint32_t i;
-
 	chirp->registerModule(g_module);	
 
 	g_getRLSFrameM0 = g_chirpM0->getProc("getRLSFrame", NULL);
 
 	// clear lut
-	for (i=0; i<LUT_MEMORY_SIZE; i++)
-		LUT_MEMORY[i] = 0;
+	lut_init(LUT_MEMORY, LUT_MEMORY_SIZE);
+
+	ar_init(&g_frameArena, FRAME_ARENA_MEMORY, FRAME_ARENA_SIZE);
+	CBlob::arena = &g_frameArena;
+	br_encoderInit(&g_records, CC_KEY_INTERVAL);
 
 	if (g_getRLSFrameM0>0)
 		return -1;
@@ -109,33 +157,129 @@ void RGBtoHSV(uint8_t r, uint8_t g, uint8_t b, uint8_t *h, uint8_t *s, uint8_t *
     *c = delta;
 }
 
-// this routine assumes it can grab valid pixels in video memory described by the box
+// grab a frame for cc_getStats and cc_setModel
+static int32_t grabFrame(uint8_t *frame)
+{
+	return cam_getFrame(frame, STATS_FRAME_SIZE, CAM_GRAB_M1R2, 0, 0, CAM_RES2_WIDTH, CAM_RES2_HEIGHT);
+}
+
+// set the LUT cells (rg, begin) to (rg, end-1) to model, the b-g columns are signed
+static int setRow(int8_t rg, int16_t begin, int16_t end, uint8_t model)
+{
+	uint32_t row = (uint8_t)rg<<8;
+	int res;
+
+	if (begin<0 && begin<end && (res=lut_set(LUT_MEMORY, LUT_MEMORY_SIZE, row | (begin&0xff), (end<0 ? end : 0) - begin, model))<0)
+		return res;
+	if (end>0 && begin<end && (res=lut_set(LUT_MEMORY, LUT_MEMORY_SIZE, row | (begin>0 ? begin : 0), end - (begin>0 ? begin : 0), model))<0)
+		return res;
+	return 0;
+}
+
+// generate the model from a frame grabbed here, same as PixyMon does from the frame it gets (see colorlut.h)
 int32_t cc_setModel(const uint8_t &model, const uint16_t &xoffset, const uint16_t &yoffset, const uint16_t &width, const uint16_t &height, Chirp *chirp)
 {
+	int32_t res;
+	int16_t rg, begin, end;
+	ColorModel cm;
+	uint8_t *frame = RLS_MEMORY;
+	uint8_t *scratch = frame + STATS_FRAME_SIZE;
+
+	if (model<1 || model>7) // LUT cells hold the model in the lower 3 bits
+		return -1;
+
+	if ((res=grabFrame(frame))<0)
+		return res;
+
+	if ((res=cl_model(frame, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, xoffset, yoffset, width, height, 
+		scratch, RLS_MEMORY+STATS_MEMORY_SIZE-scratch, &cm))<0)
+		return res;
+
+	for (rg=-128; rg<128; rg++)
+	{
+		cl_row(&cm, rg, &begin, &end);
+		if (setRow(rg, begin, end, model)<0)
+			return -3; // out of LUT pages
+	}
+
+	return 0;
+}
+
+// the bins go back in place of the frame, there's one for each (r-g, b-g) in the box, as 
+// many as a quarter of the frame's pixels
+int32_t cc_getStats(const uint16_t &xoffset, const uint16_t &yoffset, const uint16_t &width, const uint16_t &height, Chirp *chirp)
+{
+	int32_t res;
+	uint32_t prebuf;
+	ColorStats stats;
+	int16_t q[CS_QUANTILES] = {0};
+
+	// force an error to get prebuf length
+	CRP_RETURN(chirp, USE_BUFFER(STATS_MEMORY_SIZE, RLS_MEMORY), INT32(0), INT32(0), INTS16(CS_QUANTILES, q), INTS16(CS_QUANTILES, q), 
+		UINTS32(0, 0), END);
+	prebuf = chirp->getPreBufLen();
+
+	uint8_t *frame = RLS_MEMORY + prebuf;
+	uint8_t *scratch = frame + STATS_FRAME_SIZE;
+
+	if ((res=grabFrame(frame))<0)
+		return res;
+
+	if ((res=cs_compute(frame, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, xoffset, yoffset, width, height, 
+		scratch, RLS_MEMORY+STATS_MEMORY_SIZE-scratch, &stats, (uint32_t *)frame, STATS_FRAME_SIZE/sizeof(uint32_t)))<0)
+		return res;
+
+	// send bins, use in-place buffer
+	CRP_RETURN(chirp, USE_BUFFER(STATS_MEMORY_SIZE, RLS_MEMORY), INT32(stats.sumRG), INT32(stats.sumBG), INTS16(CS_QUANTILES, stats.qRG), 
+		INTS16(CS_QUANTILES, stats.qBG), UINTS32(stats.numBins, frame), END);
+
+	return stats.count;
+}
+
+int32_t cc_setROI(const uint16_t &xoffset, const uint16_t &yoffset, const uint16_t &width, const uint16_t &height)
+{
+	if (width==0 || height==0)
+	{
+		g_roiXOffset = g_roiYOffset = g_roiWidth = g_roiHeight = 0;
+		return 0;
+	}
+	if (xoffset+width>CAM_RES2_WIDTH || yoffset+height>CAM_RES2_HEIGHT)
+		return -1;
+
+	g_roiXOffset = xoffset;
+	g_roiYOffset = yoffset;
+	g_roiWidth = width;
+	g_roiHeight = height;
 	return 0;
 }
 
 int32_t cc_getRLSFrameChirp(Chirp *chirp)
 {
 	int32_t result;
-	uint32_t prebuf, numRls;
+	uint32_t prebuf, numRls, time;
 
+	cam_claim();
 	// force an error to get prebuf length
-	CRP_RETURN(chirp, USE_BUFFER(RLS_MEMORY_SIZE, RLS_MEMORY), HTYPE(0), UINT16(0), UINT16(0), UINTS32(0, 0), END);
+	CRP_RETURN(chirp, USE_BUFFER(RLS_MEMORY_SIZE, RLS_MEMORY), HTYPE(0), UINT16(0), UINT16(0), UINTS32(0, 0), UINT32(0), END);
 	prebuf = chirp->getPreBufLen();
 
-	if ((result=cc_getRLSFrame((uint32_t *)(RLS_MEMORY+prebuf), RLS_MEMORY_SIZE-prebuf, LUT_MEMORY, &numRls))>=0)
-		// send frame, use in-place buffer	
-		CRP_RETURN(chirp, USE_BUFFER(RLS_MEMORY_SIZE, RLS_MEMORY), HTYPE(FOURCC('C','C','Q','1')), UINT16(CAM_RES2_WIDTH), UINT16(CAM_RES2_HEIGHT), UINTS32(numRls, RLS_MEMORY+prebuf), END);
+	if ((result=cc_getRLSFrame((uint32_t *)(RLS_MEMORY+prebuf), RLS_MEMORY_SIZE-prebuf, LUT_MEMORY, &numRls, true, &time))>=0)
+		// send frame, use in-place buffer, the capture time goes after it
+		CRP_RETURN(chirp, USE_BUFFER(RLS_MEMORY_SIZE, RLS_MEMORY), HTYPE(RLS_QVAL_FORMAT), UINT16(CAM_RES2_WIDTH), UINT16(CAM_RES2_HEIGHT), UINTS32(numRls, RLS_MEMORY+prebuf), 
+			UINT32(time), END);
 
 	return result;
 }
 
-int32_t cc_getRLSFrame(uint32_t *memory, uint32_t memSize, /*hword size*/ uint8_t *lut, uint32_t *numRls, bool sync)
+int32_t cc_getRLSFrame(uint32_t *memory, uint32_t memSize, /*hword size*/ uint8_t *lut, uint32_t *numRls, bool sync, uint32_t *time)
 {
 	int32_t res;
 	int32_t responseInt = -1;
+	uint32_t frameTime = 0;
 
+	// the main loop's frames are async, the rest wait for them (see cam_claim)
+	if (sync)
+		cam_claim();
 	// check mode, set if necessary
 	if ((res=cam_setMode(CAM_MODE1))<0)
 		return res;
@@ -143,15 +287,21 @@ int32_t cc_getRLSFrame(uint32_t *memory, uint32_t memSize, /*hword size*/ uint8_
 	// forward call to M0, get frame
 	if (sync)
 	{
+		PROF_START(RLS_FRAME);
 		g_chirpM0->callSync(g_getRLSFrameM0, 
-			UINT32((uint32_t)memory), UINT32(memSize), UINT32((uint32_t)lut), END_OUT_ARGS,
-			&responseInt, numRls, END_IN_ARGS);
+			UINT32((uint32_t)(uintptr_t)memory), UINT32(memSize), UINT32((uint32_t)(uintptr_t)lut),
+			UINT16(g_roiXOffset), UINT16(g_roiYOffset), UINT16(g_roiWidth), UINT16(g_roiHeight), END_OUT_ARGS,
+			&responseInt, numRls, &frameTime, END_IN_ARGS);
+		PROF_STOP(RLS_FRAME);
+		if (time)
+			*time = frameTime;
 		return responseInt;
 	}
 	else
 	{
 		g_chirpM0->callAsync(g_getRLSFrameM0, 
-			UINT32((uint32_t)memory), UINT32(memSize), UINT32((uint32_t)lut), END_OUT_ARGS);
+			UINT32((uint32_t)(uintptr_t)memory), UINT32(memSize), UINT32((uint32_t)(uintptr_t)lut),
+			UINT16(g_roiXOffset), UINT16(g_roiYOffset), UINT16(g_roiWidth), UINT16(g_roiHeight), END_OUT_ARGS);
 		return 0;
 	}
 
@@ -160,153 +310,159 @@ int32_t cc_getRLSFrame(uint32_t *memory, uint32_t memSize, /*hword size*/ uint8_
 int32_t cc_setMemory(const uint32_t &location, const uint32_t &len, const uint8_t *data)
 {
 	uint32_t i;
-	uint8_t *dest = (uint8_t *)location;
+	uint8_t *dest = (uint8_t *)(uintptr_t)location;
 	for (i=0; i<len; i++)
 		dest[i] = data[i];
 
 	return len;
 }
 
-#define MAX_BLOBS 15
-int32_t cc_getRLSCCChirp(Chirp *chirp)
+int32_t cc_setLut(const uint32_t &flags, const uint32_t &len, const uint8_t *runs)
+{
+	uint32_t i, start, n;
+	int res;
+
+	if (len%LUT_RUN_SIZE)
+		return -1;
+
+	if (flags&LUT_FLAG_CLEAR)
+		lut_init(LUT_MEMORY, LUT_MEMORY_SIZE);
+
+	for (i=0; i<len; i+=LUT_RUN_SIZE)
+	{
+		start = runs[i] | (runs[i+1]<<8);
+		n = (runs[i+2] | (runs[i+3]<<8)) + 1;
+		if ((res=lut_set(LUT_MEMORY, LUT_MEMORY_SIZE, start, n, runs[i+4]))<0)
+			return res==-1 ? -2 : -3; // -3: out of LUT pages
+	}
+
+	return cc_lutChecksum(LUT_MEMORY);
+}
+
+// the host computes the same checksum over its copy (Interpreter::lutChecksum)
+int32_t cc_lutChecksum(const uint8_t *lut)
+{
+	uint32_t i, sum;
+
+	for (i=0, sum=5381; i<LUT_FLAT_SIZE; i++)
+		sum = sum*33 + LUT_GET(lut, i);
+
+	return sum&0x7fffffff;
+}
+
+int32_t cc_getArena(Chirp *chirp)
+{
+	CRP_RETURN(chirp, UINT32(g_frameArena.end - g_frameArena.base), UINT32(g_frameArena.high - g_frameArena.base), 
+		UINT32(g_frameArena.failures), END);
+	return 0;
+}
+
+// q vals in either format (see qval.h) to segments
+static void addQVals(CBlobAssembler *blobber, uint32_t format, const uint32_t *qvals, uint32_t numRls)
 {
-	
-	int16_t* c_components = new int16_t[MAX_BLOBS*4];
-	
-	
-	uint32_t numRls, result;//, prebuf;
-	uint32_t *memory = (uint32_t *)RLS_MEMORY;
-	result = cc_getRLSFrame(memory, RLS_MEMORY_SIZE, LUT_MEMORY, &numRls);
-	
-	CBlobAssembler blobber;
-	
 	int32_t row;
 	uint32_t i, startCol, length;
 	uint8_t model;
+	PROF_START(BLOB_ADD);
 
 	for (i=0, row=-1; i<numRls; i++)
 	{
-			if (memory[i]==0)
-			{
-					row++;
-					continue;
-			}
-			model = memory[i]&0x03;
-			memory[i] >>= 3;
-			startCol = memory[i]&0x1ff;
-			memory[i] >>= 9;
-			length = memory[i]&0x1ff;
-			if(!handleRL(&blobber, model, row, startCol, length))
-				break;
+		if (qvals[i]==0)
+		{
+			row++;
+			continue;
+		}
+		model = QVAL_MODEL(qvals[i]);
+		startCol = QVAL_BEGIN(format, qvals[i]);
+		length = QVAL_LEN(format, qvals[i]);
+		if(!handleRL(blobber, model, row, startCol, length))
+			break;
 	}
+	PROF_STOP(BLOB_ADD);
+}
+
+#define MAX_BLOBS 15
+int32_t cc_getRLSCCChirp(Chirp *chirp)
+{
+	int32_t result;
+	uint32_t numRls, time, len;
+	uint32_t *memory = (uint32_t *)RLS_MEMORY;
+	uint16_t *words;
+	if ((result=cc_getRLSFrame(memory, RLS_MEMORY_SIZE, LUT_MEMORY, &numRls, true, &time))<0)
+		return result;
+	
+	len = cc_getRecords(memory, numRls, &g_records, &words);
+	CRP_RETURN(chirp, HTYPE(FOURCC('C','C','B','2')), UINTS16(len, words), UINT32(time), END);
+
+	return result;
+}
+
+uint32_t cc_getRecords(uint32_t *qvals, uint32_t numRls, BrEncoder *encoder, uint16_t **words)
+{
+	uint32_t n;
+	int16_t top, right, bottom, left;
+	SMomentStats stats;
+	CBlob *blob;
+
+	ar_reset(&g_frameArena);
+	// first, so they always fit
+	BrBlob *blobs = (BrBlob *)ar_alloc(&g_frameArena, MAX_BLOBS*sizeof(BrBlob));
+	*words = (uint16_t *)ar_alloc(&g_frameArena, BR_MAX_WORDS*sizeof(uint16_t));
+	
+	CBlobAssembler blobber;
+	
+	addQVals(&blobber, RLS_QVAL_FORMAT, qvals, numRls);
 	
+	PROF_START(BLOB_SORT);
 	blobber.EndFrame();
 	blobber.SortFinished();
+	PROF_STOP(BLOB_SORT);
 	
-	//
-	// Take Finished blobs and return with chirp
-	//
-	CBlob *blob, *temp;
-	blob = blobber.finishedBlobs;
-	
-	uint32_t cc_num = 0;
-	temp = blob;
-	while (temp)
+	// q vals and records are both in CAM_RES2 pixels
+	for (blob=blobber.finishedBlobs, n=0; blob && n<MAX_BLOBS; blob=blob->next, n++)
 	{
-		int16_t top, right, bottom, left;
-		temp->getBBox(left, top, right, bottom);
-		
+		blob->getBBox(left, top, right, bottom);
 		// Don't want objects with area less than 9...
 		if ((right-left)*(bottom-top) < 9)
 			break;
-		
-		temp = temp->next;
-		cc_num++;
+		blob->moments.GetStats(stats);
+		blobs[n].model = 0; // reserved, segments aren't assembled by model (see handleRL, blobrec.h)
+		blobs[n].x = (uint16_t)(stats.centroidX + 0.5f);
+		blobs[n].y = (uint16_t)(stats.centroidY + 0.5f);
+		blobs[n].left = left;
+		blobs[n].right = right;
+		blobs[n].top = top;
+		blobs[n].bottom = bottom;
+		blobs[n].angle = SMoments::computeAxes ? (int16_t)(stats.angle*180/3.14159f) : 0;
+		blobs[n].area = stats.area;
 	}
 	
-	// Remove the rest that we don't care about
-	/*while(temp)
-	{
-		CBlob *next = temp->next;
-		temp->~CBlob();
-		temp = NULL;
-		temp = next;
-	}*/
-	
-	cc_num = (cc_num < 15) ? cc_num : MAX_BLOBS;
-
-	// Populate return w/ result
-	//void* mem = malloc(sizeof(int16_t)*cc_num*4);
-	//if (mem == NULL)
-	//	int i = 0;
-	//free(mem);
-	//int16_t* c_components = new int16_t[cc_num*4];
-	//g_mem += sizeof(int16_t)*cc_num*4;
-	memset((void *)c_components, 0, sizeof(uint16_t)*cc_num*4);
-
-	for (int i = 0; i < cc_num; i++)
-	{
-		int16_t top, right, bottom, left;
-		blob->getBBox(left, top, right, bottom);
-		c_components[(i*4)+0] = top;
-		c_components[(i*4)+1] = right;
-		c_components[(i*4)+2] = bottom;
-		c_components[(i*4)+3] = left;
-
-		blob = blob->next;
-	}
-	
-	//CRP_RETURN(chirp, USE_BUFFER(SRAM0_SIZE, SRAM0_LOC), HTYPE(0), UINT16(0), UINT16(0), UINTS8(0, 0), END);
-	//prebuf = chirp->getPreBufLen();
-	
 	blobber.Reset();
 	
-	CRP_RETURN(chirp, HTYPE(FOURCC('V','I','S','U')), UINTS16(cc_num*4, c_components), END);
-	
-	delete[] c_components;
-	//g_mem -= sizeof(int16_t)*cc_num*4;
-
-	return result;
+	return br_encode(encoder, blobs, n, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, SMoments::computeAxes ? BR_FLAG_ANGLE : 0, *words);
 }
 
 #define MIN_AREA 2
 
 int32_t cc_getMaxBlob(uint32_t *qvals, uint32_t numRls, int16_t *bdata)
 {
+	ar_reset(&g_frameArena);
 	
-	int16_t* c_components = new int16_t[MAX_BLOBS*4];
-	
-	uint32_t result;//, prebuf;
+	uint32_t result = 0;//, prebuf;
 	
 	CBlobAssembler blobber;
 	
-	int32_t row;
-	uint32_t i, startCol, length;
-	uint8_t model;
-
-	for (i=0, row=-1; i<numRls; i++)
-	{
-			if (qvals[i]==0)
-			{
-					row++;
-					continue;
-			}
-			model = qvals[i]&0x03;
-			qvals[i] >>= 3;
-			startCol = qvals[i]&0x1ff;
-			qvals[i] >>= 9;
-			length = qvals[i]&0x1ff;
-			if(!handleRL(&blobber, model, row, startCol, length))
-				break;
-	}
+	addQVals(&blobber, RLS_QVAL_FORMAT, qvals, numRls);
 	
+	PROF_START(BLOB_SORT);
 	blobber.EndFrame();
 	blobber.SortFinished();
+	PROF_STOP(BLOB_SORT);
 
 	int16_t top, right, bottom, left;
 	CBlob *blob;
 	blob = blobber.finishedBlobs;
-	if (blob->GetArea()>MIN_AREA)
+	if (blob && blob->GetArea()>MIN_AREA)
 	{
 		blob->getBBox(left, top, right, bottom);
 		bdata[0] = left;
@@ -377,12 +533,42 @@ int32_t cc_getMaxBlob(uint32_t *qvals, uint32_t numRls, int16_t *bdata)
 	
 	blobber.Reset();
 		
-	delete[] c_components;
 	//g_mem -= sizeof(int16_t)*cc_num*4;
 
 	return result;
 }
 
+int32_t cc_getBlobs(uint32_t *qvals, uint32_t numRls, BoBlob *blobs, uint32_t maxBlobs)
+{
+	int16_t top, right, bottom, left;
+	uint32_t n;
+	CBlob *blob;
+
+	ar_reset(&g_frameArena);
+	CBlobAssembler blobber;
+
+	addQVals(&blobber, RLS_QVAL_FORMAT, qvals, numRls);
+
+	PROF_START(BLOB_SORT);
+	blobber.EndFrame();
+	blobber.SortFinished();
+	PROF_STOP(BLOB_SORT);
+
+	for (blob=blobber.finishedBlobs, n=0; blob && n<maxBlobs && blob->GetArea()>MIN_AREA; blob=blob->next, n++)
+	{
+		blob->getBBox(left, top, right, bottom);
+		blobs[n].model = 0; // segments aren't assembled by model (see handleRL)
+		blobs[n].x = left + (right-left)/2;
+		blobs[n].y = top + (bottom-top)/2;
+		blobs[n].width = right-left;
+		blobs[n].height = bottom-top;
+	}
+
+	blobber.Reset();
+
+	return n;
+}
+
 int handleRL(CBlobAssembler *blobber, uint8_t model, int row, int startCol, int len)
 {
 	if (startCol < 0)
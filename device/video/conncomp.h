@@ -2,21 +2,59 @@
 #define _CONNCOMP_H
 #include "chirp.hpp"
 #include "cblob.h"
+#include "lutcompact.h"
+#include "colorstats.h"
+#include "colorlut.h"
+#include "qval.h"
+#include "blobout.h"
+#include "blobrec.h"
 
-#define RLS_MEMORY_SIZE     0x8000 // bytes
+#define LUT_MEMORY_SIZE		0x8000 // bytes, two-level LUT (see lutcompact.h), room for 119 nonzero rows
+#define LUT_MEMORY			((uint8_t *)SRAM0_LOC + SRAM0_SIZE-LUT_MEMORY_SIZE)
+// what lives for a frame's blob assembly (see arena.h), CBlobs mostly, the most a frame
+// can use.  Room for about 180 CBlobs, as much as the whole heap had.
+#define FRAME_ARENA_SIZE    0x4000
+#define FRAME_ARENA_MEMORY  (LUT_MEMORY-FRAME_ARENA_SIZE)
+#define RLS_MEMORY_SIZE     (SRAM0_SIZE-LUT_MEMORY_SIZE-FRAME_ARENA_SIZE) // bytes
 #define RLS_MEMORY          ((uint8_t *)SRAM0_LOC)
-#define LUT_MEMORY_SIZE		0x10000 // bytes
-#define LUT_MEMORY			((uint8_t *)SRAM0_LOC + SRAM0_SIZE-LUT_MEMORY_SIZE)  // +0x100 make room for prebuf and palette
+
+// format of the q vals getRLSFrame on the M0 makes (CAM_RES2, so 9-bit columns)
+#define RLS_QVAL_FORMAT     QVAL_CCQ1
+
+// cc_setLut run format: LUT_RUN_SIZE bytes per run, little endian
+//   uint16 start index, uint16 length-1, uint8 value
+#define LUT_RUN_SIZE        5
+#define LUT_FLAG_CLEAR      0x01 // zero the LUT before applying the runs
+
+// cc_getRLSCC sends all of its blobs at least this often, in frames (see blobrec.h)
+#define CC_KEY_INTERVAL     30
+
+// cc_getStats and cc_setModel grab a frame into RLS memory and use the rest as scratch,
+// the frame arena too, as nothing's in it outside of blob assembly
+#define STATS_FRAME_SIZE    (CAM_RES2_WIDTH*CAM_RES2_HEIGHT)
+#define STATS_MEMORY_SIZE   (RLS_MEMORY_SIZE+FRAME_ARENA_SIZE)
 
 int cc_init(Chirp *chirp);
 
 int32_t cc_setModel(const uint8_t &model, const uint16_t &xoffset, const uint16_t &yoffset, const uint16_t &width, const uint16_t &height, Chirp *chirp=NULL);
+int32_t cc_getStats(const uint16_t &xoffset, const uint16_t &yoffset, const uint16_t &width, const uint16_t &height, Chirp *chirp);
+int32_t cc_setROI(const uint16_t &xoffset, const uint16_t &yoffset, const uint16_t &width, const uint16_t &height);
 int32_t cc_setMemory(const uint32_t &location, const uint32_t &len, const uint8_t *data);
+int32_t cc_setLut(const uint32_t &flags, const uint32_t &len, const uint8_t *runs);
+int32_t cc_lutChecksum(const uint8_t *lut);
+int32_t cc_getArena(Chirp *chirp);
 int32_t cc_getRLSFrameChirp(Chirp *chirp);
-int32_t cc_getRLSFrame(uint32_t *memory, uint32_t memSize, /*hword size*/ uint8_t *lut, uint32_t *numRls, bool sync=true);
+// time, if not NULL, gets the frame's capture time (hal_us at vsync), sync only--- the async
+// result goes to the getRLSFrame callback (main_m4.cpp)
+int32_t cc_getRLSFrame(uint32_t *memory, uint32_t memSize, /*hword size*/ uint8_t *lut, uint32_t *numRls, bool sync=true, uint32_t *time=NULL);
 
 int32_t cc_getRLSCCChirp(Chirp *chirp);
+// the largest blobs as the next frame of encoder's CCB2 records (blobrec.h), words gets the
+// frame, which lasts until the next frame's blobs are assembled, returns its length in words
+uint32_t cc_getRecords(uint32_t *qvals, uint32_t numRls, BrEncoder *encoder, uint16_t **words);
 int handleRL(CBlobAssembler *blobber, uint8_t model, int row, int startCol, int len);
 int32_t cc_getMaxBlob(uint32_t *qvals, uint32_t numRls, int16_t *bdata);
+// the largest blobs, largest first, returns how many
+int32_t cc_getBlobs(uint32_t *qvals, uint32_t numRls, BoBlob *blobs, uint32_t maxBlobs);
 
 #endif
@@ -0,0 +1,152 @@
+#include <string.h>
+#include "lutcompact.h"
+
+static uint8_t *zeroPage(uint8_t *lut)
+{
+	return lut + LUT_TABLE_SIZE;
+}
+
+static uint8_t *page(uint8_t *lut, uint32_t n)
+{
+	return lut + LUT_TABLE_SIZE + LUT_PAGE_SIZE + n*LUT_PAGE_SIZE;
+}
+
+static uint32_t numPages(uint32_t size)
+{
+	if (size<LUT_TABLE_SIZE+LUT_PAGE_SIZE)
+		return 0;
+	return (size-LUT_TABLE_SIZE-LUT_PAGE_SIZE)/LUT_PAGE_SIZE;
+}
+
+static void setRow(uint8_t *lut, uint32_t row, uint8_t *p)
+{
+	uint8_t **table = (uint8_t **)lut;
+
+	table[row*2] = p;
+	table[row*2+1] = p;
+}
+
+// find a page that no row is using
+static uint8_t *allocPage(uint8_t *lut, uint32_t size)
+{
+	uint8_t **table = (uint8_t **)lut;
+	uint8_t used[LUT_ROWS/8];
+	uint32_t i, n, pages = numPages(size);
+
+	memset(used, 0, sizeof(used));
+	for (i=0; i<LUT_ROWS; i++)
+	{
+		if (table[i*2]!=zeroPage(lut))
+		{
+			n = (table[i*2]-page(lut, 0))/LUT_PAGE_SIZE;
+			used[n>>3] |= 1<<(n&7);
+		}
+	}
+	for (i=0; i<pages && i<LUT_ROWS; i++)
+	{
+		if ((used[i>>3]&(1<<(i&7)))==0)
+		{
+			memset(page(lut, i), 0, LUT_PAGE_SIZE);
+			return page(lut, i);
+		}
+	}
+	return NULL;
+}
+
+int lut_init(uint8_t *lut, uint32_t size)
+{
+	uint32_t i;
+
+	if (numPages(size)==0)
+		return -1;
+
+	memset(zeroPage(lut), 0, LUT_PAGE_SIZE);
+	for (i=0; i<LUT_ROWS; i++)
+		setRow(lut, i, zeroPage(lut));
+
+	return 0;
+}
+
+// set len entries starting at flat index to value, allocating pages for rows that
+// become nonzero and returning rows that become all zero to the zero page
+int lut_set(uint8_t *lut, uint32_t size, uint32_t index, uint32_t len, uint8_t value)
+{
+	uint8_t **table = (uint8_t **)lut;
+	uint8_t *p;
+	uint32_t row, col, n, i;
+
+	if (index+len>LUT_FLAT_SIZE)
+		return -1;
+
+	while (len)
+	{
+		row = index>>8;
+		col = index&0xff;
+		n = LUT_PAGE_SIZE-col;
+		if (n>len)
+			n = len;
+		p = table[row*2];
+
+		if (p==zeroPage(lut))
+		{
+			if (value)
+			{
+				if ((p=allocPage(lut, size))==NULL)
+					return -2;
+				setRow(lut, row, p);
+				memset(p+col, value, n);
+			}
+		}
+		else
+		{
+			memset(p+col, value, n);
+			if (value==0)
+			{
+				for (i=0; i<LUT_PAGE_SIZE && p[i]==0; i++);
+				if (i==LUT_PAGE_SIZE)
+					setRow(lut, row, zeroPage(lut));
+			}
+		}
+
+		index += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+// build from a flat LUT
+int lut_build(uint8_t *lut, uint32_t size, const uint8_t *flat)
+{
+	uint32_t row, i;
+	uint8_t *p;
+
+	if (lut_init(lut, size)<0)
+		return -1;
+
+	for (row=0; row<LUT_ROWS; row++)
+	{
+		for (i=0; i<LUT_PAGE_SIZE && flat[(row<<8)+i]==0; i++);
+		if (i==LUT_PAGE_SIZE)
+			continue;
+		if ((p=allocPage(lut, size))==NULL)
+			return -2;
+		memcpy(p, flat+(row<<8), LUT_PAGE_SIZE);
+		setRow(lut, row, p);
+	}
+
+	return 0;
+}
+
+uint32_t lut_pagesUsed(const uint8_t *lut)
+{
+	uint8_t **table = (uint8_t **)lut;
+	uint32_t i, n;
+
+	for (i=0, n=0; i<LUT_ROWS; i++)
+	{
+		if (table[i*2]!=lut+LUT_TABLE_SIZE)
+			n++;
+	}
+	return n;
+}
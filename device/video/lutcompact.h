@@ -0,0 +1,32 @@
+#ifndef _LUTCOMPACT_H
+#define _LUTCOMPACT_H
+
+#include <inttypes.h>
+
+// Two-level color lookup table.  The flat LUT is indexed by
+// ((r-g)>>1 & 0xff)<<8 | ((b-g)>>1 & 0xff), and most of its 256 rows are empty,
+// so instead of 64K of flat table we keep a page pointer for each row and 256-byte
+// pages for the rows that have something in them.  Empty rows share one zero page.
+//
+// The page table is indexed by the 9-bit red-green difference ((r-g) & 0x1ff), so
+// the M0 doesn't have to shift it down first--- entries 2n and 2n+1 both point to
+// the page of row n.  Looking up an entry is a fixed 2 loads (see lineProcessedRL1A).
+//
+// Layout of the LUT memory:
+// | page table, LUT_TABLE_ENTRIES pointers | zero page | pages ... |
+
+#define LUT_ROWS            0x100
+#define LUT_PAGE_SIZE       0x100
+#define LUT_TABLE_ENTRIES   (LUT_ROWS*2)
+#define LUT_TABLE_SIZE      (LUT_TABLE_ENTRIES*sizeof(uint8_t *))
+#define LUT_FLAT_SIZE       (LUT_ROWS*LUT_PAGE_SIZE)
+
+// entry index is the flat LUT index
+#define LUT_GET(lut, index)	(((uint8_t **)(lut))[((index)>>7)&~1][(index)&0xff])
+
+int lut_init(uint8_t *lut, uint32_t size);
+int lut_set(uint8_t *lut, uint32_t size, uint32_t index, uint32_t len, uint8_t value);
+int lut_build(uint8_t *lut, uint32_t size, const uint8_t *flat);
+uint32_t lut_pagesUsed(const uint8_t *lut);
+
+#endif
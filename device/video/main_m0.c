@@ -1,17 +1,23 @@
 #include <debug.h>
 #include <chirp.h>
+#include <smlink.h>
+#include <hal.h>
 #include <cycletimer.h>
 #include <pixyvals.h>
 #include <cameravals.h>
+#include "qval.h"
+#include "rlsclip.h"
 
-#define CAM_PORT 		(LPC_GPIO_PORT->PIN[1])
-#define CAM_VSYNC() 	(CAM_PORT&0x1000)
-#define CAM_HSYNC() 	(CAM_PORT&0x800)
-#define CAM_PCLK_MASK   0x2000
+#define CAM_PORT 		HAL_CAM_PORT
+#define CAM_VSYNC() 	(hal_camPort()&HAL_CAM_VSYNC)
+#define CAM_HSYNC() 	(hal_camPort()&HAL_CAM_HSYNC)
+#define CAM_PCLK_MASK   HAL_CAM_PCLK
 
 #define ALIGN(v, n)  ((uint32_t)v&((n)-1) ? ((uint32_t)v&~((n)-1))+(n) : (uint32_t)v)
 
 uint8_t *g_logLut = NULL;
+// hal_us at the end of the last vsync (skipLines), when the frame being grabbed started
+uint32_t g_frameTime = 0;
 
 void vsync()
 {
@@ -721,7 +727,7 @@ __asm uint32_t *lineProcessedRL1A(uint32_t *gpio, uint32_t *memory, uint8_t *lut
 {
 // The code below does the following---
 // -- maintain pixel sync, read red and green pixels
-// -- create r-g, b-g index and look up value in lut
+// -- look up the r-g page in the two-level lut (see lutcompact.h), and the b-g value in the page
 // -- filter out noise within the line.  An on pixel surrounded by off pixels will be ignored.
 //    An off pixel surrounded by on pixels will be ignored.
 // -- generate hue line sum	and pseudo average
@@ -744,7 +750,7 @@ __asm uint32_t *lineProcessedRL1A(uint32_t *gpio, uint32_t *memory, uint8_t *lut
 //
 // r0: gpio	register
 // r1: scratch 
-// r2: lut
+// r2: lut page table
 // r3: prev line
 // r4: column 
 // r5: scratch
@@ -783,18 +789,18 @@ $lx		LDRB 	r5, [r0, r4] // load green pixel
 		MEND
 #endif	// RLTEST
 
-		MACRO // create index, lookup, inc col, extract model
+		MACRO // look up page, look up lut val, inc col, extract model
 $lx		LEXT	$rx
 $lx		RED
 		// cycle
 		SUBS	r6, r5   // red-green
-		ASRS	r6, #1	 // reduce 9 to 8 bits arithmetically
-		LSLS	r6, #24  // shift red-green and get rid of higher-order bits
-		LSRS	r6, #16  // shift red-green back, make it the higher 8 bits of the index
+		LSLS	r6, #23  // get rid of higher-order bits, keep 9 bits of red-green
+		LSRS	r6, #21  // shift red-green back, make it a word index into the page table
+		LDR		r6, [r2, r6] // load page pointer (the table has 2 entries per page, so no need to reduce 9 to 8 bits)
+		// cycle
 		LDRB	r5, [r3, r4] // load blue-green val
 		// cycle
-		ORRS	r5, r6   // form 16-bit index
-		LDRB	r1, [r2, r5] // load lut val
+		LDRB	r1, [r6, r5] // load lut val
 		// cycle
 		ADDS 	r4, #1 // inc col 
 		// *** PIXEL SYNC
@@ -970,6 +976,7 @@ void skipLines(uint32_t lines)
 	while(!CAM_VSYNC()); 
 	// vsync asserted
 	while(CAM_VSYNC());
+	g_frameTime = hal_us();
 	// skip lines
 	for (line=0; line<lines; line++)
 		skipLine();
@@ -1049,6 +1056,7 @@ int32_t getFrame(uint8_t *type, uint32_t *memory, uint16_t *xoffset, uint16_t *y
 	else
 		return -1;
 
+	CRP_RETURN(UINT32(g_frameTime), END);
 	return 0;
 }
 
@@ -1077,11 +1085,14 @@ uint32_t rgData[] =
 };
 #endif
 
-int32_t getRLSFrame(uint32_t *memory, uint32_t *size /*bytes*/, uint32_t *lut)
+// xoffset, yoffset, xwidth and ywidth are a window in q val columns and rows.  Rows above
+// the window are left empty (just the row marker) and the frame ends at the bottom of the
+// window, so row and column numbers are the same as for the whole frame.
+int32_t getRLSFrame(uint32_t *memory, uint32_t *size /*bytes*/, uint32_t *lut, uint16_t *xoffset, uint16_t *yoffset, uint16_t *xwidth, uint16_t *ywidth)
 {
 	uint8_t *lut2 = (uint8_t *)*lut;
 	uint32_t *memory2 = (uint32_t *)*memory;
-	uint32_t line;
+	uint32_t line, x1, y1, len;
 	uint32_t *memory2Orig = memory2; 
 	uint8_t *lineStore = (uint8_t *)memory2 + *size-CAM_RES2_WIDTH*2-4;
 	uint8_t *logLut = lineStore + CAM_RES2_WIDTH + 4;
@@ -1092,34 +1103,54 @@ int32_t getRLSFrame(uint32_t *memory, uint32_t *size /*bytes*/, uint32_t *lut)
 	 	createLogLut();
 	}
 
+	x1 = *xoffset + *xwidth;
+	if (x1>CAM_RES2_WIDTH || *xwidth==0)
+		x1 = CAM_RES2_WIDTH;
+	y1 = *yoffset + *ywidth;
+	if (y1>CAM_RES2_HEIGHT || *ywidth==0)
+		y1 = CAM_RES2_HEIGHT;
+
 	skipLines(0);
-	for (line=0; line<CAM_RES2_HEIGHT; line++)
+	// each row is 2 lines, see below
+	for (line=0; line<*yoffset && line<y1; line++)
+	{
+		*memory2++ = 0x0000;
+		skipLine();
+		skipLine();
+	}
+	for (; line<y1; line++)
 	{
 		// mark beginning of this row (column 0 = 0)
 		// column 0 is a symbolic column to the left of column 1.  (column 1 is the first real column of pixels)
 		// (there is an implied end of line before the begin of line) 
 		*memory2++ = 0x0000; 
-		lineProcessedRL0A((uint32_t *)&CAM_PORT, lineStore, CAM_RES2_WIDTH); 
+		// stopping at x1 saves the time and memory of the columns right of the window
+		lineProcessedRL0A((uint32_t *)&CAM_PORT, lineStore, x1); 
 #ifndef RLTEST
-		memory2 = lineProcessedRL1A((uint32_t *)&CAM_PORT, memory2, lut2, lineStore, CAM_RES2_WIDTH, g_logLut);
+		memory2 = lineProcessedRL1A((uint32_t *)&CAM_PORT, memory2, lut2, lineStore, x1, g_logLut);
 #else
-		memory2 = lineProcessedRL1A(rgData, memory2, lut2, (uint8_t *)bgData, CAM_RES2_WIDTH, g_logLut);
+		memory2 = lineProcessedRL1A(rgData, memory2, lut2, (uint8_t *)bgData, x1, g_logLut);
 #endif
 		if ((uint32_t *)lineStore-memory2<CAM_RES2_WIDTH/5)	// width/5 because that's the worst case with noise filtering
 		{
 #ifndef RLTEST
-			CRP_RETURN(UINT32(memory2 - memory2Orig), END); 
+			CRP_RETURN(UINT32(memory2 - memory2Orig), UINT32(g_frameTime), END); 
 			return -1; 
 #else
 			return memory2 - memory2Orig;
 #endif
 		}
 	}
+	// The left edge is clipped after the frame instead of after each row, where it would
+	// have to fit in the horizontal blanking.
+	len = memory2 - memory2Orig;
+	if (*xoffset)
+		len = rls_clipFrame(memory2Orig, len, *xoffset, g_logLut, QVAL_CCQ1);
 #ifndef RLTEST
-	CRP_RETURN(UINT32(memory2 - memory2Orig), END); 
+	CRP_RETURN(UINT32(len), UINT32(g_frameTime), END); 
 	return 0;
 #else
-	return memory2 - memory2Orig;
+	return len;
 #endif
 }
 
@@ -1135,6 +1166,7 @@ int main(void)
 		
 	printf("M0 start\n");
 
+	linkInit();
 	chirpOpen();
 	chirpSetProc("getFrame", (ProcPtr)getFrame);
 	chirpSetProc("getRLSFrame", (ProcPtr)getRLSFrame);
@@ -1155,6 +1187,7 @@ int main(void)
 	uint8_t *lut = (uint8_t *)SRAM0_LOC + 0x10000;
 	uint32_t memory = SRAM0_LOC;
 	uint32_t size = SRAM0_SIZE/2;
+	uint16_t xoffset = 0, yoffset = 0, xwidth = CAM_RES2_WIDTH, ywidth = CAM_RES2_HEIGHT;
 	for (i=0; i<0x10000; i++)
 		lut[i] = 0;
 	lut[0xb400] = 0;
@@ -1169,10 +1202,14 @@ int main(void)
 	lut[0xb409] = 0;
 
 	while(1)
- 		getRLSFrame(&memory, &size, (uint32_t *)&lut);
+ 		getRLSFrame(&memory, &size, (uint32_t *)&lut, &xoffset, &yoffset, &xwidth, &ywidth);
 }
 #endif
 	printf("M0 ready\n");
 	while(1)
-		chirpService();
+	{
+		// sleep until the M4 sends something
+		if (chirpService()==0)
+			__WFE();
+	}
 }
@@ -7,12 +7,12 @@
 #include "led.h"
 #include "conncomp.h"
 #include "rcservo.h"
+#include "servoloop.h"
 #include "spi.h"
-
-#define RLS_MEMORY_SIZE     0x8000 // bytes
-#define RLS_MEMORY          ((uint8_t *)SRAM0_LOC)
-#define LUT_MEMORY_SIZE		0x10000 // bytes
-#define LUT_MEMORY			((uint8_t *)SRAM0_LOC + SRAM0_SIZE-LUT_MEMORY_SIZE)  // +0x100 make room for prebuf and palette
+#include "qbuffers.h"
+#include "prof.h"
+#include "blobout.h"
+#include "scheduler.h"
 
 #define SERVO
 
@@ -25,82 +25,56 @@ extern int g_loop;
 #define XCENTER 160
 #define YCENTER 100
 #define YTRACK  160
-#define SERVO_CENTER 500
-#define SERVO_MAX    1000
-#define SERVO_MIN    0
-
-class ServoLoop
-{
-public:
-	ServoLoop(uint8_t axis, uint32_t pgain, uint32_t dgain);
-
-	void update(int32_t error);
-	void reset();
-
-private:
-	int32_t m_pos;
-	int32_t m_prevError;
-	uint8_t m_axis;
-	int32_t m_pgain;
-	int32_t m_dgain;
-};
-
-
-ServoLoop::ServoLoop(uint8_t axis, uint32_t pgain, uint32_t dgain)
-{
-	m_pos = SERVO_CENTER;
-	m_axis = axis;
-	m_pgain = pgain;
-	m_dgain = dgain;
-	m_prevError = 0x80000000;
-}
-
-void ServoLoop::update(int32_t error)
-{
-	int32_t vel;
-
-	if (m_prevError!=0x80000000)
-	{	
-		vel = (error*m_pgain + (error - m_prevError)*m_dgain)/1000;
-		m_pos += vel;
-		if (m_pos>SERVO_MAX) 
-			m_pos = SERVO_MAX; 
-		else if (m_pos<SERVO_MIN) 
-			m_pos = SERVO_MIN;
-
-		rcs_setPos(m_axis, m_pos);
-		//printf("%d %d %d\n", m_axis, m_pos, vel);
-	}
-	m_prevError = error;
-}
-void ServoLoop::reset()
-{
-	m_pos = SERVO_CENTER;
-	rcs_setPos(m_axis, m_pos);
-}
 
-void servo(uint32_t x, uint32_t y)
+static ServoLoop g_xloop(0, 400, 1000);
+static ServoLoop g_yloop(1, 400, 1000);
+
+// the main loop's tasks (see blobProcess), in priority order
+static int32_t servoTask(uint32_t budget);
+static int32_t m0Task(uint32_t budget);
+static int32_t spiTask(uint32_t budget);
+static int32_t blobTask(uint32_t budget);
+static int32_t usbTask(uint32_t budget);
+
+Sched g_sched;
+SchedTask g_servoTask = {"servo", servoTask,   100, 0};             // signaled by servoTick
+SchedTask g_m0Task =    {"m0",    m0Task,      200, 1, SCHED_POLL}; // frame results, next frame
+SchedTask g_spiTask =   {"spi",   spiTask,     100, 2};             // signaled by blobTask
+SchedTask g_blobTask =  {"blobs", blobTask,  15000, 3, SCHED_POLL};
+SchedTask g_usbTask =   {"usb",   usbTask,    2000, 4, SCHED_POLL};
+
+// x, y of the frame captured at time (hal_us), the servos move at the next servoTick
+void servo(uint32_t x, uint32_t y, uint32_t time)
 {
-	static ServoLoop xloop(0, 400, 1000);
-	static ServoLoop yloop(1, 400, 1000);
 	static int lastLoop = 0;
 	int32_t xerror, yerror;
 #if 1
 	if (lastLoop && !g_loop)
 	{
-		xloop.reset();
-		yloop.reset();
+		g_xloop.reset();
+		g_yloop.reset();
+		lastLoop = g_loop;
 		return;
 	}
 #endif
 	xerror = x-XCENTER;
 	yerror = -(y-YCENTER);
-	xloop.update(xerror);
-	yloop.update(yerror);
+	g_xloop.measure(xerror, time);
+	g_yloop.measure(yerror, time);
 
 	lastLoop = g_loop;
 }
 
+// servo timer interrupt (rcs_setTickCallback)
+void servoTick(void)
+{
+	uint32_t time = hal_us();
+
+	g_xloop.tick(time);
+	g_yloop.tick(time);
+	sched_signal(&g_servoTask);
+}
+
 class MotorLoop
 {
 public:
@@ -312,25 +286,70 @@ void handleButton()
 	btPrev = bt;
 }
 
-#define QMEMSIZE   0x800
-uint32_t g_qmem[QMEMSIZE];
-uint32_t g_numRls = 0;
+// RLS memory is split into q val buffers, the M0 fills one while we assemble another
+#define QBUFFERS   2
+QBuffers g_qbufs;
+QBuffer *g_qfilling = NULL;
+uint32_t g_qfillStart;
+// set by claimFrames, no frames are started until the usb task's done
+uint8_t g_qheld = 0;
+
+// blobs of each frame for the SPI port, the SSP interrupt sends them (transmitCallback)
+BlobOut g_blobOut;
 
-int getRLSFrameCallback(const int32_t &responsInt, const uint32_t &numRls)
+// kick off the next frame into a free buffer, if there is one
+void getNextFrame(void)
 {
-	g_numRls = numRls;
+	if (g_qfilling)
+		return;
+	if ((g_qfilling=qb_produce(&g_qbufs)))
+	{
+		g_qfillStart = CTIMER_NOW();
+		cc_getRLSFrame(g_qfilling->memory, g_qfilling->size, LUT_MEMORY, NULL, false);
+	}
+}
+
+int getRLSFrameCallback(const int32_t &responsInt, const uint32_t &numRls, const uint32_t &time)
+{
+	if (g_qfilling==NULL)
+		return 0;
+	if (responsInt<0)
+		qb_cancel(g_qfilling);
+	else
+	{
+		PROF_ADD(RLS_FRAME, CTIMER_NOW()-g_qfillStart);
+		g_qfilling->time = time;
+		qb_publish(&g_qbufs, g_qfilling, numRls);
+	}
+	g_qfilling = NULL;
 	return 0;
 }
 
+// USB procs that grab frames themselves (cam_claim) would take the M0's answer for our frame 
+// and write over the q val buffers, so let the frame come back and drop what's waiting
+void claimFrames(void)
+{
+	QBuffer *frame;
+
+	while(g_qfilling)
+		g_chirpM0->service();
+	while((frame=qb_consume(&g_qbufs)))
+		qb_release(frame);
+	g_qheld = 1;
+}
+
 #if 0
 void blobProcess(void)
 {
-	uint32_t result, i, j=0;
-	uint32_t x, y, *memory = (uint32_t *)RLS_MEMORY;
+	uint32_t j=0;
+	uint32_t x, y, time;
 	int16_t bdata[8];
+	QBuffer *frame;
 
+	qb_init(&g_qbufs, RLS_MEMORY, RLS_MEMORY_SIZE, QBUFFERS);
+	cam_setClaimCallback(claimFrames);
    	// get first frame (primer)
-	result = cc_getRLSFrame(memory, RLS_MEMORY_SIZE, LUT_MEMORY, &g_numRls);
+	getNextFrame();
 	
 		
 	while(1)
@@ -339,7 +358,7 @@ void blobProcess(void)
 		{
 		// service calls
 #ifdef SERVO						   
-			servo(XCENTER, YCENTER);
+			servo(XCENTER, YCENTER, hal_us());
 #else
 	  		motor(XCENTER, YTRACK);
 #endif		
@@ -348,30 +367,31 @@ void blobProcess(void)
 		}
 		else
 		{		
-			// copy
-			if (g_numRls>QMEMSIZE)
-				g_numRls = QMEMSIZE;
-			for (i=0; i<g_numRls; i++)
-				g_qmem[i] = memory[i];
-
-
-			// kick off next frame
-			cc_getRLSFrame(memory, RLS_MEMORY_SIZE, LUT_MEMORY, NULL, false);
-			// process this one
-			cc_getMaxBlob(g_qmem, g_numRls, bdata);
+			// wait for a frame
+			while((frame=qb_consume(&g_qbufs))==NULL)
+			{
+				getNextFrame();
+				g_chirpM0->service();
+			}
+			// kick off next frame into the other buffer
+			getNextFrame();
+			// process this one in place
+			cc_getMaxBlob(frame->memory, frame->len, bdata);
+			time = frame->time;
+			qb_release(frame);
 			if (bdata[0]>0)
 			{
 				x = bdata[0]+(bdata[1]-bdata[0])/2;
 				y = bdata[2]+(bdata[3]-bdata[2])/2;
 #ifdef SERVO
-				servo(x, y);
+				servo(x, y, time);
 #else
 				motor(x, y);
 #endif
 			}
 			else
 #ifdef SERVO						   
-				servo(XCENTER, YCENTER);
+				servo(XCENTER, YCENTER, time);
 #else
 	  			motor(XCENTER, YTRACK);
 #endif		
@@ -386,7 +406,7 @@ void blobProcess(void)
 			j++;   			
 #endif
 			// check for result
-			while(!g_chirpM0->service());
+			g_chirpM0->service();
 
 			// service calls
 			while(g_chirpUsb->service());
@@ -434,6 +454,15 @@ uint32_t detect(uint32_t x, uint32_t y)
 }
 #define YOFFS  20
 
+#define MOVE_NONE    0
+#define MOVE_CENTER  1
+#define MOVE_RANDOM  2
+
+// move the blob stage wants, done by the servo task at the next servo period
+uint8_t g_move = MOVE_CENTER;
+// hal_us when the servos get where move sent them, frames captured before then are skipped
+uint32_t g_settled = 0;
+
 void move(uint32_t mode)
 {
 	static int32_t x = SERVO_CENTER;
@@ -448,7 +477,7 @@ void move(uint32_t mode)
 		rcs_setPos(0, x);
 		rcs_setPos(1, y);
 
-		delayus(250000);
+		g_settled = hal_us() + 250000;
 	}
 	else
 	{
@@ -471,68 +500,109 @@ void move(uint32_t mode)
 		}
 		rcs_setPos(0, x);
 		rcs_setPos(1, y);
-		delayus(150000);
+		g_settled = hal_us() + 150000;
 	}
 }
 
-void blobProcess(void)
+// the moves block nothing, frames are skipped until the servos settle
+static int32_t servoTask(uint32_t budget)
 {
-	uint32_t result, i, j=0;
-	uint32_t x, y, loseCount=0, *memory = (uint32_t *)RLS_MEMORY;
-	int16_t bdata[8];
+	if (g_move==MOVE_NONE)
+		return 0;
+	move(g_move==MOVE_CENTER);
+	g_move = MOVE_NONE;
+	return 1;
+}
 
-   	move(1);
+static int32_t m0Task(uint32_t budget)
+{
+	int32_t n;
+
+	// check for result (getRLSFrameCallback)
+	n = g_chirpM0->service();
+	// kick off next frame into the free buffer
+	if (g_loop && !g_qheld)
+		getNextFrame();
+	return n;
+}
 
-   	// get first frame (primer)
-	result = cc_getRLSFrame(memory, RLS_MEMORY_SIZE, LUT_MEMORY, &g_numRls);
-			
-	while(1)
+static int32_t spiTask(uint32_t budget)
+{
+	return spi_refill();
+}
+
+static int32_t blobTask(uint32_t budget)
+{
+	static uint32_t loseCount = 0;
+	uint32_t x, y, n, time;
+	BoBlob blobs[BO_MAX_BLOBS];
+	QBuffer *frame;
+
+	if (!g_loop || (frame=qb_consume(&g_qbufs))==NULL)
+		return 0;
+	time = frame->time;
+	if (g_move!=MOVE_NONE || (int32_t)(time-g_settled)<0)
 	{
-		if (!g_loop)
+		qb_release(frame);
+		return 1;
+	}
+	// process this one in place
+	n = cc_getBlobs(frame->memory, frame->len, blobs, BO_MAX_BLOBS);
+	qb_release(frame);
+	bo_write(&g_blobOut, blobs, n);
+	sched_signal(&g_spiTask);
+	PROF_ADD(LATENCY, (hal_us()-time)*CLKFREQ_US);
+	if (n>0)
+	{
+		loseCount = 0;
+		x = blobs[0].x;
+		y = blobs[0].y;
+		//servo(x, y, time);
+		//printf("%d %d\n", x, y);
+		if (detect(x, y))
 		{
-		// service calls
-			while(g_chirpUsb->service());
-			handleButton();
+			//printf("***\n");
+			g_move = MOVE_RANDOM;
 		}
-		else
-		{		
-			// copy
-			if (g_numRls>QMEMSIZE)
-				g_numRls = QMEMSIZE;
-			for (i=0; i<g_numRls; i++)
-				g_qmem[i] = memory[i];
+	}
+	else
+	{
+		loseCount++;
+		if (loseCount==10)
+ 			g_move = MOVE_CENTER;
+	}
+	return 1;
+}
 
+// service calls until there are no more or the budget's up, the rest wait for the next round
+static int32_t usbTask(uint32_t budget)
+{
+	uint32_t start = hal_us();
+	int32_t n, calls;
+
+	PROF_START(CHIRP_SERVICE);
+	for (calls=0; hal_us()-start<budget && (n=g_chirpUsb->service()); calls+=n);
+	if (calls)
+		PROF_STOP(CHIRP_SERVICE);
+	if (!g_loop)
+		handleButton();
+	g_qheld = 0;
+	return calls;
+}
 
-			// kick off next frame
-			cc_getRLSFrame(memory, RLS_MEMORY_SIZE, LUT_MEMORY, NULL, false);
-			// process this one
-			cc_getMaxBlob(g_qmem, g_numRls, bdata);
-			if (bdata[0]>0)
-			{
-				loseCount = 0;
-				x = bdata[0]+(bdata[1]-bdata[0])/2;
-				y = bdata[2]+(bdata[3]-bdata[2])/2;
-				//servo(x, y);
-				//printf("%d %d\n", x, y);
-				if (detect(x, y))
-				{
-					//printf("***\n");
-					move(0);
-				}
-			}
-			else
-			{
-				loseCount++;
-				if (loseCount==10)
- 					move(1);
-			}
-			// check for result
-			while(!g_chirpM0->service());
+void blobProcess(void)
+{
+	qb_init(&g_qbufs, RLS_MEMORY, RLS_MEMORY_SIZE, QBUFFERS);
+	cam_setClaimCallback(claimFrames);
 
-			// service calls
-			while(g_chirpUsb->service());
-		}
-	} 		
+	sched_init(&g_sched);
+	sched_add(&g_sched, &g_servoTask);
+	sched_add(&g_sched, &g_m0Task);
+	sched_add(&g_sched, &g_spiTask);
+	sched_add(&g_sched, &g_blobTask);
+	sched_add(&g_sched, &g_usbTask);
+
+	sched_run(&g_sched);
 }
 #endif
 
@@ -573,20 +643,17 @@ int32_t r(int32_t val, int32_t p)
 }
 
 
+// called from the SSP interrupt
 uint32_t transmitCallback(uint16_t *data, uint32_t len)
 {
-	uint32_t i, j;
-
-	for (i=0, j=0; i<10; i++, j+=2)
-		data[i] = (j<<8) + j+1;
-
-	return 10;
+	return bo_transmit(&g_blobOut, data, len);
 } 	
 
 int main(void) 
  {	
  	pixyInit(SRAM3_LOC, &LR0[0], sizeof(LR0));
 	cc_init(g_chirpUsb);
+	prof_init(g_chirpUsb);
 #if 0	
 	uint32_t a = 0xffffffff;
 	uint32_t b = 0;
@@ -608,10 +675,16 @@ int main(void)
 	}
 #endif
 #if 1
+	bo_init(&g_blobOut);
+	spi_setCallback(transmitCallback);
+	rcs_setTickCallback(servoTick);
+	g_chirpM0->getProc("getRLSFrame", (ProcPtr)getRLSFrameCallback);
 
-	uint16_t buf[16];
+   	blobProcess();
+#endif
+#if 0
 
-	spi_setCallback(transmitCallback);
+	uint16_t buf[16];
 
  	while(1)
 	{
@@ -673,12 +746,6 @@ int main(void)
 		handleButton();
 	}
 #endif
-#if 0
-	g_chirpM0->getProc("getRLSFrame", (ProcPtr)getRLSFrameCallback);
-
-   	blobProcess();
-
-#endif
 
 #if 0
 #define SERVO
@@ -743,7 +810,7 @@ int main(void)
 #endif
 			}
 #ifdef SERVO
-			servo(xavg, yavg);
+			servo(xavg, yavg, hal_us());
 #else
 			motor(xavg, yavg);
 #endif
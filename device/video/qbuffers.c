@@ -0,0 +1,101 @@
+#include "qbuffers.h"
+
+int qb_init(struct QBuffers *qb, uint8_t *memory, uint32_t size, uint8_t num)
+{
+	uint32_t i, bufSize;
+
+	if (num==0 || num>QB_MAX_BUFFERS)
+		return -1;
+
+	bufSize = (size/num)&~0x03;
+	for (i=0; i<num; i++)
+	{
+		qb->buf[i].memory = (uint32_t *)(memory + i*bufSize);
+		qb->buf[i].size = bufSize;
+		qb->buf[i].len = 0;
+		qb->buf[i].seq = 0;
+		qb->buf[i].state = QB_FREE;
+	}
+	qb->num = num;
+	qb->seq = 0;
+	qb->consumed = 0;
+	qb->dropped = 0;
+
+	return 0;
+}
+
+struct QBuffer *qb_produce(struct QBuffers *qb)
+{
+	uint32_t i;
+
+	for (i=0; i<qb->num; i++)
+	{
+		if (qb->buf[i].state==QB_FREE)
+		{
+			qb->buf[i].state = QB_FILLING;
+			return &qb->buf[i];
+		}
+	}
+	return 0;
+}
+
+void qb_publish(struct QBuffers *qb, struct QBuffer *buf, uint32_t len)
+{
+	buf->len = len;
+	buf->seq = ++qb->seq;
+	// the consumer has to see len and seq before the state
+	QB_BARRIER();
+	buf->state = QB_READY;
+}
+
+void qb_cancel(struct QBuffer *buf)
+{
+	QB_BARRIER();
+	buf->state = QB_FREE;
+}
+
+struct QBuffer *qb_consume(struct QBuffers *qb)
+{
+	uint32_t i, n;
+	uint8_t ready[QB_MAX_BUFFERS];
+	struct QBuffer *newest;
+
+	for (i=0, n=0; i<qb->num; i++)
+	{
+		if (qb->buf[i].state==QB_READY)
+			ready[n++] = i;
+	}
+	if (n==0)
+		return 0;
+	// read seq, len and the q vals only after the state
+	QB_BARRIER();
+
+	for (i=1, newest=&qb->buf[ready[0]]; i<n; i++)
+	{
+		if ((int32_t)(qb->buf[ready[i]].seq-newest->seq)>0)
+		{
+			newest->state = QB_FREE;
+			newest = &qb->buf[ready[i]];
+		}
+		else
+			qb->buf[ready[i]].state = QB_FREE;
+		qb->dropped++;
+	}
+	if ((int32_t)(newest->seq-qb->consumed)<=0)
+	{
+		newest->state = QB_FREE;
+		qb->dropped++;
+		return 0;
+	}
+	newest->state = QB_ASSEMBLING;
+	qb->consumed = newest->seq;
+
+	return newest;
+}
+
+void qb_release(struct QBuffer *buf)
+{
+	// done reading the q vals before the producer can have them
+	QB_BARRIER();
+	buf->state = QB_FREE;
+}
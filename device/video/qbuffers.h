@@ -0,0 +1,74 @@
+#ifndef _QBUFFERS_H
+#define _QBUFFERS_H
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Q val buffers that are handed back and forth between whoever fills them with frames
+// (the producer, the M0's getRLSFrame) and whoever assembles blobs from them (the consumer,
+// the M4), so a frame can be captured while the last one is being processed, without copying.
+//
+// Each buffer is owned by one side at a time, and each state change is made by one side only:
+//   QB_FREE -> QB_FILLING        producer, qb_produce
+//   QB_FILLING -> QB_READY       producer, qb_publish
+//   QB_FILLING -> QB_FREE        producer, qb_cancel
+//   QB_READY -> QB_ASSEMBLING    consumer, qb_consume
+//   QB_READY -> QB_FREE          consumer, qb_consume (older frames than the one it takes)
+//   QB_ASSEMBLING -> QB_FREE     consumer, qb_release
+// so with one producer and one consumer no locking is needed, only a barrier before
+// each state change.  Buffers get a sequence number when they're published, and the
+// consumer always takes the newest ready frame.  A frame can be published after the
+// consumer has looked at its buffer and before it takes a newer one, so frames older than
+// the last one taken are dropped too.
+
+#define QB_MAX_BUFFERS      3
+
+#define QB_FREE             0
+#define QB_FILLING          1
+#define QB_READY            2
+#define QB_ASSEMBLING       3
+
+#ifdef __GNUC__
+#define QB_BARRIER()        __sync_synchronize()
+#else
+#define QB_BARRIER()        __dmb(0xf)
+#endif
+
+struct QBuffer
+{
+	uint32_t *memory;
+	uint32_t size;          // bytes
+	volatile uint32_t len;  // q vals, set when published
+	volatile uint32_t seq;
+	volatile uint8_t state;
+	uint32_t time;          // producer's, when the frame was captured (hal_us at vsync)
+};
+
+struct QBuffers
+{
+	struct QBuffer buf[QB_MAX_BUFFERS];
+	uint8_t num;
+	uint32_t seq;           // producer's
+	uint32_t consumed;      // consumer's, seq of the last frame it took
+	uint32_t dropped;       // consumer's, ready frames freed without being assembled
+};
+
+// splits memory into num buffers (word aligned)
+int qb_init(struct QBuffers *qb, uint8_t *memory, uint32_t size, uint8_t num);
+
+struct QBuffer *qb_produce(struct QBuffers *qb);
+void qb_publish(struct QBuffers *qb, struct QBuffer *buf, uint32_t len);
+void qb_cancel(struct QBuffer *buf);
+
+// NULL if no frame is ready
+struct QBuffer *qb_consume(struct QBuffers *qb);
+void qb_release(struct QBuffer *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
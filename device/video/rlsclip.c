@@ -0,0 +1,41 @@
+#include "rlsclip.h"
+#include "qval.h"
+
+uint32_t rls_clipFrame(uint32_t *memory, uint32_t len, uint32_t x0, const uint8_t *shiftLut, uint32_t format)
+{
+	uint32_t i, j, q, begin, n, end, shift, sum;
+
+	for (i=0, j=0; i<len; i++)
+	{
+		q = memory[i];
+		if (q)
+		{
+			begin = QVAL_BEGIN(format, q);
+			n = QVAL_LEN(format, q);
+			end = begin + n;
+			if (end<=x0)
+				continue;
+			if (begin<x0)
+			{
+				if (format==QVAL_CCQ2)
+				{
+					sum = (q>>25)<<shiftLut[n];
+					sum = sum*(end-x0)/n;
+					n = end-x0;
+					q = QVAL_CCQ2_MAKE(QVAL_MODEL(q), x0, n, sum>>shiftLut[n]);
+				}
+				else
+				{
+					// | 4 shift val | 7 shifted sum | 9 length | 9 begin col | 3 model |
+					shift = q>>28;
+					sum = (((q>>21)&0x7f)<<shift)*(end-x0)/n;
+					n = end-x0;
+					shift = shiftLut[n];
+					q = QVAL_MODEL(q) | (x0<<3) | (n<<12) | (((sum>>shift)&0x7f)<<21) | (shift<<28);
+				}
+			}
+		}
+		memory[j++] = q;
+	}
+	return j;
+}
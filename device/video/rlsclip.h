@@ -0,0 +1,20 @@
+#ifndef _RLSCLIP_H
+#define _RLSCLIP_H
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Clips a frame of q vals (rows start with a 0, see qval.h for the formats) to the
+// columns at or right of x0.  Q vals that end at or before x0 are removed, and one that
+// straddles x0 is shortened, with its sum scaled down to match.  The q vals are moved down
+// in place, returns the new number of q vals.
+uint32_t rls_clipFrame(uint32_t *memory, uint32_t len, uint32_t x0, const uint8_t *shiftLut, uint32_t format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
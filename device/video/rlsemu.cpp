@@ -0,0 +1,120 @@
+#include "rlsemu.h"
+#include "lutcompact.h"
+#include "rlsclip.h"
+
+void rls_emuLine0(const uint8_t *pixels, uint8_t *lineStore, uint32_t width)
+{
+	uint32_t i;
+
+	for (i=0; i<width; i++)
+		lineStore[i] = ((int32_t)pixels[i*2] - (int32_t)pixels[i*2+1])>>1; // (blue-green)/2
+}
+
+// LEXT: look up the pixel pair at col, return the lut val
+static uint8_t lext(const uint8_t *pixels, const uint8_t *lut, bool flat, const uint8_t *lineStore, uint32_t width, uint32_t col)
+{
+	int32_t rg;
+
+	// after a q val the M0 does one lookup without an end of line check, past the end of
+	// the line (hsync is low)--- take that as a zero lut val
+	if (col>=width)
+		return 0;
+	rg = (int32_t)pixels[col*2+1] - (int32_t)pixels[col*2];
+
+	if (flat)
+		return lut[((rg>>1)&0xff)<<8 | lineStore[col]];
+	return ((const uint8_t * const *)lut)[rg&0x1ff][lineStore[col]];
+}
+
+// QVAL
+static uint32_t qval(uint32_t col, uint32_t begin, uint32_t model, uint32_t sum, const uint8_t *shiftLut, uint32_t format)
+{
+	uint32_t len = col - begin;
+	uint32_t shift = shiftLut[len];
+
+	if (format==QVAL_CCQ2)
+		return QVAL_CCQ2_MAKE(model, begin, len, sum>>shift);
+	return (begin<<3) | model | (len<<12) | ((sum>>shift)<<21) | (shift<<28);
+}
+
+uint32_t *rls_emuLine1(const uint8_t *pixels, uint32_t *memory, const uint8_t *lut, bool flat,
+	const uint8_t *lineStore, uint32_t width, const uint8_t *shiftLut, uint32_t format)
+{
+	uint32_t col, begin=0, model=0, sum, last=0, val;
+
+	col = 0;
+zero0:
+	sum = 0;
+	if (col>=width)
+		goto eol;
+zero1:
+	val = lext(pixels, lut, flat, lineStore, width, col++);
+	model = val&0x07;
+	if (model==0)
+		goto zero0;
+	begin = col;
+	sum += val;
+	if (col>=width)
+		goto eol;
+	val = lext(pixels, lut, flat, lineStore, width, col++);
+	if ((val&0x07)!=model)
+		goto zero0;
+one:
+	last = val;
+	sum += val;
+	if (col>=width)
+		goto eol;
+	val = lext(pixels, lut, flat, lineStore, width, col++);
+	if ((val&0x07)==model)
+		goto one;
+	sum += last;
+	if (col>=width)
+		goto eol;
+	val = lext(pixels, lut, flat, lineStore, width, col++);
+	if ((val&0x07)==model)
+		goto one;
+	// 2nd pixel not equal--- run length is done, the next pixel pair is skipped
+	*memory++ = qval(col, begin, model, sum, shiftLut, format);
+	sum = 0;
+	col++;
+	goto zero1;
+
+eol:
+	if (sum)
+		*memory++ = qval(col, begin, model, sum, shiftLut, format);
+	return memory;
+}
+
+int32_t rls_emuFrame(const uint8_t *frame, uint32_t width, uint32_t height, uint32_t *memory, uint32_t size,
+	const uint8_t *lut, bool flat, const uint8_t *shiftLut,
+	uint16_t xoffset, uint16_t yoffset, uint16_t xwidth, uint16_t ywidth, uint32_t format)
+{
+	uint32_t line, x1, y1;
+	uint32_t *memory2 = memory;
+	uint32_t *end = (uint32_t *)((uint8_t *)memory + size-width*2-4); // where getRLSFrame keeps its line store
+	uint8_t lineStore[0x800];
+
+	if (width>(uint32_t)QVAL_MAX_COLS(format))
+		return -1;
+
+	x1 = xoffset + xwidth;
+	if (x1>width || xwidth==0)
+		x1 = width;
+	y1 = yoffset + ywidth;
+	if (y1>height || ywidth==0)
+		y1 = height;
+
+	for (line=0; line<yoffset && line<y1; line++, frame+=width*4)
+		*memory2++ = 0;
+	for (; line<y1; line++, frame+=width*4)
+	{
+		*memory2++ = 0;
+		rls_emuLine0(frame, lineStore, x1);
+		memory2 = rls_emuLine1(frame+width*2, memory2, lut, flat, lineStore, x1, shiftLut, format);
+		if (end-memory2<(int32_t)width/5)
+			return -1;
+	}
+	if (xoffset)
+		return rls_clipFrame(memory, memory2-memory, xoffset, shiftLut, format);
+	return memory2-memory;
+}
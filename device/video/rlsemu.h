@@ -0,0 +1,29 @@
+#ifndef _RLSEMU_H
+#define _RLSEMU_H
+
+#include <inttypes.h>
+#include "qval.h"
+
+// C models of the M0 run-length line routines in main_m0.c, so the q-vals they produce
+// can be checked off-target (eg, a flat LUT against the two-level LUT in lutcompact.h).
+// They follow the assembly step for step, including the pixel pair that is skipped
+// while a q val is written.
+
+// models lineProcessedRL0A: pixels are width blue, green pairs
+void rls_emuLine0(const uint8_t *pixels, uint8_t *lineStore, uint32_t width);
+
+// models lineProcessedRL1A: pixels are width green, red pairs, returns the end of the
+// q vals written.  With flat set, lut is a flat 64K LUT (the original lookup),
+// otherwise it's a two-level LUT.  format is QVAL_CCQ1 (what the M0 makes) or QVAL_CCQ2
+// for widths past 511, in which case shiftLut needs width+1 entries.
+uint32_t *rls_emuLine1(const uint8_t *pixels, uint32_t *memory, const uint8_t *lut, bool flat,
+	const uint8_t *lineStore, uint32_t width, const uint8_t *shiftLut, uint32_t format=QVAL_CCQ1);
+
+// models getRLSFrame on a raw bayer frame of 2*height lines of 2*width pixels (blue-green
+// line, then green-red line), returns the number of q vals or -1 if memory runs out.
+// xoffset, yoffset, xwidth, ywidth is the window, as in getRLSFrame (0 widths for the whole frame).
+int32_t rls_emuFrame(const uint8_t *frame, uint32_t width, uint32_t height, uint32_t *memory, uint32_t size,
+	const uint8_t *lut, bool flat, const uint8_t *shiftLut,
+	uint16_t xoffset=0, uint16_t yoffset=0, uint16_t xwidth=0, uint16_t ywidth=0, uint32_t format=QVAL_CCQ1);
+
+#endif
@@ -0,0 +1,97 @@
+#include "chirp.hpp"
+#include "rcservo.h"
+#include "servoloop.h"
+
+#define SL_NO_ERROR  ((int32_t)0x80000000)
+
+#ifdef __GNUC__
+#define SL_BARRIER()        __sync_synchronize()
+#else
+#define SL_BARRIER()        __dmb(0xf)
+#endif
+
+ServoLoop::ServoLoop(uint8_t axis, uint32_t pgain, uint32_t dgain)
+{
+	m_pos = SERVO_CENTER;
+	m_axis = axis;
+	m_pgain = pgain;
+	m_dgain = dgain;
+	m_prevError = SL_NO_ERROR;
+	m_current = 0;
+	m_meas[0].valid = 0;
+	m_meas[0].reset = 0;
+	m_lastError = 0;
+	m_lastTime = 0;
+	m_lastValid = 0;
+}
+
+void ServoLoop::publish(int32_t error, int32_t vel, uint32_t time, uint8_t valid, uint8_t reset)
+{
+	Measurement *m = &m_meas[m_current^1];
+
+	m->error = error;
+	m->vel = vel;
+	m->time = time;
+	m->valid = valid;
+	m->reset = reset;
+	SL_BARRIER();
+	m_current ^= 1;
+}
+
+void ServoLoop::measure(int32_t error, uint32_t time)
+{
+	uint32_t dt = time - m_lastTime;
+	int32_t vel = 0;
+
+	// a velocity from measurements too far apart (or the same frame) isn't worth much
+	if (m_lastValid && dt>0 && dt<SL_MAX_PREDICT)
+		vel = (int64_t)(error - m_lastError)*1000000/dt;
+	publish(error, vel, time, 1, 0);
+
+	m_lastError = error;
+	m_lastTime = time;
+	m_lastValid = 1;
+}
+
+void ServoLoop::tick(uint32_t time)
+{
+	const Measurement *m = &m_meas[m_current];
+	uint32_t dt;
+	int32_t error, vel;
+
+	if (m->reset)
+	{
+		m_pos = SERVO_CENTER;
+		m_prevError = SL_NO_ERROR;
+		rcs_setPos(m_axis, m_pos);
+		return;
+	}
+	dt = time - m->time;
+	if (!m->valid || dt>SL_TIMEOUT)
+	{
+		m_prevError = SL_NO_ERROR;
+		return;
+	}
+	if (dt>SL_MAX_PREDICT)
+		dt = SL_MAX_PREDICT;
+	error = m->error + (int32_t)((int64_t)m->vel*dt*SL_PREDICT/100000000);
+
+	if (m_prevError!=SL_NO_ERROR)
+	{	
+		vel = (error*m_pgain + (error - m_prevError)*m_dgain)/1000;
+		m_pos += vel;
+		if (m_pos>SERVO_MAX) 
+			m_pos = SERVO_MAX; 
+		else if (m_pos<SERVO_MIN) 
+			m_pos = SERVO_MIN;
+
+		rcs_setPos(m_axis, m_pos);
+	}
+	m_prevError = error;
+}
+
+void ServoLoop::reset()
+{
+	m_lastValid = 0;
+	publish(0, 0, 0, 0, 1);
+}
@@ -0,0 +1,66 @@
+#ifndef _SERVOLOOP_H
+#define _SERVOLOOP_H
+
+#include <inttypes.h>
+
+#define SERVO_CENTER 500
+#define SERVO_MAX    1000
+#define SERVO_MIN    0
+
+#define SL_MAX_PREDICT  100000 // us, furthest the error is extrapolated past a measurement
+#define SL_TIMEOUT      250000 // us, older measurements are ignored (the servo holds)
+#define SL_PREDICT      50     // percent of the extrapolation that's used
+
+// PD loop that moves a servo (rcs_setPos) to drive the error to 0, gains are /1000.
+//
+// The loop runs from the servo timer (tick, every HAL_SERVO_PERIOD), not from the frame loop,
+// so the servo is updated at a fixed rate however long frames take to process.  Each
+// measurement comes with the time its frame was captured, and each tick extrapolates
+// the error from the last 2 measurements (constant velocity) to the tick's time, which
+// makes up for the time between capture and the measurement, and keeps the derivative
+// on a known dt.  The error's velocity is partly the servo's own, which the extrapolation
+// counts again, so only SL_PREDICT of it is used--- all of it makes the loop oscillate
+// once frames take longer than a couple of ticks.
+//
+// measure and reset are called from the main loop and tick from the timer interrupt,
+// which preempts the main loop and not the other way around.  So measurements are
+// double buffered: the main loop fills the slot tick isn't reading, then flips m_current.
+class ServoLoop
+{
+public:
+	ServoLoop(uint8_t axis, uint32_t pgain, uint32_t dgain);
+
+	// error of the frame captured at time (hal_us)
+	void measure(int32_t error, uint32_t time);
+	void tick(uint32_t time);
+	// centers the servo at the next tick
+	void reset();
+
+private:
+	struct Measurement
+	{
+		int32_t error;
+		int32_t vel;    // error per second
+		uint32_t time;
+		uint8_t valid;
+		uint8_t reset;
+	};
+
+	void publish(int32_t error, int32_t vel, uint32_t time, uint8_t valid, uint8_t reset);
+
+	// main loop's
+	Measurement m_meas[2];
+	volatile uint8_t m_current;
+	int32_t m_lastError;
+	uint32_t m_lastTime;
+	uint8_t m_lastValid;
+
+	// tick's
+	int32_t m_pos;
+	int32_t m_prevError;
+	uint8_t m_axis;
+	int32_t m_pgain;
+	int32_t m_dgain;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "chirpcli.h"
+#include "streamer.h"
+
+ChirpCli::ChirpCli(Streamer *streamer)
+{
+    m_hinterested = true;
+    m_streamer = streamer;
+}
+
+ChirpCli::~ChirpCli()
+{
+}
+
+int ChirpCli::open()
+{
+    int res;
+
+    if ((res=m_link.open())<0)
+        return res;
+
+    setLink(&m_link);
+
+    return 0;
+}
+
+int ChirpCli::init()
+{
+    return remoteInit();
+}
+
+int ChirpCli::serviceChirp()
+{
+    uint8_t type;
+    ChirpProc recvProc;
+    void *args[CRP_MAX_ARGS+1];
+    int res;
+
+    while(1)
+    {
+        if ((res=recvChirp(&type, &recvProc, args, true))<0)
+            return res;
+        handleChirp(type, recvProc, args);
+
+        if (type&CRP_RESPONSE)
+            break;
+    }
+    return 0;
+}
+
+int ChirpCli::handleChirp(uint8_t type, ChirpProc proc, void *args[])
+{
+    if (type==CRP_RESPONSE)
+        return m_streamer->handleResponse(args);
+
+    return Chirp::handleChirp(type, proc, args);
+}
@@ -0,0 +1,30 @@
+#ifndef CHIRPCLI_H
+#define CHIRPCLI_H
+
+#include "chirp.hpp"
+#include "usblink.h"
+
+class Streamer;
+
+// Chirp over USB without the interpreter/console plumbing of ChirpMon.
+// Responses are handed to the streamer.
+class ChirpCli : public Chirp
+{
+public:
+    ChirpCli(Streamer *streamer);
+    ~ChirpCli();
+
+    int open();
+    virtual int init();
+
+    int serviceChirp();
+
+protected:
+    virtual int handleChirp(uint8_t type, ChirpProc proc, void *args[]); // null pointer terminates
+
+private:
+    USBLink m_link;
+    Streamer *m_streamer;
+};
+
+#endif // CHIRPCLI_H
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFileInfo>
+#ifdef __WIN32__
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include "streamer.h"
+
+#define DEFAULT_PROGRAM "cam_getFrame 0x21 0 0 320 200"
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: pixymon-cli [options] [call[; call...]]\n"
+            "Runs the chirp calls in a loop and streams the blobs found in each frame.\n"
+            "The default program is \"" DEFAULT_PROGRAM "\".\n"
+            "  -l <file>   load lookup table (64K binary)\n"
+            "  -r <file>   replay a log instead of connecting to the camera\n"
+            "  -w <file>   log frames, q-vals and blobs (see pixymon/datalog.h), with -r the\n"
+            "              replayed frames or q-vals and the blobs found in them, so a log\n"
+            "              can be redone with another lookup table, <file> can't be the log\n"
+            "              being replayed\n"
+            "  -s <name>   also stream to local socket <name>\n"
+            "  -b          binary output, CCB2 blob records (default is text)\n"
+            "  -n <n>      stop after n frames\n");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QString lut, replay, record, socket, program;
+    uint32_t frames = 0;
+    bool binary = false;
+    int i;
+
+    for (i=1; i<args.size(); i++)
+    {
+        if (args[i]=="-b")
+            binary = true;
+        else if (i+1<args.size() && args[i]=="-l")
+            lut = args[++i];
+        else if (i+1<args.size() && args[i]=="-r")
+            replay = args[++i];
+        else if (i+1<args.size() && args[i]=="-w")
+            record = args[++i];
+        else if (i+1<args.size() && args[i]=="-s")
+            socket = args[++i];
+        else if (i+1<args.size() && args[i]=="-n")
+            frames = args[++i].toUInt();
+        else if (args[i].startsWith("-"))
+        {
+            usage();
+            return 1;
+        }
+        else
+            program += args[i] + " ";
+    }
+    if (program.isEmpty())
+        program = DEFAULT_PROGRAM;
+    if (!replay.isEmpty() && !record.isEmpty() && QFileInfo(replay)==QFileInfo(record))
+    {
+        fprintf(stderr, "error: can't record over the log being replayed\n");
+        return 1;
+    }
+
+#ifdef __WIN32__
+    if (binary)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    Streamer streamer;
+    streamer.setBinary(binary);
+
+    if (!lut.isEmpty() && streamer.loadLut(lut)<0)
+    {
+        fprintf(stderr, "error: can't load lookup table %s\n", lut.toLocal8Bit().constData());
+        return 1;
+    }
+    if (!socket.isEmpty() && streamer.openSocket(socket)<0)
+    {
+        fprintf(stderr, "error: can't listen on %s\n", socket.toLocal8Bit().constData());
+        return 1;
+    }
+
+    if (!replay.isEmpty())
+    {
+        if (streamer.openReplay(replay)<0)
+        {
+            fprintf(stderr, "error: can't open %s\n", replay.toLocal8Bit().constData());
+            return 1;
+        }
+        if (!record.isEmpty() && streamer.openRecord(record)<0)
+        {
+            fprintf(stderr, "error: can't create %s\n", record.toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    else
+    {
+        if (streamer.openCamera()<0)
+        {
+            fprintf(stderr, "error: cannot connect to camera, or no camera found.\n");
+            return 1;
+        }
+        if (!record.isEmpty() && streamer.openRecord(record)<0)
+        {
+            fprintf(stderr, "error: can't create %s\n", record.toLocal8Bit().constData());
+            return 1;
+        }
+        QStringList calls = program.split(';', QString::SkipEmptyParts);
+        for (i=0; i<calls.size(); i++)
+        {
+            if (streamer.addCall(calls[i])<0)
+            {
+                fprintf(stderr, "error: can't parse call \"%s\"\n", calls[i].trimmed().toLocal8Bit().constData());
+                return 1;
+            }
+        }
+    }
+
+    if (streamer.run(frames)<0)
+    {
+        fprintf(stderr, "error: stream stopped\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Headless PixyMon: runs Chirp programs and Blobs::process
+# without any rendering and streams blob records.
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+TARGET = pixymon-cli
+TEMPLATE = app
+CONFIG   += console
+CONFIG   -= app_bundle
+
+SOURCES += main.cpp \
+    chirpcli.cpp \
+    streamer.cpp \
+    ../pixymon/usblink.cpp \
+    ../pixymon/blob.cpp \
+    ../pixymon/blobs.cpp \
+    ../../device/video/blobrec.c \
+    ../pixymon/datalog.cpp \
+    ../libpixy/chirp.cpp
+
+HEADERS  += chirpcli.h \
+    streamer.h \
+    ../pixymon/link.h \
+    ../pixymon/usblink.h \
+    ../pixymon/blob.h \
+    ../pixymon/blobs.h \
+    ../pixymon/qval.h \
+    ../../device/video/blobrec.h \
+    ../pixymon/datalog.h \
+    ../libpixy/chirp.hpp
+
+INCLUDEPATH += ../pixymon ../libpixy
+
+# as in pixymon.pro
+DEFINES += BR_MAX_BLOBS=256
+
+win32: LIBS += ../pixymon/libusb.a
+unix: LIBS += -lusb
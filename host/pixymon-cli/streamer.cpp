@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <string.h>
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QRegExp>
+#include "streamer.h"
+
+Streamer::Streamer()
+{
+    m_chirp = NULL;
+    m_server = NULL;
+    m_binary = false;
+    m_frame = 0;
+    m_replaying = false;
+    m_replayRaw = false;
+    br_encoderInit(&m_records, ST_KEY_INTERVAL);
+    br_encoderInit(&m_logRecords, 1);
+    br_decoderInit(&m_cameraRecords);
+}
+
+Streamer::~Streamer()
+{
+    int i;
+
+    for (i=0; i<m_sockets.size(); i++)
+        delete m_sockets[i];
+    delete m_server;
+    delete m_chirp;
+}
+
+int Streamer::openCamera()
+{
+    m_chirp = new ChirpCli(this);
+    if (m_chirp->open()<0)
+    {
+        delete m_chirp;
+        m_chirp = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int Streamer::openReplay(const QString &filename)
+{
+    if (m_replay.open(filename)<0)
+        return -1;
+    m_replaying = true;
+    return 0;
+}
+
+int Streamer::openRecord(const QString &filename)
+{
+    return m_record.open(filename);
+}
+
+int Streamer::openSocket(const QString &name)
+{
+    m_server = new QLocalServer;
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name))
+        return -1;
+    return 0;
+}
+
+int Streamer::loadLut(const QString &filename)
+{
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    if (file.read((char *)m_blobs.getLut(), LUT_SIZE)!=LUT_SIZE)
+        return -2;
+    return 0;
+}
+
+static int parseInt(const QString &arg, bool *ok)
+{
+    return arg.toInt(ok, arg.left(2)=="0x" ? 16 : 10);
+}
+
+// parse a call such as "cam_getFrame 0x21 0 0 320 200" the same way the interpreter does
+int Streamer::addCall(const QString &command)
+{
+    StreamCall call;
+    ProcInfo info;
+    QStringList argv = command.split(QRegExp("[\\s(),\\t]"), QString::SkipEmptyParts);
+    uint8_t *types;
+    uint32_t hint;
+    int i, j, k;
+    bool ok;
+
+    if (m_chirp==NULL || argv.size()<1)
+        return -1;
+    if ((call.proc=m_chirp->getProc(argv[0].toLocal8Bit()))<0 || m_chirp->getProcInfo(call.proc, &info)<0)
+        return -1;
+
+    memset(call.args, 0, sizeof(call.args));
+    for (i=1, j=0, types=info.argTypes; *types; types++)
+    {
+        // region hints are 4 uint16 args, like the interpreter treats them
+        if (*types==CRP_TYPE_HINT)
+        {
+            if (strlen((char *)types)<5)
+                return -1;
+            memcpy(&hint, types+1, 4);
+            types += 4;
+            if (hint!=FOURCC('R','E','G','1'))
+                continue;
+            if (j+8>ST_MAX_ARGS || i+4>argv.size())
+                return -1;
+            for (k=0; k<4; k++, i++)
+            {
+                call.args[j++] = CRP_UINT16;
+                call.args[j++] = parseInt(argv[i], &ok);
+                if (!ok)
+                    return -1;
+            }
+        }
+        else if (*types==CRP_INT8 || *types==CRP_INT16 || *types==CRP_INT32)
+        {
+            if (j+2>ST_MAX_ARGS || i>=argv.size())
+                return -1;
+            call.args[j++] = *types;
+            call.args[j++] = parseInt(argv[i++], &ok);
+            if (!ok)
+                return -1;
+        }
+        else // non-integer types aren't supported
+            return -1;
+    }
+
+    m_program.push_back(call);
+    return 0;
+}
+
+int Streamer::run(uint32_t frames)
+{
+    if (m_replaying)
+        return runReplay(frames);
+    if (m_chirp)
+        return runCamera(frames);
+    return -1;
+}
+
+int Streamer::runCamera(uint32_t frames)
+{
+    unsigned int i;
+    int res;
+
+    if (m_program.size()==0)
+        return -1;
+
+    while(frames==0 || m_frame<frames)
+    {
+        for (i=0; i<m_program.size(); i++)
+        {
+            const StreamCall &call = m_program[i];
+            m_chirp->callAsync(call.proc, call.args[0], call.args[1], call.args[2], call.args[3], call.args[4], call.args[5], call.args[6],
+                               call.args[7], call.args[8], call.args[9], call.args[10], call.args[11], call.args[12], call.args[13], call.args[14], call.args[15],
+                               call.args[16], call.args[17], call.args[18], call.args[19], END_OUT_ARGS);
+            if ((res=m_chirp->serviceChirp())<0)
+                return res;
+        }
+        serviceSockets();
+    }
+    return 0;
+}
+
+// replay the raw frames or q-vals in a log, ignoring the blobs that were logged with them,
+// or the blob records if that's all the log has.  If we're recording, the raw frames and
+// q-vals go into the new log with the blobs we find in them.
+int Streamer::runReplay(uint32_t frames)
+{
+    const DataLogChunk *chunk;
+    const uint8_t *data;
+
+    while((frames==0 || m_frame<frames) && m_replay.next(&chunk, &data)==0)
+    {
+        if (chunk->type==DL_TYPE_BA81)
+        {
+            m_replayRaw = true;
+            if (m_record.isOpen())
+                m_record.write(chunk->type, m_frame, chunk->width, chunk->height, data, chunk->len);
+            handleFrame(chunk->width, chunk->height, chunk->len, (uint8_t *)data);
+        }
+        else if (chunk->type==DL_TYPE_CCQ1 || chunk->type==DL_TYPE_CCQ2)
+        {
+            m_replayRaw = true;
+            if (m_record.isOpen())
+                m_record.write(chunk->type, m_frame, chunk->width, chunk->height, data, chunk->len);
+            handleQVals(chunk->type, chunk->width, chunk->height, chunk->len/sizeof(uint32_t), (uint32_t *)data);
+        }
+        // the records of a frame are logged after its raw frame or q-vals
+        else if (chunk->type==DL_TYPE_CCB2 && !m_replayRaw)
+            handleRecords(chunk->len/sizeof(uint16_t), (uint16_t *)data);
+        else
+            continue;
+        serviceSockets();
+    }
+    return 0;
+}
+
+int Streamer::handleResponse(void *args[])
+{
+    int i;
+    uint32_t type;
+
+    for(i=1; args[i]; i++)
+    {
+        if (m_chirp->getType(args[i])!=CRP_TYPE_HINT)
+            continue;
+        type = *(uint32_t *)args[i];
+        if (type==FOURCC('B','A','8','1'))
+        {
+            if (m_record.isOpen())
+                m_record.write(DL_TYPE_BA81, m_frame, *(uint16_t *)args[i+1], *(uint16_t *)args[i+2], args[i+4], *(uint32_t *)args[i+3]);
+            handleFrame(*(uint16_t *)args[i+1], *(uint16_t *)args[i+2], *(uint32_t *)args[i+3], (uint8_t *)args[i+4]);
+        }
+        else if (type==QVAL_CCQ1 || type==QVAL_CCQ2)
+        {
+            if (m_record.isOpen())
+                m_record.write(type, m_frame, *(uint16_t *)args[i+1], *(uint16_t *)args[i+2], args[i+4], *(uint32_t *)args[i+3]*sizeof(uint32_t));
+            handleQVals(type, *(uint16_t *)args[i+1], *(uint16_t *)args[i+2], *(uint32_t *)args[i+3], (uint32_t *)args[i+4]);
+        }
+        else if (type==FOURCC('C','C','B','2'))
+            handleRecords(*(uint32_t *)args[i+1], (uint16_t *)args[i+2]);
+    }
+    return 0;
+}
+
+void Streamer::handleFrame(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame)
+{
+    uint16_t numBlobs;
+    BrBlob *blobs;
+
+    m_blobs.process(width, height, frameLen, frame, &numBlobs, &blobs);
+    output(width, height, m_blobs.recordFlags(), numBlobs, blobs);
+}
+
+void Streamer::handleQVals(uint32_t format, uint16_t width, uint16_t height, uint32_t numQVals, uint32_t *qVals)
+{
+    uint16_t numBlobs;
+    BrBlob *blobs;
+
+    // width and height are the q vals', half the frame's
+    m_blobs.process(numQVals, qVals, &numBlobs, &blobs, format);
+    output(width*2, height*2, m_blobs.recordFlags(), numBlobs, blobs);
+}
+
+// blob records the camera (cc_getRLSCC) or a log made them, frames that come before a key
+// frame can't be decoded and are skipped
+void Streamer::handleRecords(uint32_t len, uint16_t *words)
+{
+    if (br_decode(&m_cameraRecords, words, len)<0)
+        return;
+    output(m_cameraRecords.width, m_cameraRecords.height, m_cameraRecords.flags, m_cameraRecords.numBlobs, m_cameraRecords.blobs);
+}
+
+void Streamer::output(uint16_t width, uint16_t height, uint16_t flags, uint16_t numBlobs, const BrBlob *blobs)
+{
+    uint16_t i, len;
+    BlobFrameHeader header;
+    QString text;
+
+    if (m_record.isOpen())
+    {
+        len = br_encode(&m_logRecords, blobs, numBlobs, width, height, flags, m_words);
+        m_record.write(DL_TYPE_CCB2, m_frame, width, height, m_words, len*sizeof(uint16_t));
+    }
+
+    if (m_binary)
+    {
+        len = br_encode(&m_records, blobs, numBlobs, width, height, flags, m_words);
+        header.sync = ST_FRAME_SYNC;
+        header.frame = m_frame;
+        header.len = len;
+        header.reserved = 0;
+        write((const char *)&header, sizeof(header));
+        write((const char *)m_words, len*sizeof(uint16_t));
+    }
+    else
+    {
+        text.sprintf("frame %u %u\n", m_frame, numBlobs);
+        for (i=0; i<numBlobs; i++)
+            text += QString().sprintf("%u %u %u %u %u %u %u %d %u\n", blobs[i].model, blobs[i].x, blobs[i].y, blobs[i].left, blobs[i].right,
+                                      blobs[i].top, blobs[i].bottom, blobs[i].angle, blobs[i].area);
+        QByteArray bytes = text.toAscii();
+        write(bytes.constData(), bytes.size());
+    }
+    fflush(stdout);
+    m_frame++;
+}
+
+void Streamer::write(const char *data, int len)
+{
+    int i;
+
+    fwrite(data, 1, len, stdout);
+    for (i=0; i<m_sockets.size(); i++)
+        m_sockets[i]->write(data, len);
+}
+
+void Streamer::serviceSockets()
+{
+    int i;
+
+    if (m_server==NULL)
+        return;
+
+    // we don't run an event loop, so process socket events once per frame
+    QCoreApplication::processEvents();
+    while (m_server->hasPendingConnections())
+    {
+        m_sockets.append(m_server->nextPendingConnection());
+        // so it can decode the next frame
+        br_key(&m_records);
+    }
+    for (i=0; i<m_sockets.size(); i++)
+    {
+        if (m_sockets[i]->state()!=QLocalSocket::ConnectedState)
+        {
+            m_sockets[i]->deleteLater();
+            m_sockets.removeAt(i--);
+        }
+        else
+            m_sockets[i]->flush();
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef STREAMER_H
+#define STREAMER_H
+
+#include <QString>
+#include <QFile>
+#include <QList>
+#include <vector>
+#include "blobs.h"
+#include "datalog.h"
+#include "chirpcli.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// Binary output is a BlobFrameHeader for each frame followed by len words of CCB2 blob
+// records (blobrec.h), little endian, no padding.  Records are delta coded, with a key frame
+// every ST_KEY_INTERVAL frames and when a socket connects.  Text output is one line per
+// frame: "frame <n> <numBlobs>", followed by one line per blob:
+// "<model> <x> <y> <left> <right> <top> <bottom> <angle> <area>"
+#define ST_FRAME_SYNC       0xb10bb10b
+#define ST_MAX_ARGS         20
+#define ST_KEY_INTERVAL     30
+
+#pragma pack(push, 1)
+struct BlobFrameHeader
+{
+    uint32_t sync;
+    uint32_t frame;
+    uint16_t len; // words
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+struct StreamCall
+{
+    ChirpProc proc;
+    int args[ST_MAX_ARGS];
+};
+
+class Streamer
+{
+public:
+    Streamer();
+    ~Streamer();
+
+    int openCamera();
+    int openReplay(const QString &filename);
+    int openRecord(const QString &filename);
+    int openSocket(const QString &name);
+    int loadLut(const QString &filename);
+    void setBinary(bool binary)
+    {
+        m_binary = binary;
+    }
+    int addCall(const QString &command);
+    int run(uint32_t frames);
+
+    int handleResponse(void *args[]);
+
+private:
+    int runCamera(uint32_t frames);
+    int runReplay(uint32_t frames);
+    void handleFrame(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame);
+    void handleQVals(uint32_t format, uint16_t width, uint16_t height, uint32_t numQVals, uint32_t *qVals);
+    void handleRecords(uint32_t len, uint16_t *words);
+    void output(uint16_t width, uint16_t height, uint16_t flags, uint16_t numBlobs, const BrBlob *blobs);
+    void write(const char *data, int len);
+    void serviceSockets();
+
+    ChirpCli *m_chirp;
+    Blobs m_blobs;
+    std::vector<StreamCall> m_program;
+    // records we stream, and the ones we log, all key frames so a log can be read from
+    // anywhere, and the ones cc_getRLSCC returns
+    BrEncoder m_records;
+    BrEncoder m_logRecords;
+    BrDecoder m_cameraRecords;
+    uint16_t m_words[BR_MAX_WORDS];
+    DataLogReader m_replay;
+    DataLog m_record;
+    bool m_replaying;
+    bool m_replayRaw;
+    QLocalServer *m_server;
+    QList<QLocalSocket *> m_sockets;
+    bool m_binary;
+    uint32_t m_frame;
+};
+
+#endif // STREAMER_H
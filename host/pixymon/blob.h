@@ -59,17 +59,17 @@ struct SMomentStats {
   float minorDiameter;
 };
 
-// Image size is 352x278
-// Full-screen blob area is 97856
-// Full-screen centroid is 176,139
-// sumX, sumY is then 17222656, 13601984; well within 32 bits
+// Image size is up to 2047x2047 (CCQ2 q vals, see qval.h)
+// Full-screen blob area is 4190209
+// Full-screen centroid is 1023,1023
+// sumX, sumY is then about 4.3e9, over 32 bits
 struct SMoments {
 // Skip major/minor axis computation when this is false
   static bool computeAxes;
   
   int area; // number of pixels
-  int sumX; // sum of pixel x coords
-  int sumY; // sum of pixel y coords
+  long long sumX; // sum of pixel x coords
+  long long sumY; // sum of pixel y coords
   // XX, XY, YY used for major/minor axis calculation
   long long sumXX; // sum of x^2 for each pixel
   long long sumYY; // sum of y^2 for each pixel
@@ -102,12 +102,13 @@ struct SMoments {
 };
 
 struct SSegment {
-  unsigned char  model    : 3 ; // which color channel
-  unsigned short row      : 9 ;
-  unsigned short startCol : 10; // inclusive
-  unsigned short endCol   : 10; // inclusive
+  // 11-bit q val coordinates (CCQ2), endCol is begin + length so it needs 12
+  unsigned int   model    : 3 ; // which color channel
+  unsigned int   row      : 12;
+  unsigned int   startCol : 12; // inclusive
+  unsigned int   endCol   : 12; // inclusive
 
-  const static short invalid_row= 0x1ff;
+  const static short invalid_row= 0xfff;
 
   // Sum 0^2 + 1^2 + 2^2 + ... + n^2 is (2n^3 + 3n^2 + n) / 6
   // Sum (a+1)^2 + (a+2)^2 ... b^2 is (2(b^3-a^3) + 3(b^2-a^2) + (b-a)) / 6
@@ -127,8 +128,8 @@ struct SSegment {
     moments.sumY = (e-s) * y;
 
     if (SMoments::computeAxes) {
-      int e3= e2*e;
-      int s3= s2*s;
+      long long e3= (long long)e2*e;
+      long long s3= (long long)s2*s;
       moments.sumXY= moments.sumX*y;
       moments.sumXX= (2*(e3-s3) + 3*(e2-s2) + (e-s)) / 6;
       moments.sumYY= moments.sumY*y;
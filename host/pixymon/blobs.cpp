@@ -1,5 +1,6 @@
 #include <QDebug>
 #include <math.h>
+#include <string.h>
 #include "blobs.h"
 
 QString code2string(uint16_t code)
@@ -36,6 +37,8 @@ Blobs::Blobs()
     //m_qmem = new SSegment[QMEM_SIZE];
     m_qmem = new uint32_t[QMEM_SIZE];
     m_lut = new uint8_t[LUT_SIZE];
+    m_qindex = 0;
+    m_qformat = QVAL_CCQ1;
 
     for (i=0; i<LUT_SIZE; i++)
         m_lut[i] = 0;
@@ -47,33 +50,85 @@ Blobs::~Blobs()
     delete [] m_qmem;
 }
 
-void Blobs::process(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame, uint16_t *numBlobs, uint16_t **blobs, uint32_t *numQVals, uint32_t **qVals)
+void Blobs::process(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame, uint16_t *numBlobs, BrBlob **blobs, uint32_t *numQVals, uint32_t **qVals)
 {
     rls(width, height, frameLen, frame);
-    blobify();
-    clean();
-    while(clean2());
-    *blobs = m_boxes;
     if (numQVals)
         *numQVals = m_qindex;
     if (qVals)
         *qVals = m_qmem;
 
+    assemble(numBlobs, blobs);
+}
+
+// assemble blobs from q-vals that were run-length segmented elsewhere (e.g. by the camera)
+void Blobs::process(uint32_t numQVals, const uint32_t *qVals, uint16_t *numBlobs, BrBlob **blobs, uint32_t format)
+{
+    if (numQVals>QMEM_SIZE)
+        numQVals = QMEM_SIZE;
+    memcpy(m_qmem, qVals, numQVals*sizeof(uint32_t));
+    m_qindex = numQVals;
+    m_qformat = format;
+
+    assemble(numBlobs, blobs);
+}
+
+void Blobs::assemble(uint16_t *numBlobs, BrBlob **blobs)
+{
+    uint16_t i;
+    uint16_t *box;
+
+    blobify();
+    clean();
+    while(clean2());
+
     processCoded();
-    *numBlobs = m_numBoxes + m_numCodedBoxes;
+    m_numRecords = 0;
 #if 1 // uncomment if we only want to show structured blobs
-    if (m_numCodedBoxes>0)
+    if (m_numCodedBoxes==0)
+#endif
     {
-        int i;
+        // regular blobs, 4 words each, (coord<<3)|model
         for (i=0; i<m_numBoxes; i++)
         {
-            m_boxes[i*4+0]=0;
-            m_boxes[i*4+1]=0;
-            m_boxes[i*4+2]=0;
-            m_boxes[i*4+3]=0;
+            box = &m_boxes[i*4];
+            if (box[0]==0)
+                continue;
+            record(box[0]&0x07, box[0]>>3, box[1]>>3, box[2]>>3, box[3]>>3, 0, m_moments[i]);
         }
     }
+    // coded blobs, code<<3, left, right, top, bottom[, angle]
+    for (i=0; i<m_numCodedBoxes; i++)
+    {
+#ifdef RENDER_ANGLE
+        box = &m_boxes[m_numBoxes*4 + i*6];
+        record(box[0]>>3, box[1], box[2], box[3], box[4], box[5], m_moments[m_numBoxes+i]);
+#else
+        box = &m_boxes[m_numBoxes*4 + i*5];
+        record(box[0]>>3, box[1], box[2], box[3], box[4], 0, m_moments[m_numBoxes+i]);
 #endif
+    }
+    *numBlobs = m_numRecords;
+    *blobs = m_records;
+}
+
+// boxes are in frame pixels, moments are at q val resolution, half the frame's
+void Blobs::record(uint16_t model, uint16_t left, uint16_t right, uint16_t top, uint16_t bottom, int16_t angle, const SMoments &moments)
+{
+    BrBlob *record;
+
+    if (m_numRecords>=MAX_BLOBS || moments.area==0)
+        return;
+    record = &m_records[m_numRecords++];
+    record->model = model;
+    record->x = (2*moments.sumX + moments.area/2)/moments.area;
+    record->y = (2*moments.sumY + moments.area/2)/moments.area;
+    record->left = left;
+    record->right = right;
+    record->top = top;
+    record->bottom = bottom;
+    record->angle = angle;
+    record->area = moments.area*4;
 }
 
 void Blobs::rls(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame)
@@ -83,6 +138,8 @@ void Blobs::rls(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *fra
     bool stateIn, stateOut;
     uint32_t prevLutVal=0, prevModel=0;
     m_qindex = 0;
+    // q val columns are half the frame's
+    m_qformat = width/2>QVAL_MAX_COLS(QVAL_CCQ1) ? QVAL_CCQ2 : QVAL_CCQ1;
 
     for (y=1; y<height; y+=2)
     {
@@ -151,9 +208,7 @@ void Blobs::rls(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *fra
             if ((model && prevModel && model!=prevModel) ||
                     (model==0 && prevModel))
             {
-                model = prevModel;
-                model |= startCol<<3;
-                model |= (x/2-startCol)<<12;
+                model = QVAL_MAKE(m_qformat, prevModel, startCol, x/2-startCol);
                 m_qmem[m_qindex++] = model;
                 model = 0;
                 startCol = 0;
@@ -163,9 +218,7 @@ void Blobs::rls(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *fra
         }
         if (startCol)
         {
-            model = prevModel;
-            model |= startCol<<3;
-            model |= (x/2-startCol)<<12;
+            model = QVAL_MAKE(m_qformat, prevModel, startCol, x/2-startCol);
             m_qmem[m_qindex++] = model;
             model = 0;
         }
@@ -180,9 +233,7 @@ void Blobs::blobify()
     uint32_t qval, i, j;
 
 
-    // q val:
-    // | 4 bits    | 7 bits      | 9 bits | 9 bits    | 3 bits |
-    // | shift val | shifted sum | length | begin col | model  |
+    // q vals are CCQ1 or CCQ2, see qval.h
 
     // start frame
     for (i=0; i<NUM_MODELS; i++)
@@ -196,14 +247,12 @@ void Blobs::blobify()
             row++;
             continue;
         }
-        s.model = qval&0x07;
+        s.model = QVAL_MODEL(qval);
         if (s.model>0)
         {
             s.row = row;
-            qval >>= 3;
-            s.startCol = qval&0x1ff;
-            qval >>= 9;
-            s.endCol = (qval&0x1ff) + s.startCol;
+            s.startCol = QVAL_BEGIN(m_qformat, qval);
+            s.endCol = QVAL_LEN(m_qformat, qval) + s.startCol;
             m_assembler[s.model-1].Add(s);
         }
     }
@@ -228,6 +277,7 @@ void Blobs::blobify()
                 m_boxes[m_numBoxes*4 + 1] = (right<<4) | (i+1);
                 m_boxes[m_numBoxes*4 + 2] = (top<<4) | (i+1);
                 m_boxes[m_numBoxes*4 + 3] = (bottom<<4) | (i+1);
+                m_moments[m_numBoxes] = blob->moments;
                 m_numBoxes++;
 
 #if 0
@@ -310,6 +360,7 @@ void Blobs::clean()
             if (left0<=left && right0>=right &&
                     top0<=top && bottom0>=bottom)
             {
+                m_moments[i].Add(m_moments[j]);
                 m_boxes[j*4+0] = 0; // invalidate
                 m_boxes[j*4+1] = 0; // invalidate
                 m_boxes[j*4+2] = 0; // invalidate
@@ -391,6 +442,8 @@ int Blobs::clean2()
                 m_boxes[j*4+3] = 0; // invalidate
                 n++;
             }
+            if (m_boxes[j*4+0]==0) // merged into i
+                m_moments[i].Add(m_moments[j]);
         }
     }
 
@@ -496,6 +549,8 @@ void Blobs::addCoded(int a, int b)
     m_boxes[m_numBoxes*4+m_numCodedBoxes*5+4] = bottom;
 #endif
 
+    m_moments[m_numBoxes+m_numCodedBoxes] = m_moments[a];
+    m_moments[m_numBoxes+m_numCodedBoxes].Add(m_moments[b]);
     m_numCodedBoxes++;
 
     // invalidate a and b (only if you are
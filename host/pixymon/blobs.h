@@ -4,6 +4,8 @@
 #include <vector>
 #include <utility>
 #include "blob.h"
+#include "qval.h"
+#include "../../device/video/blobrec.h"
 
 #define NUM_MODELS      7
 #define MAX_BLOBS       256
@@ -27,7 +29,24 @@ public:
     Blobs();
     ~Blobs();
 
-    void process(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame,  uint16_t *numBlobs, uint16_t **blobs, uint32_t *numQVals=NULL, uint32_t **qVals=NULL);
+    // blobs are regular blobs, then coded blobs (model is the code), as CCB2 records (see
+    // blobrec.h) in pixels of the frame the q vals were made from
+    void process(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame,  uint16_t *numBlobs, BrBlob **blobs, uint32_t *numQVals=NULL, uint32_t **qVals=NULL);
+    void process(uint32_t numQVals, const uint32_t *qVals, uint16_t *numBlobs, BrBlob **blobs, uint32_t format=QVAL_CCQ1);
+    // format of the last q vals processed, QVAL_CCQ1 or QVAL_CCQ2 (see qval.h)
+    uint32_t qvalFormat()
+    {
+        return m_qformat;
+    }
+    // CCB2 flags of the records
+    uint16_t recordFlags()
+    {
+#ifdef RENDER_ANGLE
+        return BR_FLAG_ANGLE;
+#else
+        return 0;
+#endif
+    }
     uint8_t *getLut()
     {
         return m_lut;
@@ -39,6 +58,8 @@ public:
     friend class Renderer;
 private:
     void rls(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame);
+    void assemble(uint16_t *numBlobs, BrBlob **blobs);
+    void record(uint16_t model, uint16_t left, uint16_t right, uint16_t top, uint16_t bottom, int16_t angle, const SMoments &moments);
     void blobify();
     void compress();
     void clean();
@@ -54,9 +75,14 @@ private:
     uint32_t *m_qmem;
     uint8_t *m_lut;
     uint32_t m_qindex;
+    uint32_t m_qformat;
     uint16_t m_boxes[4*MAX_BLOBS];
     uint16_t m_numBoxes;
     uint16_t m_numCodedBoxes;
+    // moments of each box in m_boxes, regular boxes and then coded boxes
+    SMoments m_moments[MAX_BLOBS];
+    BrBlob m_records[MAX_BLOBS];
+    uint16_t m_numRecords;
     std::vector<LabelPair> m_labels;
 };
 
@@ -1,12 +1,18 @@
 #include <QDebug>
 #include <QMutexLocker>
+#include <QElapsedTimer>
 #include "chirpmon.h"
 #include "interpreter.h"
 
+// prof_getTime calls made to find the offset between the clocks
+#define CM_SYNC_CALLS   16
+
 ChirpMon::ChirpMon(Interpreter *interpreter)
 {
     m_hinterested = true;
     m_interpreter = interpreter;
+    m_clockSynced = false;
+    m_clockOffset = 0;
 }
 
 ChirpMon::~ChirpMon()
@@ -49,7 +55,65 @@ int ChirpMon::open()
 
 int ChirpMon::init()
 {
-    return remoteInit();
+    int res;
+
+    if ((res=remoteInit())>=0)
+        syncClock();
+
+    return res;
+}
+
+qint64 ChirpMon::time()
+{
+    static QElapsedTimer timer;
+
+    if (!timer.isValid())
+        timer.start();
+    return timer.nsecsElapsed()/1000;
+}
+
+// The device's time is somewhere between when we made the call and when we got the
+// result, so the call with the quickest round trip pins it down best--- take it as
+// halfway.  The crystals drift apart by up to 50 us a second, so after a few minutes
+// it's worth doing again ("latency sync").
+void ChirpMon::syncClock()
+{
+    int i;
+    int32_t responseInt;
+    uint32_t deviceTime;
+    qint64 t0, t1, best = -1;
+    ChirpProc getTime = getProc("prof_getTime");
+
+    m_clockSynced = false;
+    if (getTime<0)
+        return;
+
+    for (i=0; i<CM_SYNC_CALLS; i++)
+    {
+        t0 = time();
+        if (callSync(getTime, END_OUT_ARGS, &responseInt, &deviceTime, END_IN_ARGS)<0)
+            return;
+        t1 = time();
+        if (best<0 || t1-t0<best)
+        {
+            best = t1-t0;
+            m_clockOffset = (t0+t1)/2 - deviceTime;
+        }
+    }
+    m_clockSynced = true;
+}
+
+// device time is 32 bits (it wraps every 71 minutes), so it's taken as the time closest
+// to the device's now
+bool ChirpMon::hostTime(uint32_t deviceTime, qint64 *time)
+{
+    qint64 now = ChirpMon::time();
+
+    if (!m_clockSynced)
+        return false;
+
+    *time = now + (int32_t)(deviceTime - (uint32_t)(now - m_clockOffset));
+    return true;
 }
 
 int ChirpMon::handleChirp(uint8_t type, ChirpProc proc, void *args[])
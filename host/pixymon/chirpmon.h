@@ -34,6 +34,12 @@ public:
 
     int serviceChirp();
 
+    // our clock, us
+    static qint64 time();
+    // device time (hal_us, which frames are stamped with) to our clock, false if the
+    // firmware can't tell us its time
+    bool hostTime(uint32_t deviceTime, qint64 *time);
+
     friend class Interpreter;
 
 protected:
@@ -42,9 +48,12 @@ protected:
 
 private:
     int execute(const ChirpCallData &data);
+    void syncClock();
 
     USBLink m_link;
     Interpreter *m_interpreter;
+    bool m_clockSynced;
+    qint64 m_clockOffset; // our time - device time
 };
 
 #endif // CHIRPTHREAD_H
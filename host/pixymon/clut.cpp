@@ -1,10 +1,8 @@
-#include <QDebug>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
 #include "clut.h"
-#include "blobs.h"
-
-// DEBUG
-#include <QFile>
 
 double e = 0.95;
 double d = 1.5;
@@ -12,90 +10,105 @@ double d2 = 2.0;
 double d3 = 2.0;
 double minsat = 0.18;
 
-static double** plotcluster(uint32_t* data, int d_len);
 static void generatelut(double* L[], uint8_t* LUT);
-static void plotpix(uint32_t* pixels, int pix_len, double* pp0, double* pp1, double* pp2);
 static double tweakmean(double mean);
-static double iterateline(double* P0, double* P1, int P_len, double* LI, double d, double e);
+static double iterateline(double* P0, double* P1, int P_len, double* LI, double d, double e, double* V);
 static int boundtest(double* P0, double* P1, int P_len, double* L, double dir);
-static double mean(double* array, int dim, int len);
-static double max(double* array, int len);
-static void dot_2dim(double* array1[], double* array2[], double* ret, int len);
+static double boundfraction(double* P0, double* P1, int P_len, double slope, double offset, double dir);
 static double dot_1dim(double* array1, double* array2, int len);
-static bool checkbounds(double* L[], int L_len, double c1, double c2);
 static int32_t sign(int num);
 static double sign(double num);
 
-void CLUT::generateFromImgSample(uint32_t *data, int d_len, uint8_t* tempLut)
+CLUT::CLUT()
 {
-    double** L = plotcluster(data, d_len);
-    generatelut(L, tempLut);
+    m_p1 = NULL;
+    m_p2 = NULL;
+    m_v = NULL;
+    m_size = 0;
+}
 
-    delete(L[0]);
-    delete(L[1]);
-    delete(L);
+CLUT::~CLUT()
+{
+    delete [] m_p1;
+    delete [] m_p2;
+    delete [] m_v;
 }
 
-static double** plotcluster(uint32_t* data, int d_len)
+void CLUT::reserve(int len)
 {
-    double* ppp0 = new double[d_len/3];
-    double* ppp1 = new double[d_len/3];
-    double* ppp2 = new double[d_len/3];
+    if (len <= m_size)
+        return;
+
+    delete [] m_p1;
+    delete [] m_p2;
+    delete [] m_v;
+    m_p1 = new double[len];
+    m_p2 = new double[len];
+    m_v = new double[len];
+    m_size = len;
+}
 
-    plotpix(data, d_len, ppp0, ppp1, ppp2);
+void CLUT::generateFromImgSample(const uint32_t *data, int d_len, uint8_t* tempLut)
+{
+    double L0[4], L1[4];
+    double* L[] = {L0, L1};
 
-    double meanx = mean(ppp1, 1, d_len/3);
-    meanx = tweakmean(meanx);
-    double meany = mean(ppp2, 2, d_len/3);
-    meany = tweakmean(meany);
-    double angle = atan2(meany, meanx);
-    double slope = tan(angle);
-    double uv[] = {cos(angle), sin(angle)};
+    plotcluster(data, d_len, L);
+    generatelut(L, tempLut);
+}
 
-    double* rmat[2];
-    rmat[0] = new double[d_len];
-    rmat[1] = new double[d_len];
-    for (int i = 0; i < d_len; i++)
-    {
-        rmat[0][i] = uv[0];
-        rmat[1][i] = uv[1];
-    }
+void CLUT::plotcluster(const uint32_t* data, int d_len, double* L[])
+{
+    int n = d_len/3;
+    double sumx = 0.0, sumy = 0.0;
 
-    double* pp1[2];
-    pp1[0] = new double[d_len];
-    pp1[1] = new double[d_len];
-    for (int i = 0; i < d_len; i++)
+    reserve(n);
+
+    // project the pixels and sum them in one pass (see plotpix.m)
+    for (int i = 0; i < n; i++)
     {
-        pp1[0][i] = ppp1[i];
-        pp1[1][i] = ppp2[i];
+        double r = (double)data[3*i];
+        double g = (double)data[3*i+1];
+        double b = (double)data[3*i+2];
+
+        m_p1[i] = (r-g)/255.0;
+        m_p2[i] = (b-g)/255.0;
+        sumx += m_p1[i];
+        sumy += m_p2[i];
     }
 
-    double* D = new double[d_len];
-    dot_2dim(rmat, pp1, D, d_len);
-    free(D);
+    double meanx = sumx/(double)n;
+    meanx = tweakmean(meanx);
+    double meany = sumy/(double)n;
+    meany = tweakmean(meany);
+    double angle = atan2(meany, meanx);
+    double slope = tan(angle);
+    double uv[] = {cos(angle), sin(angle)};
 
     double anglep = angle + PI/2;
     double ps = tan(anglep);
     double lp[] = {ps, slope*meanx-ps*meanx};
 
     // Find upper and lower major lines
-    double yu = iterateline(ppp1, ppp2, d_len/3, (double []){slope, 0}, fabs(0.001/cos(angle)), e);
+    double lm[] = {slope, 0};
+    double yu = iterateline(m_p1, m_p2, n, lm, fabs(0.001/cos(angle)), e, m_v);
 
     yu = yu + fabs(d * yu);
     double lu[] = {slope, yu};
 
-    double yd = iterateline(ppp1, ppp2, d_len/3, (double []){slope, 0}, -1.0*fabs(0.001/cos(angle)), e);
+    double yd = iterateline(m_p1, m_p2, n, lm, -1.0*fabs(0.001/cos(angle)), e, m_v);
 
     yd = yd - fabs(d*yd);
     double ld[] = {slope, yd};
 
     // Find inner and outer major lines
     // If uv[1] is negative, we want to iterate up (positive), so -sign(uv[1])
-    double yl = iterateline(ppp1, ppp2, d_len/3, lp, -1.0*sign(uv[1])*fabs(0.001/cos(anglep)), e);
+    double yl = iterateline(m_p1, m_p2, n, lp, -1.0*sign(uv[1])*fabs(0.001/cos(anglep)), e, m_v);
     yl = yl + -1*sign(uv[1])*fabs(d2*(yl-lp[1]));
     double xxl = yl / (slope-ps);
     double yyl = xxl * slope;
-    double sat = dot_1dim(uv, (double []){xxl, yyl}, 2);
+    double pl[] = {xxl, yyl};
+    double sat = dot_1dim(uv, pl, 2);
     if (sat < minsat)
     {
        double minl[] = {uv[0]*minsat, uv[1]*minsat};
@@ -104,20 +117,10 @@ static double** plotcluster(uint32_t* data, int d_len)
     double ll[] = {ps, yl};
 
     // If uv[1] is negative, we want to iterate down (negative), so sign(uv[1])
-    double yr = iterateline(ppp1, ppp2, d_len/3, lp, sign(uv[1])*fabs(0.001/cos(anglep)), e);
+    double yr = iterateline(m_p1, m_p2, n, lp, sign(uv[1])*fabs(0.001/cos(anglep)), e, m_v);
     yr = yr - -1*sign(uv[1])*fabs(d3*(yr-lp[1]));
     double lr[] = {ps, yr};
 
-    free(pp1[0]);
-    free(pp1[1]);
-
-    free(ppp0);
-    free(ppp1);
-    free(ppp2);
-
-    double** L = new double*[2];
-    L[0] = new double[4];
-    L[1] = new double[4];
     if (ll[1] > lr[1])
     {
         L[0][0] = lu[0];
@@ -142,25 +145,6 @@ static double** plotcluster(uint32_t* data, int d_len)
         L[1][2] = lr[1];
         L[1][3] = ll[1];
     }
-
-    return L;
-}
-
-static void plotpix(uint32_t* pixels, int pix_len, double* pp0, double* pp1, double* pp2)
-{
-    int count = 0;
-    for (int i = 0; i < pix_len; i+=3) {
-        double r = (double)pixels[i];
-        double g = (double)pixels[i+1];
-        double b = (double)pixels[i+2];
-
-        double L = (r+g+b)/(3.0*255.0);
-        pp0[count] = L;
-        pp1[count] = (r-g)/255.0;
-        pp2[count] = (b-g)/255.0;
-
-        count++;
-    }
 }
 
 static double tweakmean(double mean)
@@ -180,25 +164,49 @@ static double tweakmean(double mean)
     return ret;
 }
 
-static double iterateline(double* P0, double* P1, int P_len, double* LI, double d, double e)
+// Moves the line LI (slope, offset) in steps of d until boundtest finds a fraction e of
+// the points on the near side.  Rather than stepping and counting every point at each
+// step, select the order statistic of the point offsets (P1 - slope*P0) that reaches
+// the fraction e, and compute the number of steps that clears it.
+static double iterateline(double* P0, double* P1, int P_len, double* LI, double d, double e, double* V)
 {
-    double ret = LI[1];
     double d_sign = 1;
     if (d < 0)
         d_sign = -1;
 
-    while (1)
-    {
-        double btest = boundtest(P0, P1, P_len, (double []) {LI[0], ret}, d_sign);
-        double temp = (btest/double(P_len));
-
-        if (temp >= e)
-        {
-            break;
-        }
-        ret = ret + d;
-    }
-    return ret;
+    if (P_len <= 0 || d == 0)
+        return LI[1];
+
+    // smallest number of points k such that k/P_len >= e
+    int k = (int)ceil(e*P_len);
+    if (k < 0)
+        k = 0;
+    while (k > 0 && (k-1)/double(P_len) >= e)
+        k--;
+    while (k <= P_len && k/double(P_len) < e)
+        k++;
+    if (k == 0 || k > P_len)
+        return LI[1];
+
+    // the k-th smallest offset going up, the k-th largest going down
+    for (int i = 0; i < P_len; i++)
+        V[i] = P1[i] - LI[0]*P0[i];
+    int kth = d_sign > 0 ? k-1 : P_len-k;
+    std::nth_element(V, V+kth, V+P_len);
+    double bound = V[kth];
+
+    // the first step that moves the line past bound
+    double steps = (bound - LI[1])/d;
+    int64_t m = steps < 0 ? 0 : (int64_t)floor(steps) + 1;
+
+    // the offsets round differently than boundtest's comparison, so settle the last
+    // step or two with boundtest itself
+    while (boundfraction(P0, P1, P_len, LI[0], LI[1] + m*d, d_sign) < e)
+        m++;
+    while (m > 0 && boundfraction(P0, P1, P_len, LI[0], LI[1] + (m-1)*d, d_sign) >= e)
+        m--;
+
+    return LI[1] + m*d;
 }
 
 static int boundtest(double* P0, double* P1, int P_len, double* L, double dir)
@@ -222,81 +230,47 @@ static int boundtest(double* P0, double* P1, int P_len, double* L, double dir)
     return n;
 }
 
+// fraction of the points on the dir side of the line slope, offset
+static double boundfraction(double* P0, double* P1, int P_len, double slope, double offset, double dir)
+{
+    double L[] = {slope, offset};
+
+    return boundtest(P0, P1, P_len, L, dir)/double(P_len);
+}
+
+// A LUT entry (c1, c2) is in the model when c2 is below lines 0 and 2 and above lines 1
+// and 3 (see checkbounds.m).  For a given c1 the four line values are fixed, so each LUT
+// row is one contiguous run of c2 values.  Find the ends of the run with a binary search
+// over the sorted c2 values, using the same comparisons, so the LUT is unchanged.
 static void generatelut(double* L[], uint8_t* LUT)
 {
     int32_t C2[256];
+    double cs[256]; // c2 values in ascending order, cs[k] is C2 value k-128
     for (int32_t i = 0; i < 128; i++) {
         C2[i] = i;
     }
     for (int32_t i = -128; i < 0; i++) {
         C2[i+256] = i;
     }
+    for (int32_t k = 0; k < 256; k++)
+        cs[k] = (double)((double)(k-128) / (double)127);
 
-    int index = 0;
     for (int32_t i = 0; i < 256; i++)
     {
-        for (int32_t j = 0; j < 256; j++)
-        {
-            //double c1 = (double)((double)i / (double)127);
-            //double c2 = (double)((double)j / (double)127);
-            double c1 = (double)((double)C2[i] / (double)127);
-            double c2 = (double)((double)C2[j] / (double)127);
-
-            // DEBUG
-            /*QFile file("pixiC.txt");
-            file.open(QIODevice::WriteOnly | QIODevice::Append);
-            QTextStream out(&file);
-
-            out << c1;
-            out << " ";
-            out << c2;
-            out << " (i=";
-            out << C2[i];
-            out << ", j=";
-            out << C2[j];
-            out << ")";
-            out << "\n";*/
-
-            if (checkbounds(L, 4, c1, c2))
-            {
-                LUT[index] = 1;
-            }
-            else
-            {
-                LUT[index] = 0;
-            }
-            index++;
-        }
-    }
-}
-
-static double mean(double* array, int dim, int len)
-{
-    double total = 0;
-    for (int i = 0; i < len; i++)
-    {
-        total += array[i];
-    }
-
-    return total/(double)len;
-}
-
-static double max(double* array, int len)
-{
-    int ret = array[0];
-    for (int i = 0; i < len; i++)
-    {
-        if (array[i] > ret)
-            ret = array[i];
-    }
-    return ret;
-}
-
-static void dot_2dim(double* array1[], double* array2[], double* ret, int len)
-{
-    for (int i = 0; i < len; i++)
-    {
-        ret[i] += array1[0][i]*array2[0][i] + array1[1][i]*array2[1][i];
+        uint8_t *row = LUT + (i<<8);
+        double c1 = (double)((double)C2[i] / (double)127);
+        double Y[4];
+        for (int k = 0; k < 4; k++)
+            Y[k] = L[0][k]*c1 + L[1][k];
+
+        // first c2 above lines 1 and 3, first c2 not below lines 0 and 2 (NaN lines
+        // compare false, which leaves the run empty, same as checkbounds)
+        int32_t begin = std::max(std::upper_bound(cs, cs+256, Y[1]) - cs, std::upper_bound(cs, cs+256, Y[3]) - cs);
+        int32_t end = std::min(std::lower_bound(cs, cs+256, Y[0]) - cs, std::lower_bound(cs, cs+256, Y[2]) - cs);
+
+        memset(row, 0, 256);
+        for (int32_t k = begin; k < end; k++)
+            row[(k-128)&0xff] = 1;
     }
 }
 
@@ -310,43 +284,6 @@ static double dot_1dim(double* array1, double* array2, int len)
     return ret;
 }
 
-static bool checkbounds(double* L[], int L_len, double c1, double c2)
-{
-    bool ret = false;
-    double *Y = new double[L_len];
-    for (int i = 0; i < L_len; i++)
-        Y[i] = L[0][i]*c1 + L[1][i];
-
-    // DEBUG
-    double y1 = Y[0];
-    double y2 = Y[1];
-    double y3 = Y[2];
-    double y4 = Y[3];
-
-    /*QFile file("pixiCheckbounds.txt");
-    file.open(QIODevice::Append | QIODevice::WriteOnly);
-    QTextStream out(&file);
-
-    out << c2;
-    out << " ";
-    out << y1;
-    out << " ";
-    out << y2;
-    out << " ";
-    out << y3;
-    out << " ";
-    out << y4;
-    out << "\n";*/
-
-    if ((Y[0] > c2) && (Y[1] < c2) && (Y[2] > c2) && (Y[3] < c2))
-    {
-        ret = true;
-    }
-
-    free(Y);
-    return ret;
-}
-
 static int32_t sign(int num)
 {
     return abs(num)/num;
@@ -4,10 +4,29 @@
 
 #define PI 3.141592653589793238462643383279502884197169399375105820974944592307816406286208998628034825342117068
 
+// Generates a model LUT from a sample of pixels.  The working arrays are kept between
+// calls and only grow, so training doesn't allocate once the largest selection has
+// been seen.
 class CLUT
 {
 public:
-    static void generateFromImgSample(uint32_t *data, int d_len, uint8_t* tempLut);
+    CLUT();
+    ~CLUT();
+
+    // data is d_len/3 r, g, b triples
+    void generateFromImgSample(const uint32_t *data, int d_len, uint8_t* tempLut);
+    // the model's 4 lines in the ((r-g)/255, (b-g)/255) plane, L[0] has their slopes and
+    // L[1] their offsets, 4 each.  (c1, c2) is in the model when c2 is below lines 0 and 2
+    // and above lines 1 and 3.
+    void plotcluster(const uint32_t* data, int d_len, double* L[]);
+
+private:
+    void reserve(int len);
+
+    double *m_p1; // (r-g)/255 of each pixel
+    double *m_p2; // (b-g)/255 of each pixel
+    double *m_v;  // scratch for iterateline
+    int m_size;
 };
 
 #endif // CLUT_H
@@ -0,0 +1,226 @@
+#include <string.h>
+#include <QDateTime>
+#include <QMutexLocker>
+#include "datalog.h"
+
+#define DL_PAD(len)     (((len)+DL_ALIGN-1)&~(DL_ALIGN-1))
+
+DataLog::DataLog()
+{
+    m_queue = NULL;
+    m_head = m_tail = m_used = 0;
+    m_dropped = 0;
+    m_offset = m_fileSize = 0;
+    m_running = false;
+}
+
+DataLog::~DataLog()
+{
+    close();
+}
+
+int DataLog::open(const QString &filename)
+{
+    DataLogHeader header;
+
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return -1;
+    m_fileSize = DL_PREALLOC;
+    if (!m_file.resize(m_fileSize))
+    {
+        m_file.close();
+        return -1;
+    }
+
+    // only logs that are open hold a queue
+    m_queue = new uint8_t[DL_QUEUE_SIZE];
+    m_head = m_tail = m_used = 0;
+    m_dropped = 0;
+    m_offset = 0;
+    m_time.start();
+    m_running = true;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = DL_MAGIC;
+    header.version = DL_VERSION;
+    header.headerLen = sizeof(DataLogHeader);
+    header.chunkHeaderLen = sizeof(DataLogChunk);
+    header.startTime = QDateTime::currentMSecsSinceEpoch();
+    enqueue(&header, sizeof(header));
+
+    start();
+    return 0;
+}
+
+void DataLog::close()
+{
+    if (!m_running)
+        return;
+
+    m_mutex.lock();
+    m_running = false;
+    m_wait.wakeAll();
+    m_mutex.unlock();
+    wait();
+
+    // remove the unused part of the preallocation
+    m_file.resize(m_offset);
+    m_file.close();
+
+    delete [] m_queue;
+    m_queue = NULL;
+}
+
+int DataLog::write(uint32_t type, uint32_t frame, uint16_t width, uint16_t height, const void *data, uint32_t len)
+{
+    DataLogChunk chunk;
+    uint8_t pad[DL_ALIGN];
+    uint32_t total = sizeof(DataLogChunk) + DL_PAD(len);
+
+    chunk.type = type;
+    chunk.len = len;
+    chunk.timestamp = m_time.nsecsElapsed()/1000;
+    chunk.frame = frame;
+    chunk.width = width;
+    chunk.height = height;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_running)
+        return -1;
+    if (total>DL_QUEUE_SIZE-m_used)
+    {
+        m_dropped++;
+        return -2;
+    }
+    enqueue(&chunk, sizeof(chunk));
+    enqueue(data, len);
+    if (DL_PAD(len)!=len)
+    {
+        memset(pad, 0, DL_ALIGN);
+        enqueue(pad, DL_PAD(len)-len);
+    }
+    m_wait.wakeAll();
+
+    return 0;
+}
+
+// copy into the queue, wrapping around the end, caller holds m_mutex
+void DataLog::enqueue(const void *data, uint32_t len)
+{
+    uint32_t n;
+
+    n = DL_QUEUE_SIZE-m_head;
+    if (n>len)
+        n = len;
+    memcpy(m_queue+m_head, data, n);
+    memcpy(m_queue, (const uint8_t *)data+n, len-n);
+    m_head = (m_head+len)%DL_QUEUE_SIZE;
+    m_used += len;
+}
+
+void DataLog::run()
+{
+    uint32_t n;
+
+    m_mutex.lock();
+    while(1)
+    {
+        while (m_used==0 && m_running)
+            m_wait.wait(&m_mutex);
+        if (m_used==0)
+            break;
+
+        // write the contiguous part of the queue without holding the lock
+        n = DL_QUEUE_SIZE-m_tail;
+        if (n>m_used)
+            n = m_used;
+        m_mutex.unlock();
+
+        if (m_offset+n>m_fileSize)
+        {
+            m_fileSize += DL_PREALLOC;
+            m_file.resize(m_fileSize);
+        }
+        m_file.seek(m_offset);
+        m_file.write((const char *)m_queue+m_tail, n);
+        m_offset += n;
+
+        m_mutex.lock();
+        m_tail = (m_tail+n)%DL_QUEUE_SIZE;
+        m_used -= n;
+    }
+    m_mutex.unlock();
+    m_file.flush();
+}
+
+
+DataLogReader::DataLogReader()
+{
+    m_map = NULL;
+    m_size = 0;
+    m_offset = 0;
+}
+
+DataLogReader::~DataLogReader()
+{
+    close();
+}
+
+int DataLogReader::open(const QString &filename)
+{
+    const DataLogHeader *header;
+
+    close();
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return -1;
+    m_size = m_file.size();
+    if (m_size<(qint64)sizeof(DataLogHeader) || (m_map=m_file.map(0, m_size))==NULL)
+    {
+        close();
+        return -1;
+    }
+    header = (const DataLogHeader *)m_map;
+    // older versions only differ in their chunk types
+    if (header->magic!=DL_MAGIC || header->version<1 || header->version>DL_VERSION || header->chunkHeaderLen!=sizeof(DataLogChunk))
+    {
+        close();
+        return -2;
+    }
+    rewind();
+    return 0;
+}
+
+void DataLogReader::close()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = NULL;
+    m_size = 0;
+    m_file.close();
+}
+
+void DataLogReader::rewind()
+{
+    if (m_map)
+        m_offset = ((const DataLogHeader *)m_map)->headerLen;
+}
+
+int DataLogReader::next(const DataLogChunk **chunk, const uint8_t **data)
+{
+    const DataLogChunk *c;
+
+    if (m_map==NULL || m_offset+(qint64)sizeof(DataLogChunk)>m_size)
+        return -1;
+    c = (const DataLogChunk *)(m_map+m_offset);
+    if (c->type==0 || m_offset+(qint64)sizeof(DataLogChunk)+c->len>m_size)
+        return -1;
+    *chunk = c;
+    *data = m_map+m_offset+sizeof(DataLogChunk);
+    m_offset += sizeof(DataLogChunk)+DL_PAD(c->len);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#ifndef DATALOG_H
+#define DATALOG_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <QElapsedTimer>
+#include <stdint.h>
+
+// Log file layout (little endian):
+//   DataLogHeader
+//   chunks: DataLogChunk, followed by len bytes of payload, padded to DL_ALIGN bytes
+//   a chunk with type 0 (or end of file) ends the log
+// Chunk types:
+//   BA81: raw bayer frame, width*height bytes
+//   CCQ1, CCQ2: q-vals, uint32 each (see qval.h), width and height are the q-val resolution
+//   CCB2: blob records, a key frame each (see blobrec.h), width and height are the frame's
+//   BLOB: model, left, right, top, bottom, angle, 6 words a blob
+// Version 1 logs have BLOB chunks for blobs, version 2 logs have CCB2 chunks in their
+// place, the layout is the same.
+// Everything is aligned, so the file can be mmap'ed and read in place.
+
+#define DL_MAGIC            0x474c5850 // "PXLG"
+#define DL_VERSION          2
+#define DL_ALIGN            8
+#define DL_TYPE_BA81        0x31384142 // "BA81"
+#define DL_TYPE_CCQ1        0x31514343 // "CCQ1"
+#define DL_TYPE_CCQ2        0x32514343 // "CCQ2"
+#define DL_TYPE_CCB2        0x32424343 // "CCB2"
+
+#define DL_PREALLOC         0x4000000  // grow file 64MB at a time
+#define DL_QUEUE_SIZE       0x1000000  // 16MB of chunks waiting for the writer thread, while open
+
+struct DataLogHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerLen;
+    uint32_t chunkHeaderLen;
+    uint32_t reserved;
+    uint64_t startTime; // ms since epoch
+};
+
+struct DataLogChunk
+{
+    uint32_t type;
+    uint32_t len; // payload length, not including padding
+    uint64_t timestamp; // us since start of log
+    uint32_t frame;
+    uint16_t width;
+    uint16_t height;
+};
+
+// Writes chunks from any thread without blocking on the disk.  Chunks are copied into a
+// queue, and a writer thread streams the queue to a file that is grown in large
+// preallocated steps.  If the queue is full, the chunk is dropped and counted.
+class DataLog : public QThread
+{
+    Q_OBJECT
+
+public:
+    DataLog();
+    ~DataLog();
+
+    int open(const QString &filename);
+    void close();
+    bool isOpen()
+    {
+        return m_running;
+    }
+
+    int write(uint32_t type, uint32_t frame, uint16_t width, uint16_t height, const void *data, uint32_t len);
+    uint32_t dropped()
+    {
+        return m_dropped;
+    }
+
+protected:
+    virtual void run();
+
+private:
+    void enqueue(const void *data, uint32_t len);
+
+    QFile m_file;
+    QElapsedTimer m_time;
+    QMutex m_mutex;
+    QWaitCondition m_wait;
+    uint8_t *m_queue;
+    uint32_t m_head;
+    uint32_t m_tail;
+    uint32_t m_used;
+    uint32_t m_dropped;
+    qint64 m_offset;
+    qint64 m_fileSize;
+    bool m_running;
+};
+
+// Reads a log in place through a memory mapping.
+class DataLogReader
+{
+public:
+    DataLogReader();
+    ~DataLogReader();
+
+    int open(const QString &filename);
+    void close();
+    // returns 0 and the next chunk and its payload, or -1 at the end of the log
+    int next(const DataLogChunk **chunk, const uint8_t **data);
+    void rewind();
+
+private:
+    QFile m_file;
+    uchar *m_map;
+    qint64 m_size;
+    qint64 m_offset;
+};
+
+#endif // DATALOG_H
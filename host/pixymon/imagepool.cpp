@@ -0,0 +1,50 @@
+#include "imagepool.h"
+
+ImagePool::ImagePool()
+{
+}
+
+ImagePool::~ImagePool()
+{
+}
+
+QImage ImagePool::acquire(int width, int height, QImage::Format format)
+{
+    int i;
+    QImage image;
+
+    m_mutex.lock();
+    for (i=0; i<m_free.size(); i++)
+    {
+        const QImage &free = m_free.at(i);
+        if (free.width()==width && free.height()==height && free.format()==format && free.isDetached())
+        {
+            image = m_free.takeAt(i);
+            break;
+        }
+    }
+    m_mutex.unlock();
+
+    if (image.isNull())
+    {
+        image = QImage(width, height, format);
+        m_allocs.fetchAndAddRelaxed(1);
+    }
+
+    return image;
+}
+
+void ImagePool::release(QImage &image)
+{
+    if (image.isNull())
+        return;
+
+    m_mutex.lock();
+    // don't grow without bound if frame sizes keep changing
+    if (m_free.size()>=IP_MAX_FREE)
+        m_free.removeFirst();
+    m_free.append(image);
+    m_mutex.unlock();
+
+    image = QImage();
+}
@@ -0,0 +1,46 @@
+#ifndef IMAGEPOOL_H
+#define IMAGEPOOL_H
+
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QAtomicInt>
+
+#define IP_MAX_FREE     8
+
+// Recycles frame and overlay images between the render thread and the gui thread.
+// The render thread acquire()s an image, fills it and emits it.  Whoever ends up holding
+// the last reference (the gui thread) release()s it back when it's done with it.
+// Images are only handed out again once nobody else references them, so filling them
+// never causes a detach (copy).
+class ImagePool
+{
+public:
+    ImagePool();
+    ~ImagePool();
+
+    QImage acquire(int width, int height, QImage::Format format);
+    void release(QImage &image);
+
+    // counters, read and cleared with takeAllocs() and takeCopied()
+    void addCopied(int bytes)
+    {
+        m_copied.fetchAndAddRelaxed(bytes);
+    }
+    int takeAllocs()
+    {
+        return m_allocs.fetchAndStoreRelaxed(0);
+    }
+    int takeCopied()
+    {
+        return m_copied.fetchAndStoreRelaxed(0);
+    }
+
+private:
+    QMutex m_mutex;
+    QList<QImage> m_free;
+    QAtomicInt m_allocs;
+    QAtomicInt m_copied;
+};
+
+#endif // IMAGEPOOL_H
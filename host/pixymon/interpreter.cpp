@@ -1,4 +1,6 @@
 #include <stdexcept>
+#include <string.h>
+#include <algorithm>
 #include <QMessageBox>
 #include <QFile>
 #include <QDebug>
@@ -10,6 +12,20 @@
 
 QString printType(uint32_t val, bool parens=false);
 
+// cc_setLut run format, see conncomp.h in the firmware
+#define LUT_RUN_SIZE        5
+#define LUT_FLAG_CLEAR      0x01
+#define LUT_RUNS_PER_CALL   0x400
+
+// cc_getStats reply, see colorstats.h in the firmware
+#define STATS_QUANTILES     5
+#define STATS_BIN_RG(bin)   ((int)((bin)>>9 & 0x1ff) - 255)
+#define STATS_BIN_BG(bin)   ((int)((bin)&0x1ff) - 255)
+#define STATS_BIN_COUNT(bin) ((bin)>>18)
+
+// prof_get reply, see prof.h in the firmware
+#define PROF_BINS           32
+
 Interpreter::Interpreter(ConsoleWidget *console, VideoWidget *video)
 {
     m_console = console;
@@ -23,8 +39,10 @@ Interpreter::Interpreter(ConsoleWidget *console, VideoWidget *video)
     if (m_chirp->open()<0)
         throw std::runtime_error("Cannot connect to camera, or no camera found.");
 
-    m_renderer = new Renderer(m_video);
+    m_renderer = new Renderer(m_video, m_chirp);
     m_lut = m_renderer->m_blobs.getLut();
+    m_deviceLutValid = false;
+    m_models = new LutModels(m_lut);
 
     connect(m_console, SIGNAL(textLine(QString)), this, SLOT(command(QString)));
     connect(m_console, SIGNAL(controlKey(Qt::Key)), this, SLOT(controlKey(Qt::Key)));
@@ -32,6 +50,7 @@ Interpreter::Interpreter(ConsoleWidget *console, VideoWidget *video)
     connect(this, SIGNAL(enableConsole(bool)), m_console, SLOT(acceptInput(bool)));
     connect(this, SIGNAL(prompt(QString)), m_console, SLOT(prompt(QString)));
     connect(this, SIGNAL(videoPrompt(uint)), m_video, SLOT(acceptInput(uint)));
+    connect(this, SIGNAL(showLatency(bool)), m_video, SLOT(showLatency(bool)));
     connect(m_video, SIGNAL(selection(int,int,int,int)), this, SLOT(handleSelection(int,int,int,int)));
 }
 
@@ -44,6 +63,7 @@ Interpreter::~Interpreter()
     wait();
     clearProgram();
     delete m_chirp;
+    delete m_models;
 }
 
 int Interpreter::execute()
@@ -482,13 +502,57 @@ void Interpreter::command(const QString &command)
     else if (words[0]=="clear")
     {
         int i;
-        for (i=0; i<LUT_SIZE; i++)
-            m_lut[i] = 0;
+        for (i=1; i<=NUM_MODELS; i++)
+            m_models->clear(i, &m_lutChanged);
+    }
+    else if (words[0]=="overlap")
+    {
+        // overlap priority|nearest, which model gets a cell that more than one model covers
+        if (words.size()>1 && words[1]=="priority")
+            m_models->setOverlap(LutModels::PRIORITY, &m_lutChanged);
+        else if (words.size()>1 && words[1]=="nearest")
+            m_models->setOverlap(LutModels::NEAREST, &m_lutChanged);
+        else if (words.size()>1)
+            emit textOut("error: overlap is priority or nearest.\n");
+        emit textOut(QString("overlap: ") + (m_models->overlap()==LutModels::PRIORITY ? "priority" : "nearest") + "\n");
     }
     else if (words[0]=="save")
         writeFrame();
+    else if (words[0]=="log")
+    {
+        // log <filename> starts logging every frame, log by itself stops
+        if (words.size()>1)
+        {
+            if (m_renderer->startLog(words[1])<0)
+                emit textOut("error: can't create " + words[1] + ".\n");
+        }
+        else
+            m_renderer->stopLog();
+    }
     else if (words[0]=="upload")
         uploadLut();
+    else if (words[0]=="prof")
+    {
+        // prof prints the device's profiling zones, prof reset clears them, prof gui prints
+        // our time per frame since the last prof gui
+        if (words.size()>1 && words[1]=="reset")
+            resetProf();
+        else if (words.size()>1 && words[1]=="gui")
+            emit textOut(m_video->takeStats());
+        else
+            printProf();
+    }
+    else if (words[0]=="latency")
+    {
+        // latency on|off shows or hides the capture-to-display histogram, latency sync
+        // finds the offset between the device's clock and ours again
+        if (words.size()>1 && words[1]=="sync")
+            m_chirp->syncClock();
+        else if (words.size()>1 && (words[1]=="on" || words[1]=="off"))
+            emit showLatency(words[1]=="on");
+        else
+            emit textOut("error: latency is on, off or sync.\n");
+    }
     else if (words[0]=="rendermode")
     {
         if (words.size()>1)
@@ -568,14 +632,135 @@ void Interpreter::handleCall(const QStringList &argv)
     start();
 }
 
+// Sends the LUT entries that differ from the device's copy as runs, in as few calls as
+// possible, and checks the device's checksum of the result.  The first upload (and any
+// upload after an error) clears the device LUT and sends every nonzero entry.
 int Interpreter::uploadLut()
+{
+    int res;
+    uint32_t i;
+    bool full = !m_deviceLutValid;
+    ChirpProc setLut = m_chirp->getProc("cc_setLut");
+
+    if (setLut<0) // older firmware
+    {
+        m_lutChanged.clear();
+        return uploadLutMemory();
+    }
+
+    if ((res=sendLut(setLut, full))==-2 && !full)
+        res = sendLut(setLut, full=true);
+    if (res<0)
+    {
+        m_deviceLutValid = false;
+        m_lutChanged.clear();
+        if (res==-3)
+            emit textOut("error: lookup table has too many colors for the device.\n");
+        else
+            emit textOut("error: lookup table upload failed.\n");
+        return res;
+    }
+    if (!full)
+    {
+        for (i=0; i<m_lutChanged.size(); i++)
+            m_deviceLut[m_lutChanged[i]] = m_lut[m_lutChanged[i]];
+    }
+    else
+        memcpy(m_deviceLut, m_lut, LUT_SIZE);
+    m_lutChanged.clear();
+    m_deviceLutValid = true;
+    return 0;
+}
+
+static void appendRun(QByteArray *runs, uint32_t index, uint32_t len, uint8_t value)
+{
+    runs->append((char)(index&0xff));
+    runs->append((char)(index>>8));
+    runs->append((char)((len-1)&0xff));
+    runs->append((char)((len-1)>>8));
+    runs->append((char)value);
+}
+
+int Interpreter::sendLut(ChirpProc setLut, bool full)
+{
+    uint32_t i, j, k, calls, len;
+    int32_t responseInt;
+    QByteArray runs;
+    uint8_t value;
+
+    if (full)
+    {
+        // runs of equal values starting at each nonzero entry
+        for (i=0; i<LUT_SIZE; )
+        {
+            if (m_lut[i]==0)
+            {
+                i++;
+                continue;
+            }
+            value = m_lut[i];
+            for (j=i+1; j<LUT_SIZE && m_lut[j]==value; j++);
+            appendRun(&runs, i, j-i, value);
+            i = j;
+        }
+    }
+    else
+    {
+        // runs of equal values among the cells that changed, so the work is proportional
+        // to what the models changed, not to the size of the LUT
+        std::sort(m_lutChanged.begin(), m_lutChanged.end());
+        m_lutChanged.erase(std::unique(m_lutChanged.begin(), m_lutChanged.end()), m_lutChanged.end());
+        for (i=0; i<m_lutChanged.size(); )
+        {
+            k = m_lutChanged[i];
+            if (m_lut[k]==m_deviceLut[k])
+            {
+                i++;
+                continue;
+            }
+            value = m_lut[k];
+            for (j=i+1; j<m_lutChanged.size() && m_lutChanged[j]==k+j-i && m_lut[m_lutChanged[j]]==value; j++);
+            appendRun(&runs, k, j-i, value);
+            i = j;
+        }
+    }
+
+    // always make at least one call so we get the checksum back
+    for (i=0, calls=0, responseInt=-1; i==0 || i<(uint32_t)runs.size(); i+=len)
+    {
+        len = qMin((uint32_t)runs.size()-i, (uint32_t)(LUT_RUNS_PER_CALL*LUT_RUN_SIZE));
+        if (m_chirp->callSync(setLut, UINT32(full && i==0 ? LUT_FLAG_CLEAR : 0), UINTS8(len, runs.data()+i), END_OUT_ARGS,
+                              &responseInt, END_IN_ARGS)<0)
+            return -1;
+        if (responseInt<0)
+            return responseInt==-3 ? -3 : -1;
+        calls++;
+        if (len==0)
+            break;
+    }
+    qDebug() << "lut upload:" << runs.size() << "bytes in" << calls << "calls";
+
+    if (responseInt!=lutChecksum(m_lut))
+        return -2;
+    return 0;
+}
+
+// same as cc_lutChecksum in the firmware
+int32_t Interpreter::lutChecksum(const uint8_t *lut)
 {
     uint32_t i, sum;
+
+    for (i=0, sum=5381; i<LUT_SIZE; i++)
+        sum = sum*33 + lut[i];
+
+    return sum&0x7fffffff;
+}
+
+int Interpreter::uploadLutMemory()
+{
+    uint32_t i;
     uint32_t responseInt;
 
-    for (i=0, sum=0; i<LUT_SIZE; i++)
-        sum += m_lut[i];
-    qDebug() << sum;
     ChirpProc setmem = m_chirp->getProc("cc_setMemory");
     for (i=0; i<LUT_SIZE; i+=0x100)
         m_chirp->callSync(setmem, UINT32(0x10010000+i), UINTS8(0x100, m_lut+i), END_OUT_ARGS, &responseInt, END_IN_ARGS);
@@ -585,10 +770,7 @@ int Interpreter::uploadLut()
 
 int Interpreter::loadLut(const QString &filename, int model)
 {
-    int i;
-    int model0;
-
-    if (model<1 || model>7)
+    if (model<1 || model>NUM_MODELS)
         return -2;
 
     // DEBUG
@@ -602,21 +784,7 @@ int Interpreter::loadLut(const QString &filename, int model)
     }
 #endif
 
-    for (i=0; i<LUT_SIZE; i++)
-    {
-#if 0
-        model0 = m_lut[i]&0x07;
-        if (model0==0)
-            model0 = 8;
-        if (m_tempLut[i] && model<=model0)
-            m_lut[i] = (m_tempLut[i]&~0x07) | model;
-#endif
-        if (m_tempLut[i])
-        {
-            m_lut[i] = model;
-        }
-    }
-    return 0;
+    return m_models->set(model, m_tempLut, &m_lutChanged);
 }
 
 int compareUnsigned(const void *a, const void *b)
@@ -645,29 +813,128 @@ void minmax(int &min, int &max, int x)
 
 void Interpreter::writeFrame()
 {
-    uint32_t pixels[0x10000];
+    static int index = 1;
+    DataLog log;
+    QString filename;
 
-    int i, j, k;
-     uint r, g, b;
-    uint8_t h, s, v, c;
+    filename = QString("frame%1.pxl").arg(index++, 2, 10, QLatin1Char('0'));
+    if (log.open(filename)<0)
+    {
+        emit textOut("error: can't create " + filename + ".\n");
+        return;
+    }
+    log.write(DL_TYPE_BA81, 0, WIDTH, HEIGHT, m_renderer->m_frameData, WIDTH*HEIGHT);
+    log.close();
+    emit textOut("Wrote " + filename + ".\n");
+}
 
-    uint8_t *frame = m_renderer->m_frameData;
+// Get the statistics of the box from the device and expand the histogram bins into
+// (r, g, b) samples for CLUT::generateFromImgSample.  Each bin stands for its count of
+// samples at the bin's exact (r-g, b-g), which is all the CLUT looks at, so the LUT is the
+// same as from the frame (see colorstats.h in the firmware).
+// Returns the number of values written to pixels (3 per sample), negative if the device
+// can't do it (older firmware, a box too big for its memory) or the samples don't fit in
+// pixels, in which case we use the frame.  This is called from the
+// gui thread, so the device is left alone while the interpreter thread is talking to it
+// (a program or a command is running).
+int Interpreter::getDeviceStats(int x0, int y0, int width, int height, uint32_t *pixels, uint32_t size)
+{
+    int res;
+    int32_t responseInt = -1, sumRG, sumBG;
+    uint32_t i, j, k, count, total, lenQRG, lenQBG, numBins;
+    int16_t *qRG, *qBG;
+    uint32_t *bins;
+    int rg, bg;
+    ChirpProc getStats;
+
+    if (m_programRunning || isRunning())
+        return -1;
+
+    getStats = m_chirp->getProc("cc_getStats");
+    if (getStats<0)
+        return -1;
+
+    res = m_chirp->callSync(getStats, UINT16(x0), UINT16(y0), UINT16(width), UINT16(height), END_OUT_ARGS,
+                            &responseInt, &sumRG, &sumBG, &lenQRG, &qRG, &lenQBG, &qBG, &numBins, &bins, END_IN_ARGS);
+    if (res<0 || responseInt<=0 || lenQRG!=STATS_QUANTILES || lenQBG!=STATS_QUANTILES)
+        return -1;
+
+    for (i=0, total=0; i<numBins; i++)
+        total += STATS_BIN_COUNT(bins[i]);
+    if (total!=(uint32_t)responseInt || total*3>size)
+        return -1;
 
-    for (k=0, i=1; i<HEIGHT; i+=2)
+    for (i=0, k=0; i<numBins; i++)
     {
-        for (j=1; j<WIDTH; j+=2, k+=3)
+        rg = STATS_BIN_RG(bins[i]);
+        bg = STATS_BIN_BG(bins[i]);
+        count = STATS_BIN_COUNT(bins[i]);
+        for (j=0; j<count; j++, k+=3)
         {
-            r = frame[i*WIDTH + j];
-            g = frame[i*WIDTH - WIDTH + j];
-            b = frame[i*WIDTH - WIDTH + j - 1];
-            pixels[k] = r;
-            pixels[k+1] = g;
-            pixels[k+2] = b;
+            pixels[k] = 0x100 + rg;
+            pixels[k+1] = 0x100;
+            pixels[k+2] = 0x100 + bg;
         }
     }
 
-    fileOut("frame", (int *)pixels, k, 3, WIDTH/2, HEIGHT/2);
+    return k;
+}
+
+// Print each profiling zone's count and min, mean and max times, and its histogram,
+// bin b is the number of times from 2^(b-1) to 2^b-1 clocks.
+void Interpreter::printProf()
+{
+    int res;
+    int32_t responseInt = -1;
+    uint32_t i, b, freq, lenStats, lenHist;
+    uint32_t *stats, *hist;
+    char *names;
+    QStringList nameList;
+    QString print;
+    ChirpProc getProf = m_chirp->getProc("prof_get");
+
+    if (getProf<0)
+    {
+        emit textOut("error: the firmware doesn't have profiling.\n");
+        return;
+    }
 
+    res = m_chirp->callSync(getProf, END_OUT_ARGS,
+                            &responseInt, &freq, &names, &lenStats, &stats, &lenHist, &hist, END_IN_ARGS);
+    if (res<0 || responseInt<0 || freq<1000000)
+    {
+        emit textOut("error: prof_get failed.\n");
+        return;
+    }
+    nameList = QString(names).split(',');
+    freq /= 1000000; // clocks per us
+
+    // stats are count, min, max, mean for each zone
+    for (i=0; i<(uint32_t)responseInt && i<(uint32_t)nameList.size() && (i+1)*4<=lenStats; i++)
+    {
+        print += nameList[i] + ": " + QString::number(stats[i*4]);
+        if (stats[i*4])
+        {
+            print += ", min " + QString::number(stats[i*4+1]/freq) + " us, mean " + QString::number(stats[i*4+3]/freq) +
+                    " us, max " + QString::number(stats[i*4+2]/freq) + " us\n   ";
+            for (b=0; b<PROF_BINS && (i+1)*PROF_BINS<=lenHist; b++)
+            {
+                if (hist[i*PROF_BINS+b])
+                    print += " <2^" + QString::number(b) + ":" + QString::number(hist[i*PROF_BINS+b]);
+            }
+        }
+        print += "\n";
+    }
+    emit textOut(print);
+}
+
+void Interpreter::resetProf()
+{
+    int32_t responseInt = -1;
+    ChirpProc reset = m_chirp->getProc("prof_reset");
+
+    if (reset<0 || m_chirp->callSync(reset, END_OUT_ARGS, &responseInt, END_IN_ARGS)<0 || responseInt<0)
+        emit textOut("error: prof_reset failed.\n");
 }
 
 void Interpreter::getStats(int x0, int y0, int width, int height)
@@ -687,6 +954,12 @@ void Interpreter::getStats(int x0, int y0, int width, int height)
 
     uint8_t *frame = m_renderer->m_frameData;
 
+    if ((k=getDeviceStats(x0, y0, width, height, pixels, sizeof(pixels)/sizeof(uint32_t)))>=0)
+    {
+        m_clut.generateFromImgSample(pixels, k, m_tempLut);
+        return;
+    }
+
     x0 |= 0x01;
     y0 |= 0x01;
 
@@ -708,12 +981,7 @@ void Interpreter::getStats(int x0, int y0, int width, int height)
         }
     }
 
-    // DEBUG
-#if 0
-    fileOut("pixels", (int *)pixels, k, 3);
-#endif
-
-    CLUT::generateFromImgSample(pixels, k, m_tempLut);
+    m_clut.generateFromImgSample(pixels, k, m_tempLut);
 
     // DEBUG
 #if 0
@@ -812,38 +1080,6 @@ unsigned int Interpreter::fileIn(const QString &name, char *data, unsigned int s
     return file.read(data, size);
 }
 
-void Interpreter::fileOut(const QString &name, int *data, unsigned int len, unsigned int pitch, int p1, int p2)
-{
-    unsigned int i, j;
-    static int index = 1;
-    QString str, namex;
-    namex = QString("%1%2").arg(name).arg(index, 2, 10, QLatin1Char('0'));
-    QFile file("matlab\\" + namex + ".m");
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-        return;
-
-    QTextStream out(&file);
-
-    out << "function [A, b, c]=" << namex << "()\n\n";
-    out << "A=[";
-    for (i=0; i<len;)
-    {
-        if (i>0)
-            out << ",\n";
-        for (j=0; j<pitch; j++)
-        {
-            if (j>0)
-                out << ", ";
-            out << str.sprintf("%d", data[i++]);
-        }
-    }
-    out << "];\n";
-    out << "b=" << QString::number(p1) << ";\n";
-    out << "c=" << QString::number(p2) << ";\n";
-
-    index++;
-}
-
 // DEBUG
 #if 0
 void Interpreter::fileOutDebug(uint8_t *data)
@@ -9,6 +9,7 @@
 #include "chirpmon.h"
 #include "blobs.h"
 #include "clut.h"
+#include "lutmodels.h"
 
 #define PROMPT  ">"
 
@@ -54,6 +55,7 @@ signals:
     void textOut(const QString &text);
     void prompt(const QString &text);
     void videoPrompt(uint type);
+    void showLatency(bool show);
     void enableConsole(bool enable);
 
 public slots:
@@ -84,11 +86,16 @@ private:
 
     // experimental
     int uploadLut();
+    int sendLut(ChirpProc setLut, bool full);
+    int uploadLutMemory();
+    static int32_t lutChecksum(const uint8_t *lut);
     int loadLut(const QString &filename, int model);
 
+    int getDeviceStats(int x0, int y0, int width, int height, uint32_t *pixels, uint32_t size);
     void getStats(int x0, int y0, int width, int height);
+    void printProf();
+    void resetProf();
     void writeFrame();
-    void fileOut(const QString &name, int *data, unsigned int len, unsigned int pitch=1, int p1=0, int p2=0);
 
     // DEBUG
 #if 0
@@ -99,6 +106,11 @@ private:
     uint8_t *m_lut;
 
     uint8_t m_tempLut[LUT_SIZE];
+    uint8_t m_deviceLut[LUT_SIZE]; // what we last uploaded
+    bool m_deviceLutValid;
+    std::vector<uint32_t> m_lutChanged; // cells changed since the last upload
+    LutModels *m_models;
+    CLUT m_clut;
 
     // for thread
     QMutex m_mutex;
@@ -0,0 +1,134 @@
+#include <string.h>
+#include "lutmodels.h"
+
+LutModels::LutModels(uint8_t *lut)
+{
+    m_lut = lut;
+    m_overlap = PRIORITY;
+    memset(m_cells, 0, sizeof(m_cells));
+    memset(m_sumRG, 0, sizeof(m_sumRG));
+    memset(m_sumBG, 0, sizeof(m_sumBG));
+    memset(m_count, 0, sizeof(m_count));
+}
+
+void LutModels::setOverlap(Overlap overlap, std::vector<uint32_t> *changed)
+{
+    uint32_t cells[LUT_SIZE/32];
+    int i, j;
+
+    m_overlap = overlap;
+
+    // only cells covered by more than one model can change
+    memset(cells, 0, sizeof(cells));
+    for (i=0; i<NUM_MODELS; i++)
+    {
+        for (j=0; j<LUT_SIZE/32; j++)
+            cells[j] |= m_cells[i][j];
+    }
+    update(cells, changed);
+}
+
+int LutModels::set(int model, const uint8_t *modelLut, std::vector<uint32_t> *changed)
+{
+    uint32_t cells[LUT_SIZE/32];
+    uint32_t i, *modelCells;
+
+    if (model<1 || model>NUM_MODELS)
+        return -1;
+
+    // the cells the model covered, and the cells it covers now
+    modelCells = m_cells[model-1];
+    memcpy(cells, modelCells, sizeof(cells));
+    memset(modelCells, 0, sizeof(cells));
+    m_sumRG[model-1] = 0;
+    m_sumBG[model-1] = 0;
+    m_count[model-1] = 0;
+    for (i=0; i<LUT_SIZE; i++)
+    {
+        if (modelLut[i]==0)
+            continue;
+        modelCells[i>>5] |= 1U<<(i&0x1f);
+        m_sumRG[model-1] += (int8_t)(i>>8);
+        m_sumBG[model-1] += (int8_t)i;
+        m_count[model-1]++;
+    }
+    for (i=0; i<LUT_SIZE/32; i++)
+        cells[i] |= modelCells[i];
+
+    update(cells, changed);
+    return 0;
+}
+
+int LutModels::clear(int model, std::vector<uint32_t> *changed)
+{
+    uint32_t cells[LUT_SIZE/32];
+
+    if (model<1 || model>NUM_MODELS)
+        return -1;
+
+    memcpy(cells, m_cells[model-1], sizeof(cells));
+    memset(m_cells[model-1], 0, sizeof(cells));
+    m_sumRG[model-1] = 0;
+    m_sumBG[model-1] = 0;
+    m_count[model-1] = 0;
+
+    update(cells, changed);
+    return 0;
+}
+
+uint32_t LutModels::cells(int model)
+{
+    if (model<1 || model>NUM_MODELS)
+        return 0;
+    return m_count[model-1];
+}
+
+uint8_t LutModels::owner(uint32_t index)
+{
+    int model, best;
+    double rg, bg, dist, bestDist;
+
+    for (model=1, best=0, bestDist=0; model<=NUM_MODELS; model++)
+    {
+        if (!covers(model, index))
+            continue;
+        if (m_overlap==PRIORITY)
+            return model;
+
+        rg = (int8_t)(index>>8) - (double)m_sumRG[model-1]/m_count[model-1];
+        bg = (int8_t)index - (double)m_sumBG[model-1]/m_count[model-1];
+        dist = rg*rg + bg*bg;
+        if (best==0 || dist<bestDist)
+        {
+            best = model;
+            bestDist = dist;
+        }
+    }
+    return best;
+}
+
+// recompute the owner of each of cells, report the ones that change
+void LutModels::update(const uint32_t *cells, std::vector<uint32_t> *changed)
+{
+    uint32_t i, j, index;
+    uint8_t value;
+
+    for (i=0; i<LUT_SIZE/32; i++)
+    {
+        if (cells[i]==0)
+            continue;
+        for (j=0; j<32; j++)
+        {
+            if (!(cells[i]&(1U<<j)))
+                continue;
+            index = (i<<5) | j;
+            value = owner(index);
+            if (m_lut[index]!=value)
+            {
+                m_lut[index] = value;
+                if (changed)
+                    changed->push_back(index);
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LUTMODELS_H
+#define LUTMODELS_H
+
+#include <stdint.h>
+#include <vector>
+#include "blobs.h"
+
+// Keeps which LUT cells each model (1 to NUM_MODELS) covers, so that models can overlap
+// and a model can be retrained without rebuilding the LUT.  A cell covered by more than
+// one model goes to one of them, by priority (lower model number wins) or to the model
+// whose centroid is nearest the cell.  Changing a model only touches the cells it covered
+// before and covers now, and reports the ones whose value changed.
+class LutModels
+{
+public:
+    enum Overlap
+    {
+        PRIORITY,
+        NEAREST
+    };
+
+    LutModels(uint8_t *lut);
+
+    void setOverlap(Overlap overlap, std::vector<uint32_t> *changed);
+    Overlap overlap()
+    {
+        return m_overlap;
+    }
+
+    // replace model's cells with the nonzero cells of modelLut
+    int set(int model, const uint8_t *modelLut, std::vector<uint32_t> *changed);
+    int clear(int model, std::vector<uint32_t> *changed);
+    uint32_t cells(int model);
+
+private:
+    bool covers(int model, uint32_t index)
+    {
+        return m_cells[model-1][index>>5]&(1U<<(index&0x1f));
+    }
+    uint8_t owner(uint32_t index);
+    void update(const uint32_t *cells, std::vector<uint32_t> *changed);
+
+    uint8_t *m_lut;
+    Overlap m_overlap;
+    uint32_t m_cells[NUM_MODELS][LUT_SIZE/32];
+    // centroid of each model's cells, in signed (r-g, b-g) LUT coordinates
+    int32_t m_sumRG[NUM_MODELS];
+    int32_t m_sumBG[NUM_MODELS];
+    uint32_t m_count[NUM_MODELS];
+};
+
+#endif // LUTMODELS_H
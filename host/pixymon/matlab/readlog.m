@@ -0,0 +1,92 @@
+function chunks = readlog(filename)
+% chunks = readlog(filename)
+% Reads a log written by pixymon or pixymon-cli (see datalog.h).  Returns a
+% struct array with fields type, timestamp (us), frame, width, height and data.
+% BA81 data is a height x width uint8 image, CCQ1 and CCQ2 data is a column of uint32
+% q-vals, and CCB2 data, in version 2 logs, is an N x 9 matrix of model, x, y, left, right,
+% top, bottom, angle, area (see blobrec.h), empty for a delta that doesn't follow the frame
+% before it.  BLOB data, in version 1 logs, is an N x 6 matrix of model, left, right, top,
+% bottom, angle.
+
+m = memmapfile(filename, 'Format', 'uint8');
+d = m.Data;
+
+if typecast(d(1:4)', 'uint32')~=hex2dec('474c5850')
+    error('%s is not a pixy log', filename);
+end
+version = double(typecast(d(5:6)', 'uint16'));
+if version<1 || version>2
+    error('%s is a version %d log', filename, version);
+end
+headerLen = double(typecast(d(7:8)', 'uint16'));
+chunkLen = double(typecast(d(9:12)', 'uint32'));
+
+chunks = struct('type', {}, 'timestamp', {}, 'frame', {}, 'width', {}, 'height', {}, 'data', {});
+offset = headerLen;
+prevFrame = -1;
+prev = [];
+while offset+chunkLen<=length(d)
+    h = d(offset+1:offset+chunkLen)';
+    type = typecast(h(1:4), 'uint32');
+    if type==0
+        break;
+    end
+    len = double(typecast(h(5:8), 'uint32'));
+    c.type = char(h(1:4));
+    c.timestamp = double(typecast(h(9:16), 'uint64'));
+    c.frame = double(typecast(h(17:20), 'uint32'));
+    c.width = double(typecast(h(21:22), 'uint16'));
+    c.height = double(typecast(h(23:24), 'uint16'));
+    offset = offset+chunkLen;
+    if offset+len>length(d)
+        break;
+    end
+    p = d(offset+1:offset+len)';
+    % each version has its own blob chunks, the others' are left as they are
+    decode = c.type;
+    if (version<2 && strcmp(decode, 'CCB2')) || (version>=2 && strcmp(decode, 'BLOB'))
+        decode = '';
+    end
+    switch decode
+        case 'BA81'
+            c.data = reshape(p, c.width, c.height)';
+        case {'CCQ1', 'CCQ2'}
+            c.data = typecast(p, 'uint32')';
+        case 'CCB2'
+            [c.data, prevFrame, prev] = records(p, prevFrame, prev);
+        case 'BLOB'
+            b = double(reshape(typecast(p, 'uint16'), 6, []))';
+            b(:, 6) = double(typecast(uint16(b(:, 6)), 'int16'));
+            c.data = b;
+        otherwise
+            c.data = p;
+    end
+    chunks(end+1) = c;
+    offset = offset+ceil(len/8)*8;
+end
+
+function [b, frame, last] = records(p, prevFrame, prev)
+% decodes a CCB2 chunk, prevFrame and prev are the frame number and blobs of the last one,
+% frame is -1 if it couldn't be decoded
+w = double(typecast(p, 'uint16'));
+frame = w(3);
+n = w(4);
+b = [];
+last = [];
+if w(1)~=1 || (~bitand(w(2), 1) && (prevFrame<0 || frame~=mod(prevFrame+1, 65536)))
+    frame = -1;
+    return;
+end
+masks = w(7:6+ceil(n/16));
+r = reshape(w(7+length(masks):end), 10, [])';
+b = zeros(n, 9);
+k = 1;
+for i=0:n-1
+    if bitand(masks(floor(i/16)+1), bitshift(1, mod(i, 16)))
+        b(i+1, :) = prev(i+1, :);
+    else
+        b(i+1, :) = [r(k, 1:7) double(typecast(uint16(r(k, 8)), 'int16')) r(k, 9)+r(k, 10)*65536];
+        k = k+1;
+    end
+end
+last = b;
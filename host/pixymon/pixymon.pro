@@ -22,7 +22,11 @@ SOURCES += main.cpp\
     calc.cpp \
     blob.cpp \
     blobs.cpp \
-    clut.cpp
+    ../../device/video/blobrec.c \
+    clut.cpp \
+    imagepool.cpp \
+    datalog.cpp \
+    lutmodels.cpp
 
 HEADERS  += mainwindow.h \
     link.h \
@@ -36,10 +40,19 @@ HEADERS  += mainwindow.h \
     calc.h \
     blobs.h \
     blob.h \
-    clut.h
+    qval.h \
+    ../../device/video/blobrec.h \
+    clut.h \
+    imagepool.h \
+    datalog.h \
+    lutmodels.h
 
 INCLUDEPATH += ../libpixy
 
+# the device's CCB2 records (blobrec.h) hold up to MAX_BLOBS (blobs.h) here, the device
+# sends at most 16
+DEFINES += BR_MAX_BLOBS=256
+
 FORMS    += mainwindow.ui
 
 LIBS += ./libusb.a
@@ -0,0 +1,31 @@
+#ifndef QVAL_H
+#define QVAL_H
+
+#include <stdint.h>
+
+// Run-length segments (q vals) are one uint32 each, and a 0 starts the next row.  The
+// fourcc sent with them (and the log chunk type) says which layout they're in.
+// Same as device/video/qval.h.
+//
+// CCQ1, up to 511 columns (the camera's 320x200 mode):
+// | 4 bits    | 7 bits      | 9 bits | 9 bits    | 3 bits |
+// | shift val | shifted sum | length | begin col | model  |
+//
+// CCQ2, up to 2047 columns, for the higher resolution modes:
+// | 7 bits      | 11 bits | 11 bits   | 3 bits |
+// | shifted sum | length  | begin col | model  |
+
+#define QVAL_CCQ1                   0x31514343 // "CCQ1"
+#define QVAL_CCQ2                   0x32514343 // "CCQ2"
+
+#define QVAL_COL_BITS(format)       ((format)==QVAL_CCQ2 ? 11 : 9)
+#define QVAL_MAX_COLS(format)       ((1<<QVAL_COL_BITS(format))-1)
+
+#define QVAL_MODEL(qval)            ((qval)&0x07)
+#define QVAL_BEGIN(format, qval)    (((qval)>>3)&QVAL_MAX_COLS(format))
+#define QVAL_LEN(format, qval)      (((qval)>>(3+QVAL_COL_BITS(format)))&QVAL_MAX_COLS(format))
+// no sum
+#define QVAL_MAKE(format, model, begin, len) \
+    ((uint32_t)(model) | (uint32_t)(begin)<<3 | (uint32_t)(len)<<(3+QVAL_COL_BITS(format)))
+
+#endif // QVAL_H
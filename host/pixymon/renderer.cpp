@@ -3,17 +3,20 @@
 #include <QDebug>
 #include "renderer.h"
 #include "videowidget.h"
+#include "imagepool.h"
 #include "chirp.hpp"
+#include "chirpmon.h"
 #include "calc.h"
 #include <math.h>
 
-uint32_t num_comps;
-int16_t* comps = NULL;
-void VISUcallback(QImage* image);
-
-Renderer::Renderer(VideoWidget *video)
+Renderer::Renderer(VideoWidget *video, ChirpMon *chirp)
 {
     m_video = video;
+    m_chirp = chirp;
+    m_pool = m_video->pool();
+    m_spans[0].reserve(RD_SPANS_RESERVE);
+    m_spans[1].reserve(RD_SPANS_RESERVE);
+    m_spanIndex = 0;
 
     m_frameData = new uint8_t[0x20000];
 
@@ -28,14 +31,19 @@ Renderer::Renderer(VideoWidget *video)
     m_lut = NULL;
 
     m_mode = 3;
+    m_frame = 0;
+    br_decoderInit(&m_records);
+    br_encoderInit(&m_logRecords, 1);
 
+    qRegisterMetaType<RLSpans>("RLSpans");
+    connect(this, SIGNAL(capture(qint64)), m_video, SLOT(handleCapture(qint64)));
     connect(this, SIGNAL(image(QImage, bool)), m_video, SLOT(handleImage(QImage, bool)));
+    connect(this, SIGNAL(spans(RLSpans, int, int, bool)), m_video, SLOT(handleSpans(RLSpans, int, int, bool)));
 }
 
 
 Renderer::~Renderer()
 {
-    free(comps);
 }
 
 
@@ -237,8 +245,9 @@ int Renderer::renderBA81Filter(uint16_t width, uint16_t height, uint32_t frameLe
     int f0=0, f1=0, f2=0, f3=0, f4=0, f5=0, f6=0, f7=0;
 
     memcpy(m_frameData, frame, width*height);
+    m_pool->addCopied(width*height);
 
-    QImage img(width/2, height/2, QImage::Format_RGB32);
+    QImage img = m_pool->acquire(width/2, height/2, QImage::Format_RGB32);
 
     hbias = 0;
     n = 0;
@@ -517,15 +526,19 @@ int Renderer::renderBA81(uint16_t width, uint16_t height, uint32_t frameLen, uin
 
 
     frame0 = frame;
+    if (m_log.isOpen())
+        m_log.write(DL_TYPE_BA81, m_frame, width, height, frame, width*height);
     //average(width, height, frame);
+    // keep a copy of the raw frame for selections and saving
     memcpy(m_frameData, frame, width*height);
+    m_pool->addCopied(width*height);
 
     // skip first line
     frame += width;
 
     // don't render top and bottom rows, and left and rightmost columns because of color
     // interpolation
-    QImage img(width-2, height-2, QImage::Format_RGB32);
+    QImage img = m_pool->acquire(width-2, height-2, QImage::Format_RGB32);
 
     for (y=1; y<height-1; y++)
     {
@@ -546,25 +559,37 @@ int Renderer::renderBA81(uint16_t width, uint16_t height, uint32_t frameLen, uin
     if (m_mode&0x01)
     {
         uint16_t numBlobs;
-        uint16_t *blobs;
+        BrBlob *blobs;
         uint32_t numQVals;
         uint32_t *qVals;
 
         m_blobs.process(width, height, frameLen, frame0, &numBlobs, &blobs, &numQVals, &qVals);
+        if (m_log.isOpen())
+        {
+            m_log.write(m_blobs.qvalFormat(), m_frame, width/2, height/2, qVals, numQVals*sizeof(uint32_t));
+            logBlobs(width, height, m_blobs.recordFlags(), numBlobs, blobs);
+        }
         if (m_mode&0x04)
-            renderCCQ1(width/2, height/2, numQVals, qVals);
+            renderCCQ(m_blobs.qvalFormat(), width/2, height/2, numQVals, qVals);
         if (m_mode&0x02)
-            renderCCB1(width, height, numBlobs, blobs);
+            renderCCB2(width, height, m_blobs.recordFlags(), numBlobs, blobs);
     }
+    m_frame++;
     return 0;
 }
 
-int Renderer::renderCCB1(uint16_t width, uint16_t height, uint16_t numBlobs, uint16_t *blobs)
+void Renderer::logBlobs(uint16_t width, uint16_t height, uint16_t flags, uint16_t numBlobs, const BrBlob *blobs)
+{
+    m_log.write(DL_TYPE_CCB2, m_frame, width, height, m_logWords,
+                br_encode(&m_logRecords, blobs, numBlobs, width, height, flags, m_logWords)*sizeof(uint16_t));
+}
+
+int Renderer::renderCCB2(uint16_t width, uint16_t height, uint16_t flags, uint16_t numBlobs, const BrBlob *blobs)
 {
-    uint16_t i, left, right, top, bottom;
-    QImage img(width, height, QImage::Format_ARGB32);
+    uint16_t i;
+    const BrBlob *blob;
+    QImage img = m_pool->acquire(width, height, QImage::Format_ARGB32);
     QPainter p;
-    uint8_t model;
     QString str;
     QString *label;
 
@@ -576,71 +601,32 @@ int Renderer::renderCCB1(uint16_t width, uint16_t height, uint16_t numBlobs, uin
     QFont font("verdana", 9);
     font.setStyleStrategy(QFont::NoAntialias);
     p.setFont(font);
-    for (i=0; i<numBlobs; i++)
+    // coded blobs' models are their codes, and they come after the regular blobs
+    for (i=0, blob=blobs; i<numBlobs; i++, blob++)
     {
-        if (blobs[i*4+0]==0)
-            continue;
-
-        model = blobs[i*4+0]&0x07;
-        if (model==0)
-            break;
-        left = blobs[i*4+0]>>3;
-        right = blobs[i*4+1]>>3;
-        top = blobs[i*4+2]>>3;
-        bottom = blobs[i*4+3]>>3;
-        //qDebug() << left << " " << right << " " << top << " " << bottom;
-        p.drawRect(left, top, right-left, bottom-top);
-        label = m_blobs.getLabel(model);
+        //qDebug() << blob->left << " " << blob->right << " " << blob->top << " " << blob->bottom;
+        p.drawRect(blob->left, blob->top, blob->right-blob->left, blob->bottom-blob->top);
+        label = m_blobs.getLabel(blob->model);
         if (label)
             str = *label;
+        else if (blob->model>NUM_MODELS)
+            str = "m=" + code2string(blob->model); // + QChar(0xa6, 0x03); //QChar(0xb8, 0x03);//  QChar(0xa6, 0x03)
         else
-            str = str.sprintf("m=%d", model);
+            str = str.sprintf("m=%d", blob->model);
 
         p.setPen(QPen(QColor(0, 0, 0, 0xff)));
-        p.drawText(left+1, top+1, str);
+        p.drawText(blob->left+1, blob->top+1, str);
         p.setPen(QPen(QColor(0xff, 0xff, 0xff, 0xff)));
-        p.drawText(left, top, str);
-    }
-    //deal with coded bobls
-    blobs += i*4;
-    numBlobs -= i;
-    for (i=0; i<numBlobs; i++)
-    {
-#ifdef RENDER_ANGLE
-        int16_t angle;
-        model = blobs[i*6+0]>>3;
-        left = blobs[i*6+1];
-        right = blobs[i*6+2];
-        top = blobs[i*6+3];
-        bottom = blobs[i*6+4];
-        angle = blobs[i*6+5];
-#else
-        model = blobs[i*5+0]>>3;
-        left = blobs[i*5+1];
-        right = blobs[i*5+2];
-        top = blobs[i*5+3];
-        bottom = blobs[i*5+4];
-#endif
-        //qDebug() << left << " " << right << " " << top << " " << bottom;
-        p.drawRect(left, top, right-left, bottom-top);
-        label = m_blobs.getLabel(model);
-        if (label)
-            str = *label;
-        else
-            str = "m=" + code2string(model); // + QChar(0xa6, 0x03); //QChar(0xb8, 0x03);//  QChar(0xa6, 0x03)
-
-        p.setPen(QPen(QColor(0, 0, 0, 0xff)));
-        p.drawText(left+1, top+1, str);
-        p.setPen(QPen(QColor(0xff, 0xff, 0xff, 0xff)));
-        p.drawText(left, top, str);
+        p.drawText(blob->left, blob->top, str);
 
-#ifdef RENDER_ANGLE
-        str = QChar(0xa6, 0x03) + str.sprintf("=%d", angle);
-        p.setPen(QPen(QColor(0, 0, 0, 0xff)));
-        p.drawText(left+1, bottom+12, str);
-        p.setPen(QPen(QColor(0xff, 0xff, 0xff, 0xff)));
-        p.drawText(left, bottom+11, str);
-#endif
+        if ((flags&BR_FLAG_ANGLE) && blob->model>NUM_MODELS)
+        {
+            str = QChar(0xa6, 0x03) + str.sprintf("=%d", blob->angle);
+            p.setPen(QPen(QColor(0, 0, 0, 0xff)));
+            p.drawText(blob->left+1, blob->bottom+12, str);
+            p.setPen(QPen(QColor(0xff, 0xff, 0xff, 0xff)));
+            p.drawText(blob->left, blob->bottom+11, str);
+        }
     }
     //qDebug() << numBlobs;
     p.end();
@@ -653,169 +639,86 @@ int Renderer::renderCCB1(uint16_t width, uint16_t height, uint16_t numBlobs, uin
     return 0;
 }
 
-int Renderer::renderVISU(uint32_t cc_num, int16_t* c_components)
-{
-#if 0
-    unsigned int x, y;
-    unsigned int *line;
-    unsigned int r, g, b;
-    frame += width;
-
-    // don't render top and bottom rows, and left and rightmost columns because of color
-    // interpolation
-    QImage img(width-2, height-2, QImage::Format_RGB32);
-
-    for (y=1; y<height-1; y++)
-    {
-        line = (unsigned int *)img.scanLine(y-1);
-        frame++;
-        for (x=1; x<width-1; x++, frame++)
-        {
-            interpolateBayer(width, x, y, frame, r, g, b);
-            *line++ = (0xff<<24) | (r<<16) | (g<<8) | (b<<0);
-        }
-        frame++;
-    }
-#endif
-
-
-    // Save the arguments for later
-    num_comps = cc_num;
-    comps = (int16_t*)realloc(comps, sizeof(int16_t)*cc_num);
-    memcpy(comps, c_components, sizeof(int16_t)*cc_num);
-	
-	// DEBUG
-    int height = 200;
-    int width = 320;
-    double yscale = (double)100 / (double)height;
-    double xscale = (double)160 / (double)width;
-    int t, r, b, l;
-    int m_area = 0;
-
-    for (unsigned int i = 0; i < (num_comps/4); i++)
-    {
-        int16_t top = 0, right = 0, bottom = 0, left = 0;
-        top = int(double(comps[(i*4)+0]) * yscale);
-        right = int(double(comps[(i*4)+1]) * xscale);
-        bottom = int(double(comps[(i*4)+2]) * yscale);
-        left = int(double(comps[(i*4)+3]) * xscale);
-
-        int area = (bottom - top)*(right - left);
-        if (area > m_area)
-        {
-            m_area = area;
-            t = top, r = right, b = bottom, l = left;
-        }
-    }
-    //qDebug() << "t: " << t << "\tr: " << r << "\tb: " << b << "\tl: " << l;
-
-    m_video->callMeMaybe(VISUcallback);
-
-    return 0;
-}
-
-void VISUcallback(QImage* image)
-{
-    // TEMP
-    int height = 200;
-    int width = 320;
-
-    double yscale = (double)image->height() / (double)height;
-    double xscale = (double)image->width() / (double)width;
-
-    // Start painting video widget
-    QPainter p;
-    p.begin(image);
-    p.setPen(QPen(QColor(Qt::color0)));
-    p.setBrush(QBrush(QColor(Qt::color0), Qt::NoBrush));
-    for (unsigned int i = 0; i < (num_comps/4); i++)
-    {
-        int16_t top = 0, right = 0, bottom = 0, left = 0;
-        top = int(double(comps[(i*4)+0]) * yscale);
-        right = int(double(comps[(i*4)+1]) * xscale);
-        bottom = int(double(comps[(i*4)+2]) * yscale);
-        left = int(double(comps[(i*4)+3]) * xscale);
-
-        unsigned int addr = (unsigned int)comps;
-        unsigned int paddr = (unsigned int)&comps;
-
-        int k = 0, l = 0;
-        k += addr;
-        l += paddr;
-
-        // Since we aren't rendering the first and last rows/columns, adjust bounding
-        // box accordingly
-        if (top < 0) top = 0;
-        else if (top > (height-3)) top = (height-3);
-        if (bottom < 0) bottom = 0;
-        else if (bottom > (height-3)) bottom = (height-3);
-        if (right < 0) right = 0;
-        else if (right > (width-3)) right = (width-3);
-        if (left < 0) left = 0;
-        else if (left > (width-3)) left = (width-3);
-
-        p.drawRect(QRect(left, top, right-left, bottom-top));
-
-    }
-    p.end();
-}
-
-void Renderer::handleRL(QImage *image, uint color, int row, int startCol, int len)
-{
-    unsigned int *line;
-    int col;
-
-    line = (unsigned int *)image->scanLine(row);
-    for (col=startCol; col<startCol+len; col++)
-        line[col] = color;
-}
-
-int Renderer::renderCCQ1(uint16_t width, uint16_t height, uint32_t numVals, uint32_t *qVals)
+int Renderer::renderCCQ(uint32_t format, uint16_t width, uint16_t height, uint32_t numVals, uint32_t *qVals)
 {
     int32_t row;
-    uint32_t i, startCol, length;
-    uint8_t model;
-    QImage img(width, height, QImage::Format_ARGB32);
-    unsigned int palette[] = {0x00000000, 0x80ff0000, 0x8000ff00, 0x800000ff, 0x80ffff00, 0x8000ffff, 0x20ff00ff};
+    uint32_t i, qval;
+    RLSpan span;
+    static const unsigned int palette[] = {0x00000000, 0x80ff0000, 0x8000ff00, 0x800000ff, 0x80ffff00, 0x8000ffff, 0x20ff00ff, 0x20ff00ff};
 
     qDebug() << numVals;
 
-    // q val:
-    // | 4 bits    | 7 bits      | 9 bits | 9 bits    | 3 bits |
-    // | shift val | shifted sum | length | begin col | model  |
+    // q vals are CCQ1 or CCQ2 (format), see qval.h
 
-    img.fill(0x00000000);
+    // decode into a span list, leaving qVals intact, and let the video widget blend the
+    // runs straight onto the background.  Alternate between 2 lists so we usually don't
+    // touch (and reallocate) the one the gui thread is still holding.
+    m_spanIndex ^= 1;
+    RLSpans &spanList = m_spans[m_spanIndex];
+    spanList.resize(0);
     for (i=0, row=-1; i<numVals; i++)
     {
-        if (qVals[i]==0)
+        qval = qVals[i];
+        if (qval==0)
         {
             row++;
             continue;
         }
-        model = qVals[i]&0x07;
-        qVals[i] >>= 3;
-        startCol = qVals[i]&0x1ff;
-        qVals[i] >>= 9;
-        length = qVals[i]&0x1ff;
-        handleRL(&img, palette[model], row, startCol, length);
+        if (row<0 || row>=height)
+            continue;
+        span.row = row;
+        span.color = palette[QVAL_MODEL(qval)];
+        span.startCol = QVAL_BEGIN(format, qval);
+        span.len = QVAL_LEN(format, qval);
+        if (span.startCol>=width)
+            continue;
+        if (span.startCol+span.len>width)
+            span.len = width-span.startCol;
+        spanList.append(span);
     }
-    if (m_mode&0x04)
-        emit image(img, true);
-    else
-        emit image(img, false);
+    emit spans(spanList, width, height, m_mode&0x04 ? true : false);
 
     return 0;
 }
 
+// Frames from firmware that stamps them have their capture time (device hal_us) after
+// the data.
+void Renderer::emitCapture(void *arg)
+{
+    qint64 time;
+
+    if (arg && Chirp::getType(arg)==CRP_UINT32 && m_chirp->hostTime(*(uint32_t *)arg, &time))
+        emit capture(time);
+}
+
 int Renderer::render(uint32_t type, void *args[])
 {
     // choose fourcc for representing formats fourcc.org
     if (type==FOURCC('B','A','8','1'))
+    {
+        emitCapture(args[4]);
         return renderBA81(*(uint16_t *)args[0], *(uint16_t *)args[1], *(uint32_t *)args[2], (uint8_t *)args[3]);
-    else if (type==FOURCC('V', 'I', 'S', 'U'))    // contains visualization data
-        return renderVISU(*(uint32_t *)args[0], (int16_t *)args[1]);
-    else if (type==FOURCC('C','C','Q','1'))
-        return renderCCQ1(*(uint16_t *)args[0], *(uint16_t *)args[1], *(uint32_t *)args[2], (uint32_t *)args[3]);
+    }
+    else if (type==FOURCC('C','C','B','2'))
+    {
+        emitCapture(args[2]);
+        // frames that come before a key frame can't be decoded, keep showing what we have
+        if (br_decode(&m_records, (uint16_t *)args[1], *(uint32_t *)args[0])<0)
+            return -1;
+        if (m_log.isOpen())
+            logBlobs(m_records.width, m_records.height, m_records.flags, m_records.numBlobs, m_records.blobs);
+        m_frame++;
+        return renderCCB2(m_records.width, m_records.height, m_records.flags, m_records.numBlobs, m_records.blobs);
+    }
+    else if (type==QVAL_CCQ1 || type==QVAL_CCQ2)
+    {
+        emitCapture(args[4]);
+        // log chunk types are the same fourccs
+        if (m_log.isOpen())
+            m_log.write(type, m_frame, *(uint16_t *)args[0], *(uint16_t *)args[1], args[3], *(uint32_t *)args[2]*sizeof(uint32_t));
+        m_frame++;
+        return renderCCQ(type, *(uint16_t *)args[0], *(uint16_t *)args[1], *(uint32_t *)args[2], (uint32_t *)args[3]);
+    }
     // format not recognized
     return -1;
 }
@@ -2,18 +2,36 @@
 #define RENDERER_H
 #include <QObject>
 #include <QImage>
+#include <QVector>
+#include <QMetaType>
 #include "blobs.h"
+#include "datalog.h"
 
 #define LINE_COLOR 0xFF00FF2F   // bright green
+#define RD_SPANS_RESERVE 0x1000
+
+// one run of overlay color, in overlay (not background) coordinates
+struct RLSpan
+{
+    uint16_t row;
+    uint16_t startCol;
+    uint16_t len;
+    uint32_t color; // ARGB
+};
+
+typedef QVector<RLSpan> RLSpans;
+Q_DECLARE_METATYPE(RLSpans)
 
 class VideoWidget;
+class ImagePool;
+class ChirpMon;
 
 class Renderer : public QObject
 {
     Q_OBJECT
 
 public:
-    Renderer(VideoWidget *video);
+    Renderer(VideoWidget *video, ChirpMon *chirp);
     ~Renderer();
 
     int render(uint32_t type, void *args[]);
@@ -26,25 +44,40 @@ public:
         m_mode = mode;
     }
 
+    // log every frame (raw frames, q-vals and blobs) to a binary log file
+    int startLog(const QString &filename)
+    {
+        return m_log.open(filename);
+    }
+    void stopLog()
+    {
+        m_log.close();
+    }
+
     Blobs m_blobs;
 
 signals:
+    // time (ChirpMon::time) the frame of the next image or spans was captured
+    void capture(qint64 time);
     void image(QImage image, bool blend);
+    void spans(RLSpans spans, int width, int height, bool blend);
 
 private:
+    void emitCapture(void *arg);
     inline void interpolateBayer(unsigned int width, unsigned int x, unsigned int y, unsigned char *pixel, unsigned int &r, unsigned int &g, unsigned int &b);
 
     int renderBA81(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame);	
-    //int renderVISU(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame, uint32_t cc_num, int16_t* c_components);
-    int renderVISU(uint32_t cc_num, int16_t* c_components);
-    int renderCCQ1(uint16_t width, uint16_t height, uint32_t numVals, uint32_t *qVals);
-    int renderCCB1(uint16_t width, uint16_t height, uint16_t numBlobs, uint16_t *blobs);
+    int renderCCQ(uint32_t format, uint16_t width, uint16_t height, uint32_t numVals, uint32_t *qVals);
+    int renderCCB2(uint16_t width, uint16_t height, uint16_t flags, uint16_t numBlobs, const BrBlob *blobs);
+    void logBlobs(uint16_t width, uint16_t height, uint16_t flags, uint16_t numBlobs, const BrBlob *blobs);
 
     int renderBA81Filter(uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame);
 
-    void handleRL(QImage *image, uint color, int row, int startCol, int len);
-
     VideoWidget *m_video;
+    ChirpMon *m_chirp;
+    ImagePool *m_pool;
+    RLSpans m_spans[2];
+    int m_spanIndex;
 
     // experimental
     int16_t m_hmin;
@@ -59,6 +92,14 @@ private:
 
     uint8_t *m_lut;
     uint32_t m_mode;
+
+    DataLog m_log;
+    uint32_t m_frame;
+    // CCB2 records from the device, and the ones we log, all key frames so a log can be
+    // read from anywhere
+    BrDecoder m_records;
+    BrEncoder m_logRecords;
+    uint16_t m_logWords[BR_MAX_WORDS];
 };
 
 #endif // RENDERER_H
@@ -0,0 +1,104 @@
+"""Reader for pixymon data logs (see datalog.h).
+
+    for chunk in pxlog.read('frames.pxl'):
+        print(chunk.type, chunk.frame, chunk.timestamp)
+
+BA81 data is a height x width array of uint8, CCQ1 and CCQ2 data is an array
+of uint32 q-vals (see qval.h), and CCB2 data, in version 2 logs, is a list of
+Blob records (see blobrec.h), or None for a delta that doesn't follow the frame
+before it.  BLOB data, in version 1 logs, is a list of (model, left, right, top,
+bottom, angle) tuples.  Arrays are numpy arrays that reference the file mapping when numpy is
+available, otherwise plain bytes/array objects.
+"""
+
+import array
+import mmap
+import struct
+import sys
+from collections import namedtuple
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+MAGIC = 0x474c5850
+VERSION = 2
+ALIGN = 8
+HEADER = struct.Struct('<IHHIIQ')
+CHUNK = struct.Struct('<IIQIHH')
+BLOB = struct.Struct('<HHHHHh')
+CCB2_HEADER = struct.Struct('<HHHHHH')
+CCB2_RECORD = struct.Struct('<HHHHHHHhI')
+CCB2_KEY = 0x0001
+
+Chunk = namedtuple('Chunk', 'type timestamp frame width height data')
+Blob = namedtuple('Blob', 'model x y left right top bottom angle area')
+
+
+def _records(data, prev):
+    """prev is the (frame, blobs) of the last CCB2 chunk, for deltas."""
+    version, flags, frame, n, width, height = CCB2_HEADER.unpack_from(data, 0)
+    if version != 1:
+        return None
+    offset = CCB2_HEADER.size
+    masks = struct.unpack_from('<%dH' % ((n + 15) // 16), data, offset)
+    offset += 2 * len(masks)
+    if not flags & CCB2_KEY and (prev is None or prev[1] is None or frame != (prev[0] + 1) & 0xffff):
+        return None
+    blobs = []
+    for i in range(n):
+        if masks[i >> 4] & (1 << (i & 0x0f)):
+            blobs.append(prev[1][i])
+        else:
+            blobs.append(Blob._make(CCB2_RECORD.unpack_from(data, offset)))
+            offset += CCB2_RECORD.size
+    return blobs
+
+
+def _decode(version, type, width, height, data):
+    if type == 'BA81':
+        if numpy is not None:
+            return numpy.frombuffer(data, numpy.uint8).reshape(height, width)
+        return bytes(data)
+    if type in ('CCQ1', 'CCQ2'):
+        if numpy is not None:
+            return numpy.frombuffer(data, '<u4')
+        return array.array('I', bytes(data))
+    if type == 'BLOB' and version == 1:
+        return [BLOB.unpack_from(data, i) for i in range(0, len(data) - BLOB.size + 1, BLOB.size)]
+    return bytes(data)
+
+
+def read(filename):
+    """Yields the chunks of a log in order."""
+    with open(filename, 'rb') as f:
+        m = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        view = memoryview(m)
+        magic, version, headerLen, chunkLen, _, startTime = HEADER.unpack_from(m, 0)
+        if magic != MAGIC:
+            raise ValueError('%s is not a pixy log' % filename)
+        if version < 1 or version > VERSION:
+            raise ValueError('%s is a version %u log' % (filename, version))
+        offset = headerLen
+        prev = None
+        while offset + chunkLen <= len(m):
+            type, length, timestamp, frame, width, height = CHUNK.unpack_from(m, offset)
+            if type == 0:
+                break
+            offset += chunkLen
+            if offset + length > len(m):
+                break
+            type = struct.pack('<I', type).decode('ascii')
+            if type == 'CCB2' and version >= 2:
+                data = _records(view[offset:offset + length], prev)
+                prev = (CCB2_HEADER.unpack_from(m, offset)[2], data)
+            else:
+                data = _decode(version, type, width, height, view[offset:offset + length])
+            yield Chunk(type, timestamp, frame, width, height, data)
+            offset += (length + ALIGN - 1) & ~(ALIGN - 1)
+
+
+if __name__ == '__main__':
+    for chunk in read(sys.argv[1]):
+        print('%s frame %u time %u %ux%u' % (chunk.type, chunk.frame, chunk.timestamp, chunk.width, chunk.height))
@@ -1,13 +1,45 @@
 #include <QTimer>
 #include <QPainter>
-#include <QDebug>
+#include <QElapsedTimer>
 #include "mainwindow.h"
 #include "videowidget.h"
 #include "console.h"
+#include "chirpmon.h"
 // experimental
 #include "interpreter.h"
 #include "renderer.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VW_SSE2
+
+// Blend 4 ARGB foreground pixels f (alpha in a) onto 4 background pixels b.
+// The weights (alpha, 0x100-alpha) are interleaved with the (f, b) channels, so one madd
+// per pixel gives alpha*f + (0x100-alpha)*b for all 4 channels in 32 bits.
+static inline __m128i blend4(__m128i b, __m128i f, __m128i a)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i w, lo, hi, p0, p1, p2, p3;
+
+    w = _mm_or_si128(a, _mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(0x100), a), 16));
+    lo = _mm_unpacklo_epi8(f, b);
+    hi = _mm_unpackhi_epi8(f, b);
+    p0 = _mm_srli_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), _mm_shuffle_epi32(w, 0x00)), 8);
+    p1 = _mm_srli_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), _mm_shuffle_epi32(w, 0x55)), 8);
+    p2 = _mm_srli_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), _mm_shuffle_epi32(w, 0xaa)), 8);
+    p3 = _mm_srli_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), _mm_shuffle_epi32(w, 0xff)), 8);
+    b = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+    return _mm_and_si128(b, _mm_set1_epi32(0x00ffffff));
+}
+#endif
+
+// first background coordinate that maps (nearest neighbor) to overlay coordinate c or beyond
+static inline int mapStart(int c, int overlaySize, int backgroundSize)
+{
+    int n = 2*backgroundSize*c - overlaySize;
+    return n<=0 ? 0 : (n + 2*overlaySize - 1)/(2*overlaySize);
+}
+
 VideoWidget::VideoWidget(MainWindow *main) : QWidget((QWidget *)main)
 {
     m_main = main;
@@ -17,7 +49,13 @@ VideoWidget::VideoWidget(MainWindow *main) : QWidget((QWidget *)main)
     m_scale = 1.0;
     m_drag = false;
     m_selection = false;
-    m_pm = new QPixmap;
+    m_xmapWidth = 0;
+    m_guiTime = 0;
+    m_frames = 0;
+    m_capture = 0;
+    m_backgroundCapture = 0;
+    m_latencyIndex = 0;
+    m_showLatency = true;
 
     // set size policy--- preferred aspect ratio
     QSizePolicy policy = sizePolicy();
@@ -29,30 +67,99 @@ VideoWidget::VideoWidget(MainWindow *main) : QWidget((QWidget *)main)
 
 VideoWidget::~VideoWidget()
 {
-    delete m_pm;
     if (m_background)
         delete m_background;
 }
 
 
 
+void VideoWidget::handleCapture(qint64 time)
+{
+    m_capture = time;
+}
+
+void VideoWidget::showLatency(bool show)
+{
+    m_showLatency = show;
+    m_latency.clear();
+    m_latencyIndex = 0;
+    repaint();
+}
+
 void VideoWidget::handleImage(QImage image, bool bl)
 {
+    QElapsedTimer timer;
+
+    timer.start();
     if (bl)
+    {
         blend(&image);
+        m_pool.release(image);
+    }
     else
     {
         if (m_background==NULL)
             m_background = new QImage;
         else
         {
-            *m_pm = QPixmap::fromImage(*m_background);
+            // the finished background (with overlays) becomes the displayed frame, and the
+            // frame it replaces goes back to the pool
+            m_pool.release(m_display);
+            m_display = *m_background;
+            if (m_backgroundCapture)
+            {
+                if (m_latency.size()<VW_LATENCY_FRAMES)
+                    m_latency.append(0);
+                m_latency[m_latencyIndex] = (ChirpMon::time()-m_backgroundCapture)/1000;
+                m_latencyIndex = (m_latencyIndex+1)%VW_LATENCY_FRAMES;
+            }
             repaint();
         }
 
         *m_background = image;
+        // the capture signal comes just before its image
+        m_backgroundCapture = m_capture;
+        m_capture = 0;
+        m_frames++;
     }
     //callPaintCallbacks(&image);
+
+    m_guiTime += timer.nsecsElapsed();
+}
+
+QString VideoWidget::takeStats()
+{
+    QString stats;
+
+    if (m_frames)
+        stats = QString("gui time/frame %1 us, image allocs %2, bytes copied/frame %3 (%4 frames)\n").
+                arg(m_guiTime/(1000*m_frames)).arg(m_pool.takeAllocs()).arg(m_pool.takeCopied()/m_frames).arg(m_frames);
+    else
+        stats = "no frames.\n";
+    m_guiTime = 0;
+    m_frames = 0;
+    return stats;
+}
+
+void VideoWidget::handleSpans(RLSpans spans, int width, int height, bool bl)
+{
+    QElapsedTimer timer;
+
+    if (bl)
+    {
+        timer.start();
+        blend(spans, width, height);
+        m_guiTime += timer.nsecsElapsed();
+    }
+    else
+    {
+        // no background to blend onto, so the spans are the image
+        QImage image = m_pool.acquire(width, height, QImage::Format_RGB32);
+        image.fill(0);
+        for (int i=0; i<spans.size(); i++)
+            blendSpan((unsigned int *)image.scanLine(spans[i].row)+spans[i].startCol, spans[i].color|0xff000000, spans[i].len);
+        handleImage(image, false);
+    }
 }
 
 void VideoWidget::paintEvent(QPaintEvent *event)
@@ -62,9 +169,13 @@ void VideoWidget::paintEvent(QPaintEvent *event)
     int width = this->width();
     int height = this->height();
     float war = (float)width/(float)height; // widget aspect ratio
-    float pmar = (float)m_pm->width()/(float)m_pm->height();
+    float pmar;
     QPainter p(this);
 
+    if (m_display.isNull())
+        return;
+    pmar = (float)m_display.width()/(float)m_display.height();
+
     if (war>pmar)
     {   // width is greater than video
         width = this->height()*pmar;
@@ -78,14 +189,41 @@ void VideoWidget::paintEvent(QPaintEvent *event)
         m_xOffset = 0;
     }
 
-    m_scale = (float)width/m_pm->width();
+    m_scale = (float)width/m_display.width();
     p.save();
     p.translate(m_xOffset, m_yOffset);
     p.scale(m_scale, m_scale);
-    p.drawPixmap(0, 0, *m_pm);
+    p.drawImage(0, 0, m_display);
     if (m_selection)
         p.drawRect((m_x0-m_xOffset)/m_scale+.5, (m_y0-m_yOffset)/m_scale+.5, m_sbWidth/m_scale+.5, m_sbHeight/m_scale+.5);
     p.restore();
+    if (m_showLatency && m_latency.size())
+        paintLatency(&p);
+}
+
+// histogram of the capture-to-display latencies in the top left corner, bins of
+// VW_LATENCY_BIN ms, tallest bin full height
+void VideoWidget::paintLatency(QPainter *p)
+{
+    const int binWidth = 6, height = 40, margin = 4;
+    int i, bin, max, sum, hist[VW_LATENCY_BINS] = {0};
+    QRect r(m_xOffset+margin, m_yOffset+margin, VW_LATENCY_BINS*binWidth+2*margin, height+20+2*margin);
+
+    for (i=0, sum=0; i<m_latency.size(); i++)
+    {
+        bin = m_latency[i]/VW_LATENCY_BIN;
+        hist[bin<VW_LATENCY_BINS ? bin : VW_LATENCY_BINS-1]++;
+        sum += m_latency[i];
+    }
+    for (i=0, max=1; i<VW_LATENCY_BINS; i++)
+        max = qMax(max, hist[i]);
+
+    p->fillRect(r, QColor(0, 0, 0, 0xa0));
+    for (i=0; i<VW_LATENCY_BINS; i++)
+        p->fillRect(r.left()+margin+i*binWidth, r.top()+margin+height-hist[i]*height/max, binWidth-1, hist[i]*height/max,
+                    QColor(LINE_COLOR));
+    p->setPen(Qt::white);
+    p->drawText(r.left()+margin, r.bottom()-margin, QString("latency %1 ms").arg(sum/m_latency.size()));
 }
 
 void VideoWidget::callMeMaybe(void (*overlayCallback)(QImage* image))
@@ -164,47 +302,149 @@ void VideoWidget::callPaintCallbacks(QImage* image)
 
 void VideoWidget::blend(QImage *foreground)
 {
-    int i, j;
-    unsigned int *fline, *bline;
-    unsigned int bpixel, fpixel, br, bg, bb, fr, fg, fb;
-    unsigned int ralpha;
-    uint32_t alpha;
+    int i, j, fy, width, height, fwidth, fheight;
+    unsigned int *bline;
+    const unsigned int *fline;
 
-    alpha = 0x80;
-    if (m_background)
-    {
-        if (foreground->width()!=m_background->width() || foreground->height()!=m_background->height())
-            *foreground = foreground->scaled(m_background->width(), m_background->height());
+    if (m_background==NULL || m_background->isNull())
+        return;
+
+    width = m_background->width();
+    height = m_background->height();
+    fwidth = foreground->width();
+    fheight = foreground->height();
 
-        for (i=0; i<foreground->height(); i++)
+    // Composite at the overlay's native resolution by mapping background pixels back to
+    // overlay pixels (nearest neighbor, same as scaled()) instead of making a scaled copy.
+    if (fwidth!=width || fheight!=height)
+    {
+        if (m_xmap.size()!=width || m_xmapWidth!=fwidth)
+        {
+            m_xmap.resize(width);
+            for (j=0; j<width; j++)
+                m_xmap[j] = ((2*j+1)*fwidth)/(2*width);
+            m_xmapWidth = fwidth;
+        }
+        for (i=0; i<height; i++)
         {
-            fline = (unsigned int *)foreground->scanLine(i);
+            fy = ((2*i+1)*fheight)/(2*height);
+            fline = (const unsigned int *)foreground->constScanLine(fy);
             bline = (unsigned int *)m_background->scanLine(i);
-            for (j=0; j<m_background->width(); j++)
-            {
-                bpixel = bline[j];
-                bb = bpixel&0xff;
-                bpixel >>= 8;
-                bg = bpixel&0xff;
-                bpixel >>= 8;
-                br = bpixel&0xff;
-
-                fpixel = fline[j];
-                fb = fpixel&0xff;
-                fpixel >>= 8;
-                fg = fpixel&0xff;
-                fpixel >>= 8;
-                fr = fpixel&0xff;
-                fpixel >>= 8;
-                alpha = fpixel&0xff;
-                ralpha = 0x100 - alpha;
-
-                bb = (alpha*fb + ralpha*bb)>>8;
-                bg = (alpha*fg + ralpha*bg)>>8;
-                br = (alpha*fr + ralpha*br)>>8;
-
-                bline[j] = (br<<16) | (bg<<8) | bb;
-            }
+            blendLine(bline, fline, m_xmap.constData(), width);
+        }
+    }
+    else
+    {
+        for (i=0; i<height; i++)
+        {
+            fline = (const unsigned int *)foreground->constScanLine(i);
+            bline = (unsigned int *)m_background->scanLine(i);
+            blendLine(bline, fline, NULL, width);
         }
     }
 }
+
+// Blend one line of ARGB foreground pixels onto RGB background pixels:
+// b = (alpha*f + (0x100-alpha)*b)>>8 per channel.  If xmap is non-NULL, foreground pixel j
+// is fline[xmap[j]].  Pixels with alpha==0 are left untouched.
+void VideoWidget::blendLine(unsigned int *bline, const unsigned int *fline, const int *xmap, int width)
+{
+    int j;
+    unsigned int bpixel, fpixel, alpha, ralpha;
+
+    j = 0;
+#ifdef VW_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i f, b, a;
+
+    for (; j+4<=width; j+=4)
+    {
+        if (xmap)
+            f = _mm_set_epi32(fline[xmap[j+3]], fline[xmap[j+2]], fline[xmap[j+1]], fline[xmap[j]]);
+        else
+            f = _mm_loadu_si128((const __m128i *)(fline+j));
+        a = _mm_srli_epi32(f, 24);
+        // skip transparent spans, which is most of an overlay
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero))==0xffff)
+            continue;
+        b = _mm_loadu_si128((const __m128i *)(bline+j));
+        _mm_storeu_si128((__m128i *)(bline+j), blend4(b, f, a));
+    }
+#endif
+    for (; j<width; j++)
+    {
+        fpixel = xmap ? fline[xmap[j]] : fline[j];
+        alpha = fpixel>>24;
+        if (alpha==0)
+            continue;
+        ralpha = 0x100 - alpha;
+        bpixel = bline[j];
+
+        bline[j] = ((alpha*((fpixel>>16)&0xff) + ralpha*((bpixel>>16)&0xff))>>8)<<16 |
+                ((alpha*((fpixel>>8)&0xff) + ralpha*((bpixel>>8)&0xff))>>8)<<8 |
+                ((alpha*(fpixel&0xff) + ralpha*(bpixel&0xff))>>8);
+    }
+}
+
+// Blend a run of len pixels of a single ARGB color onto a background line.
+void VideoWidget::blendSpan(unsigned int *bline, unsigned int color, int len)
+{
+    int j;
+    unsigned int bpixel, alpha, ralpha, r, g, b;
+
+    alpha = color>>24;
+    if (alpha==0)
+        return;
+
+    j = 0;
+#ifdef VW_SSE2
+    const __m128i f = _mm_set1_epi32(color);
+    const __m128i a = _mm_set1_epi32(alpha);
+    __m128i bk;
+
+    for (; j+4<=len; j+=4)
+    {
+        bk = _mm_loadu_si128((const __m128i *)(bline+j));
+        _mm_storeu_si128((__m128i *)(bline+j), blend4(bk, f, a));
+    }
+#endif
+    ralpha = 0x100 - alpha;
+    r = alpha*((color>>16)&0xff);
+    g = alpha*((color>>8)&0xff);
+    b = alpha*(color&0xff);
+    for (; j<len; j++)
+    {
+        bpixel = bline[j];
+        bline[j] = ((r + ralpha*((bpixel>>16)&0xff))>>8)<<16 |
+                ((g + ralpha*((bpixel>>8)&0xff))>>8)<<8 |
+                ((b + ralpha*(bpixel&0xff))>>8);
+    }
+}
+
+// Blend run-length spans (in width x height overlay coordinates) onto the background.
+// Cost is proportional to the number of covered pixels, not the overlay area.
+void VideoWidget::blend(const RLSpans &spans, int width, int height)
+{
+    int i, y, y0, y1, x0, x1, bwidth, bheight;
+
+    if (m_background==NULL || m_background->isNull())
+        return;
+
+    bwidth = m_background->width();
+    bheight = m_background->height();
+
+    for (i=0; i<spans.size(); i++)
+    {
+        const RLSpan &span = spans[i];
+        x0 = mapStart(span.startCol, width, bwidth);
+        x1 = mapStart(span.startCol+span.len, width, bwidth);
+        y0 = mapStart(span.row, height, bheight);
+        y1 = mapStart(span.row+1, height, bheight);
+        if (x1>bwidth)
+            x1 = bwidth;
+        if (y1>bheight)
+            y1 = bheight;
+        for (y=y0; y<y1; y++)
+            blendSpan((unsigned int *)m_background->scanLine(y)+x0, span.color, x1-x0);
+    }
+}
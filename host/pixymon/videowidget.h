@@ -2,8 +2,14 @@
 #define VIDEOWIDGET_H
 
 #include <QWidget>
+#include <QVector>
+#include "renderer.h"
+#include "imagepool.h"
 
 #define VW_ASPECT_RATIO   ((float)1280/(float)800)
+#define VW_LATENCY_FRAMES 200   // frames in the latency histogram
+#define VW_LATENCY_BIN    10    // ms per bin
+#define VW_LATENCY_BINS   16    // the last bin has everything past the others
 
 // Define the callback used for inside of paint event
 typedef void (*paintCallback)(QImage* image);
@@ -23,6 +29,13 @@ public:
 
     void callMeMaybe(void (*overlayCallback)(QImage* image));
 
+    ImagePool *pool()
+    {
+        return &m_pool;
+    }
+    // GUI thread time and image pool use per frame since the last call ("prof gui")
+    QString takeStats();
+
 protected:
     void paintEvent(QPaintEvent *event);
     virtual int heightForWidth(int w) const;
@@ -37,17 +50,36 @@ signals:
     void selection(int x0, int y0, int width, int height);
 
 public slots:
+    void handleCapture(qint64 time);
     void handleImage(QImage image, bool blend);
+    void handleSpans(RLSpans spans, int width, int height, bool blend);
     void acceptInput(uint type);
+    void showLatency(bool show);
 
 private slots:
 
 private:
     void blend(QImage *foreground);
+    void blend(const RLSpans &spans, int width, int height);
+    static void blendLine(unsigned int *bline, const unsigned int *fline, const int *xmap, int width);
+    static void blendSpan(unsigned int *bline, unsigned int color, int len);
+    void paintLatency(QPainter *p);
 
     QImage *m_background;
-
-    QPixmap *m_pm;
+    QVector<int> m_xmap;
+    int m_xmapWidth;
+    qint64 m_guiTime;           // since takeStats
+    int m_frames;
+
+    // capture-to-display latency of the last VW_LATENCY_FRAMES frames, ms
+    qint64 m_capture;           // of the next background (Renderer::capture)
+    qint64 m_backgroundCapture;
+    QVector<int> m_latency;
+    int m_latencyIndex;
+    bool m_showLatency;
+
+    QImage m_display;
+    ImagePool m_pool;
     MainWindow *m_main;
 
     int m_xOffset;